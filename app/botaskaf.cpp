@@ -15,10 +15,16 @@
 #include "controllers/setup.h"
 #include "controllers/users.h"
 #include "cutelee/botaskafcutelee.h"
+#include "delivery/delivery.h"
 #include "logging.h"
 #include "migrations/m0001_create_users_table.h"
 #include "migrations/m0002_createformstable.h"
 #include "migrations/m0003_createrecipientstable.h"
+#include "migrations/m0004_createsubmissionstable.h"
+#include "migrations/m0005_createoutboxtable.h"
+#include "migrations/m0006_createsuppressionstable.h"
+#include "objects/formtoken.h"
+#include "objects/tokenpool.h"
 #include "settings.h"
 #include "userauthstoresql.h"
 
@@ -79,6 +85,25 @@ bool Botaskaf::init()
         return false;
     }
 
+    // measured only once per process, all application instances share the result
+    static const FormToken::Algorithm tokenAlgorithm = []() {
+        const auto configured = Settings::tokenAlgorithm();
+        return configured == FormToken::Algorithm::Default ? FormToken::fastest(std::chrono::milliseconds{50}) : configured;
+    }();
+    FormToken::setDefaultAlgorithm(tokenAlgorithm);
+    qCInfo(HBNBOTA_CORE) << "Using" << FormToken::name(tokenAlgorithm) << "for contact form tokens by default";
+
+    static const bool hasTokenSecret = []() {
+        const QByteArray secret = Settings::tokenSecret();
+        FormToken::setAppSecret(secret);
+        FormToken::setLegacyDeadline(Settings::legacyTokensUntil());
+        return !secret.isEmpty();
+    }();
+    if (!hasTokenSecret) {
+        qCWarning(HBNBOTA_CORE) << "No" << HBNBOTA_CONF_CORE_TOKENSECRET << "set in section" << HBNBOTA_CONF_CORE
+                                << ", forged contact form tokens are only rejected after loading the form";
+    }
+
     QLockFile dbInitLock{QStandardPaths::writableLocation(QStandardPaths::TempLocation) + u"/botaskaf_db.lock"_s};
     if (dbInitLock.tryLock(std::chrono::milliseconds{1}) && mutex.tryLock()) {
         if (Q_LIKELY(connectDb(u"db"_s))) {
@@ -181,15 +206,25 @@ bool Botaskaf::postFork()
 {
     QMutexLocker locker(&mutex);
 
-    return connectDb();
+    if (Q_UNLIKELY(!connectDb())) {
+        return false;
+    }
+
+    TokenPool::start(Settings::tokenPoolSize());
+
+    return Delivery::start(engine()->config(QStringLiteral(HBNBOTA_CONF_DB)));
 }
 
 bool Botaskaf::connectDb(const QString &conName) const
 {
     const QString dbConName = conName.isEmpty() ? Sql::databaseNameThread() : conName;
+    return Botaskaf::connectDb(engine()->config(QStringLiteral(HBNBOTA_CONF_DB)), dbConName);
+}
+
+bool Botaskaf::connectDb(const QVariantMap &conf, const QString &dbConName)
+{
     qCDebug(HBNBOTA_CORE) << "Establishing database connection" << dbConName;
 
-    const auto conf = engine()->config(QStringLiteral(HBNBOTA_CONF_DB));
     const auto type =
         conf.value(QStringLiteral(HBNBOTA_CONF_DB_TYPE), QStringLiteral(HBNBOTA_CONF_DB_TYPE_DEFVAL)).toString().toUpper();
 
@@ -260,6 +295,9 @@ bool Botaskaf::initializeDb(const QString &conName) const
     new M0001_CreateUsersTable(&mig);
     new M0002_CreateFormsTable(&mig);
     new M0003_CreateRecipientsTable(&mig);
+    new M0004_CreateSubmissionsTable(&mig);
+    new M0005_CreateOutboxTable(&mig);
+    new M0006_CreateSuppressionsTable(&mig);
 
     const QByteArray mode = qgetenv("HBNBOTA_DB_MIGRATION").toLower();
 
@@ -23,6 +23,13 @@ public:
 
     bool postFork() override;
 
+    /*!
+     * \brief Establishes a database connection named \a conName using the database configuration \a conf.
+     *
+     * This is also used by background threads that need their own database connection.
+     */
+    [[nodiscard]] static bool connectDb(const QVariantMap &conf, const QString &conName);
+
 private:
     [[nodiscard]] bool connectDb(const QString &conName = QString()) const;
     [[nodiscard]] bool initializeDb(const QString &conName) const;
@@ -5,13 +5,52 @@
 
 #include "contactform.h"
 
+#include "delivery/delivery.h"
+#include "logging.h"
 #include "objects/error.h"
 #include "objects/form.h"
+#include "objects/formtoken.h"
+#include "objects/proofofwork.h"
+#include "objects/replaycache.h"
+#include "objects/submission.h"
+#include "objects/tokenpool.h"
+#include "settings.h"
+
+#include <Cutelyst/Plugins/Utils/validatoremail.h>
 
 #include <QDateTime>
+#include <QJsonObject>
+
+#include <chrono>
 
 using namespace Qt::Literals::StringLiterals;
 
+// body parameter with the solved proof-of-work challenge, challenge ":" nonce
+#define HBNBOTA_CONTACTFORM_WORK_FIELD u"work"_s
+
+namespace {
+// longer values can not be tokens and are not checked by hasValidToken()
+constexpr qsizetype maxTokenLength{128};
+
+void setErrorResponse(Context *c, const Error &e)
+{
+    c->res()->setJsonObjectBody(e.toJson());
+    c->res()->setStatus(e.status());
+}
+
+// the token field name is part of the form settings, so all submitted values are checked
+bool hasValidToken(Context *c, const QString &uuid)
+{
+    const ParamsMultiMap params = c->req()->bodyParameters();
+    for (auto it = params.cbegin(), end = params.cend(); it != end; ++it) {
+        if (it.value().size() <= maxTokenLength && FormToken::precheck(uuid, it.value().toLatin1())) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
 ContactForm::ContactForm(QObject *parent)
     : Controller{parent}
 {
@@ -19,11 +58,23 @@ ContactForm::ContactForm(QObject *parent)
 
 void ContactForm::base(Context *c, const QString &uuid)
 {
+    // only submit accepts POST, reject forged tokens before the form is loaded from cache or database
+    if (c->req()->isPost() && !hasValidToken(c, uuid)) {
+        qCInfo(HBNBOTA_CORE) << "Rejecting submission for form" << uuid << "from" << c->req()->addressString()
+                             << "because of an invalid token";
+        //: Error message
+        //% "The submission token is invalid or has been expired. Please reload the page and try again."
+        const Error e = Error::create(c, Response::BadRequest, c->qtTrId("hbnbota_error_contactform_invalid_token"));
+        setErrorResponse(c, e);
+        e.toStash(c);
+        return;
+    }
+
     Error e;
     auto f = Form::get(c, e, uuid);
     if (f.isNull()) {
-        c->res()->setJsonObjectBody(e.toJson());
-        c->res()->setStatus(e.status());
+        setErrorResponse(c, e);
+        e.toStash(c);
         return;
     }
 
@@ -38,14 +89,33 @@ void ContactForm::getToken(Context *c)
 
     auto f = Form::fromStash(c);
 
-    const QByteArray token = f.encrypt(QDateTime::currentDateTimeUtc());
+    // pre-created tokens keep the crypto off the request path during bursts
+    QByteArray token = TokenPool::take(f);
+    if (token.isEmpty()) {
+        token = f.encrypt(QDateTime::currentDateTimeUtc());
+    }
     if (token.isEmpty()) {
         //: Error message
         //% "Failed to create token."
         const Error e =
             Error::create(c, Response::InternalServerError, c->qtTrId("hbnbota_error_contactform_failed_create_token"));
-        c->res()->setJsonObjectBody(e.toJson());
-        c->res()->setStatus(e.status());
+        setErrorResponse(c, e);
+        return;
+    }
+
+    if (f.proofOfWork()) {
+        const int difficulty       = ProofOfWork::difficulty(f.uuid());
+        const QByteArray challenge = f.challenge(token, difficulty);
+        if (Q_UNLIKELY(challenge.isEmpty())) {
+            const Error e =
+                Error::create(c, Response::InternalServerError, c->qtTrId("hbnbota_error_contactform_failed_create_token"));
+            setErrorResponse(c, e);
+            return;
+        }
+
+        c->res()->setJsonObjectBody(QJsonObject{{u"token"_s, QString::fromLatin1(token)},
+                                                {u"challenge"_s, QString::fromLatin1(challenge)},
+                                                {u"difficulty"_s, difficulty}});
         return;
     }
 
@@ -53,4 +123,138 @@ void ContactForm::getToken(Context *c)
     c->res()->setBody(token);
 }
 
+void ContactForm::submit(Context *c)
+{
+    if (Error::hasError(c)) {
+        return;
+    }
+
+    if (!c->req()->isPost()) {
+        //: Error message
+        //% "Submissions have to be sent via HTTP POST."
+        setErrorResponse(c,
+                         Error::create(c, Response::MethodNotAllowed, c->qtTrId("hbnbota_error_contactform_post_only")));
+        return;
+    }
+
+    // shed load before doing any real work if the delivery can not keep up
+    if (Delivery::isOverloaded()) {
+        qCWarning(HBNBOTA_CORE) << "Rejecting submission from" << c->req()->addressString()
+                                << "because the delivery is overloaded";
+        c->res()->setHeader("Retry-After"_ba, QByteArray::number(Settings::submitRetryAfter().count()));
+        //: Error message
+        //% "The service is currently overloaded. Please try again later."
+        setErrorResponse(
+            c, Error::create(c, Response::ServiceUnavailable, c->qtTrId("hbnbota_error_contactform_overloaded")));
+        return;
+    }
+
+    const auto f        = Form::fromStash(c);
+    const auto settings = f.settings();
+    const auto fields   = settings.value(u"fields"_s).toMap();
+
+    const QStringList honeypots = settings.value(u"honeypots"_s).toStringList();
+    for (const QString &honeypot : honeypots) {
+        if (!c->req()->bodyParam(honeypot.trimmed()).isEmpty()) {
+            // do not tell bots that we have detected them
+            qCInfo(HBNBOTA_CORE) << "Discarding submission for" << f << "from" << c->req()->addressString()
+                                 << "because honeypot" << honeypot << "has been filled";
+            c->res()->setStatus(Response::Accepted);
+            return;
+        }
+    }
+
+    const QString tokenField  = fields.value(u"time"_s).toMap().value(u"name"_s, u"token"_s).toString();
+    const QByteArray token    = c->req()->bodyParam(tokenField).toLatin1();
+    FormToken::Nonce tokenNonce{};
+    const QDateTime tokenTime = f.decrypt(token, &tokenNonce);
+    const qint64 tokenAge     = tokenTime.isValid() ? tokenTime.msecsTo(QDateTime::currentDateTimeUtc()) : -1;
+    if (tokenAge < FormToken::minAge.count() || tokenAge > FormToken::maxAge.count()) {
+        qCInfo(HBNBOTA_CORE) << "Rejecting submission for" << f << "from" << c->req()->addressString()
+                             << "because of an invalid token";
+        setErrorResponse(c,
+                         Error::create(c, Response::BadRequest, c->qtTrId("hbnbota_error_contactform_invalid_token")));
+        return;
+    }
+
+    if (f.proofOfWork() && !f.verifyWork(token, c->req()->bodyParam(HBNBOTA_CONTACTFORM_WORK_FIELD).toLatin1())) {
+        qCInfo(HBNBOTA_CORE) << "Rejecting submission for" << f << "from" << c->req()->addressString()
+                             << "because of an invalid proof of work";
+        //: Error message
+        //% "The submission could not be verified. Please reload the page and try again."
+        setErrorResponse(c, Error::create(c, Response::BadRequest, c->qtTrId("hbnbota_error_contactform_invalid_work")));
+        return;
+    }
+
+    QVariantHash values;
+    QStringList missing;
+    for (const QString &key : {u"name"_s, u"email"_s, u"phone"_s, u"url"_s, u"subject"_s, u"content"_s, u"policy"_s}) {
+        const auto field   = fields.value(key).toMap();
+        const QString name = field.value(u"name"_s).toString();
+        if (name.isEmpty()) {
+            continue;
+        }
+
+        const QString value = c->req()->bodyParam(name).trimmed();
+        if (value.isEmpty()) {
+            if (field.value(u"required"_s).toBool()) {
+                missing << name;
+            }
+            continue;
+        }
+
+        values.insert(key, value);
+    }
+
+    if (!missing.empty()) {
+        //: Error message, %1 will be replaced by a comma separated list of field names
+        //% "The following required fields are missing: %1"
+        setErrorResponse(c,
+                         Error::create(c,
+                                       Response::BadRequest,
+                                       c->qtTrId("hbnbota_error_contactform_missing_fields").arg(missing.join(u", "))));
+        return;
+    }
+
+    if (const QString email = values.value(u"email"_s).toString(); !email.isEmpty()) {
+        if (!ValidatorEmail::validate(email, ValidatorEmail::RFC5321, ValidatorEmail::AllowIDN)) {
+            //: Error message
+            //% "The sender email address is not valid."
+            setErrorResponse(
+                c, Error::create(c, Response::BadRequest, c->qtTrId("hbnbota_error_contactform_invalid_email")));
+            return;
+        }
+    }
+
+    // checked last, so that the token can be used again after a failed validation
+    if (!ReplayCache::consume(tokenNonce, tokenTime)) {
+        qCInfo(HBNBOTA_CORE) << "Rejecting submission for" << f << "from" << c->req()->addressString()
+                             << "because the token has already been used";
+        //: Error message
+        //% "This form has already been submitted. Please reload the page to send another message."
+        setErrorResponse(c, Error::create(c, Response::BadRequest, c->qtTrId("hbnbota_error_contactform_token_used")));
+        return;
+    }
+
+    Error e;
+    const auto writeStart = std::chrono::steady_clock::now();
+    const auto submission = Submission::create(c, f, e, values);
+    Delivery::reportWriteLatency(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeStart));
+    if (Q_UNLIKELY(submission.isNull())) {
+        // the visitor has to be able to retry with the same token
+        ReplayCache::release(tokenNonce, tokenTime);
+        setErrorResponse(c, e);
+        return;
+    }
+
+    if (f.proofOfWork()) {
+        ProofOfWork::recordSubmission(f.uuid());
+    }
+
+    Delivery::enqueue(submission);
+
+    c->res()->setStatus(Response::Accepted);
+}
+
 #include "moc_contactform.cpp"
@@ -23,6 +23,9 @@ public:
 
     C_ATTR(getToken, :Chained("base") :PathPart("gettoken") :Args(0))
     void getToken(Context *c);
+
+    C_ATTR(submit, :Chained("base") :PathPart("submit") :Args(0))
+    void submit(Context *c);
 };
 
 #endif // HBNBOTA_CONTACTFORM_H
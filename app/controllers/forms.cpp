@@ -5,12 +5,15 @@
 
 #include "forms.h"
 
+#include "delivery/dkimsigner.h"
+#include "delivery/webhooksender.h"
 #include "logging.h"
 #include "objects/error.h"
 #include "objects/form.h"
 #include "objects/menuitem.h"
 #include "objects/recipient.h"
 #include "objects/recipientlist.h"
+#include "objects/suppression.h"
 #include "settings.h"
 
 #include <Cutelyst/Plugins/Utils/Validator>
@@ -23,7 +26,9 @@
 #include <Cutelyst/Plugins/Utils/validatorregularexpression.h>
 #include <Cutelyst/Plugins/Utils/validatorrequired.h>
 #include <Cutelyst/Plugins/Utils/validatorrequiredif.h>
+#include <Cutelyst/Plugins/Utils/validatorrequiredwith.h>
 #include <Cutelyst/Plugins/Utils/validatorrequiredwithout.h>
+#include <Cutelyst/Plugins/Utils/validatorurl.h>
 #include <CutelystForms/forms.h>
 
 using namespace Qt::Literals::StringLiterals;
@@ -77,8 +82,9 @@ void Forms::add(Context *c)
              new ValidatorBoolean(u"formFieldSubjectRequired"_s),
              new ValidatorRegularExpression(u"formFieldContent"_s, fieldNameRegEx),
              new ValidatorBoolean(u"formFieldContentRequired"_s),
-             new ValidatorRegularExpression(u"formFieldPolicyRequired"_s, fieldNameRegEx),
+             new ValidatorRegularExpression(u"formFieldPolicy"_s, fieldNameRegEx),
              new ValidatorBoolean(u"formFieldPolicyRequired"_s),
+             new ValidatorRegularExpression(u"formFieldTime"_s, fieldNameRegEx),
              new ValidatorRegularExpression(u"honeypots"_s, QRegularExpression{uR"(^[A-Za-z][A-Za-z0-9_:.,-]*$)"_s}),
              new ValidatorRequired(u"senderType"_s),
              new ValidatorIn(u"senderType"_s, Settings::allowedSenderTypes()),
@@ -90,16 +96,52 @@ void Forms::add(Context *c)
              new ValidatorRequiredIf(u"smtpEncryption"_s, u"senderType"_s, {u"SMTP"_s}),
              new ValidatorIn(u"smtpEncryption"_s, Settings::allowedSmtpEncryption()),
              new ValidatorRequiredIf(u"smtpAuthentication"_s, u"senderType"_s, {u"SMTP"_s}),
-             new ValidatorIn(u"smtpAuthentication"_s, Settings::allowedSmtpAuthMethods())});
+             new ValidatorIn(u"smtpAuthentication"_s, Settings::allowedSmtpAuthMethods()),
+             new ValidatorRegularExpression(u"maildirFolder"_s, QRegularExpression{uR"(^[A-Za-z0-9][A-Za-z0-9_.-]*$)"_s}),
+             new ValidatorRequiredIf(u"webhookUrl"_s, u"senderType"_s, {u"Webhook"_s}),
+             new ValidatorUrl(u"webhookUrl"_s, ValidatorUrl::WebsiteOnly),
+             new ValidatorBetween(u"webhookBatchSize"_s, QMetaType::Int, 1, 100),
+             new ValidatorBetween(u"rateLimit"_s, QMetaType::Double, 0, 10'000),
+             new ValidatorBetween(u"maxSessions"_s, QMetaType::Int, 0, 1'000),
+             new ValidatorBetween(u"deliveryWeight"_s, QMetaType::Int, 1, Form::maxDeliveryWeight),
+             new ValidatorBetween(u"digestInterval"_s, QMetaType::Int, 0, 10'080),
+             new ValidatorIn(u"tokenAlgorithm"_s, Settings::allowedTokenAlgorithms()),
+             new ValidatorBoolean(u"tokenProofOfWork"_s),
+             new ValidatorDomain(u"dkimDomain"_s),
+             new ValidatorRegularExpression(u"dkimSelector"_s, QRegularExpression{uR"(^[A-Za-z0-9][A-Za-z0-9_.-]*$)"_s}),
+             new ValidatorRequiredWith(u"dkimSelector"_s, {u"dkimKey"_s}),
+             new ValidatorRequiredWith(u"dkimKey"_s, {u"dkimSelector"_s})});
         vr = v.validate(c, Validator::FillStashOnError | Validator::BodyParamsOnly);
         if (vr) {
-            Error e;
-            auto contactForm = Form::create(c, e, vr.values());
-            if (contactForm.isValid()) {
-                c->res()->redirect(c->uriFor(u"/forms"_s));
-                return;
-            } else {
-                e.toStash(c);
+            if (const QString dkimKey = vr.value(u"dkimKey"_s).toString();
+                !dkimKey.isEmpty() && !DkimSigner::checkKey(dkimKey.toLatin1())) {
+                //: Form field error message
+                //% "Only unencrypted RSA (at least 1024 bits) and Ed25519 keys in PKCS #8 PEM format are supported."
+                vr.addError(u"dkimKey"_s, c->qtTrId("hbnbota_form_sender_dkimkey_invalid"));
+            }
+
+            if (const QString webhookUrl = vr.value(u"webhookUrl"_s).toString();
+                !webhookUrl.isEmpty() && !WebhookSender::isAllowedUrl(QUrl{webhookUrl})) {
+                //: Form field error message
+                //% "The webhook URL has to use https and must not point to a local or private host."
+                vr.addError(u"webhookUrl"_s, c->qtTrId("hbnbota_form_sender_webhookurl_not_allowed"));
+            }
+
+            if (vr) {
+                QVariantHash values = vr.values();
+                // a form owner could take most of the delivery threads with the highest weight
+                if (!User::fromStash(c).isAdmin()) {
+                    values.remove(u"deliveryWeight"_s);
+                }
+
+                Error e;
+                auto contactForm = Form::create(c, e, values);
+                if (contactForm.isValid()) {
+                    c->res()->redirect(c->uriFor(u"/forms"_s));
+                    return;
+                } else {
+                    e.toStash(c);
+                }
             }
         }
     }
@@ -108,13 +150,18 @@ void Forms::add(Context *c)
     const QString smtpEncryption = c->req()->isPost() ? c->req()->bodyParam(u"smtpEncryption"_s).trimmed() : u"TLS"_s;
     const QString smtpAuthentication =
         c->req()->isPost() ? c->req()->bodyParam(u"smtpAuthentication"_s).trimmed() : u"PLAIN"_s;
+    const QString tokenAlgorithm = c->req()->isPost() ? c->req()->bodyParam(u"tokenAlgorithm"_s).trimmed() : u"auto"_s;
 
     auto form            = CutelystForms::Forms::getForm(u"forms/add.qml"_s, c, CutelystForms::Forms::DoNotFillContext);
+    form->fieldsetById(u"addFormGeneral"_s)
+        ->fieldById(u"tokenAlgorithm"_s)
+        ->appendOptions(Settings::supportedTokenAlgorithms(c, tokenAlgorithm));
     auto addFormSenderFs = form->fieldsetById(u"addFormSender"_s);
     addFormSenderFs->fieldById(u"senderType"_s)->appendOptions(Settings::supportedSenderTypes(c, senderType));
     addFormSenderFs->fieldById(u"smtpEncryption"_s)->appendOptions(Settings::supportedSmtpEncryption(c, smtpEncryption));
     addFormSenderFs->fieldById(u"smtpAuthentication"_s)
         ->appendOptions(Settings::supportedSmtpAuthMethods(c, smtpAuthentication));
+    form->fieldsetById(u"addFormAdmin"_s)->fieldById(u"deliveryWeight"_s)->setProperty("max", Form::maxDeliveryWeight);
 
     if (!vr || Error::hasError(c)) {
         form->setErrors(vr.errors());
@@ -193,6 +240,11 @@ void Forms::recipients(Context *c)
     pageMenu.emplace_back(u"recipientsMenuAdd"_s,
                           c->qtTrId("hbnbota_recipientsmenu_add"),
                           currentForm.urls().value(u"addRecipient"_s).toUrl());
+    //: Page menu entry
+    //% "Suppressed addresses"
+    pageMenu.emplace_back(u"recipientsMenuSuppressions"_s,
+                          c->qtTrId("hbnbota_recipientsmenu_suppressions"),
+                          currentForm.urls().value(u"suppressions"_s).toUrl());
 
     c->stash({{u"template"_s, u"forms/recipients/index.html"_s},
               //: Site title
@@ -218,7 +270,12 @@ void Forms::addRecipient(Context *c)
                             new ValidatorMax(u"replyToName"_s, QMetaType::QString, 40),
                             new ValidatorRequired(u"subject"_s),
                             new ValidatorRequiredWithout(u"text"_s, {u"html"_s}),
-                            new ValidatorRequiredWithout(u"html"_s, {u"text"_s})});
+                            new ValidatorRequiredWithout(u"html"_s, {u"text"_s}),
+                            new ValidatorIn(u"routeField"_s, Settings::allowedRoutingFields()),
+                            new ValidatorRequiredWith(u"routeOperator"_s, {u"routeField"_s}),
+                            new ValidatorIn(u"routeOperator"_s, Settings::allowedRoutingOperators()),
+                            new ValidatorRequiredWith(u"routeValue"_s, {u"routeField"_s}),
+                            new ValidatorMax(u"routeValue"_s, QMetaType::QString, 255)});
 
         vr = v.validate(c, Validator::FillStashOnError | Validator::BodyParamsOnly);
         if (vr) {
@@ -241,20 +298,27 @@ void Forms::addRecipient(Context *c)
             }
 
             if (vr) {
-                const auto form = Form::fromStash(c);
+                auto form = Form::fromStash(c);
                 Error e;
                 auto recipient = Recipient::create(c, form, e, vr.values());
                 if (recipient.isValid()) {
                     c->res()->redirect(form.urls().value(u"recipients"_s).toUrl());
                     return;
-                } else {
-                    e.toStash(c);
                 }
+                e.toStash(c);
             }
         }
     }
 
+    const QString routeField    = c->req()->isPost() ? c->req()->bodyParam(u"routeField"_s) : QString();
+    const QString routeOperator = c->req()->isPost() ? c->req()->bodyParam(u"routeOperator"_s) : u"contains"_s;
+
     auto form = CutelystForms::Forms::getForm(u"forms/recipients/add.qml"_s, c, CutelystForms::Forms::DoNotFillContext);
+    auto addRecipientRoutingFs = form->fieldsetById(u"addRecipientRouting"_s);
+    addRecipientRoutingFs->fieldById(u"routeField"_s)->appendOptions(Settings::supportedRoutingFields(c, routeField));
+    addRecipientRoutingFs->fieldById(u"routeOperator"_s)
+        ->appendOptions(Settings::supportedRoutingOperators(c, routeOperator));
+
     if (!vr || Error::hasError(c)) {
         form->setErrors(vr.errors());
         form->setValues(c->req()->bodyParameters());
@@ -267,6 +331,77 @@ void Forms::addRecipient(Context *c)
               {u"form"_s, QVariant::fromValue<CutelystForms::Form *>(form)}});
 }
 
+void Forms::suppressions(Context *c)
+{
+    if (Error::hasError(c)) {
+        return;
+    }
+
+    const auto currentForm = Form::fromStash(c);
+
+    ValidatorResult vr;
+    if (c->req()->isPost()) {
+        if (const QString removeId = c->req()->bodyParam(u"remove"_s); !removeId.isEmpty()) {
+            bool ok       = false;
+            const auto id = Suppression::toDbId(removeId, &ok);
+            if (Q_UNLIKELY(!ok)) {
+                //: Error message
+                //% "The provided suppression ID is not a valid integer."
+                Error::toStash(c, Response::BadRequest, c->qtTrId("hbnbota_error_invalid_suppression_id"));
+            } else {
+                Error e;
+                if (Suppression::remove(c, currentForm, e, id)) {
+                    c->res()->redirect(currentForm.urls().value(u"suppressions"_s).toUrl());
+                    return;
+                }
+                e.toStash(c);
+            }
+        } else {
+            static Validator v({new ValidatorRequired(u"email"_s),
+                                new ValidatorEmail(u"email"_s),
+                                new ValidatorMax(u"reason"_s, QMetaType::QString, 255)});
+
+            vr = v.validate(c, Validator::FillStashOnError | Validator::BodyParamsOnly);
+            if (vr) {
+                Error e;
+                auto suppression = Suppression::create(c, currentForm, e, vr.values());
+                if (suppression.isValid()) {
+                    c->res()->redirect(currentForm.urls().value(u"suppressions"_s).toUrl());
+                    return;
+                }
+                e.toStash(c);
+            }
+        }
+    }
+
+    Error e;
+    const auto suppressionList = Suppression::list(c, currentForm, e);
+    if (e) {
+        e.toStash(c);
+    }
+
+    auto form = CutelystForms::Forms::getForm(
+        u"forms/recipients/suppression.qml"_s, c, CutelystForms::Forms::DoNotFillContext);
+    if (!vr || Error::hasError(c)) {
+        form->setErrors(vr.errors());
+        form->setValues(c->req()->bodyParameters());
+    }
+
+    MenuItemList pageMenu;
+    pageMenu.emplace_back(u"suppressionsMenuBack"_s,
+                          c->qtTrId("hbnbota_general_back"),
+                          currentForm.urls().value(u"recipients"_s).toUrl());
+
+    c->stash({{u"template"_s, u"forms/recipients/suppressions.html"_s},
+              //: Site title
+              //% "Suppressed addresses of contact form"
+              {u"site_title"_s, c->qtTrId("hbnbota_site_title_forms_recipients_suppressions")},
+              {u"page_menu"_s, QVariant::fromValue<MenuItemList>(pageMenu)},
+              {u"suppressions"_s, QVariant::fromValue<QList<Suppression>>(suppressionList)},
+              {u"suppressions_labels"_s, QVariant::fromValue<QMap<QString, QString>>(Suppression::labels(c))},
+              {u"form"_s, QVariant::fromValue<CutelystForms::Form *>(form)}});
+}
+
 void Forms::baseRecipient(Context *c, const QString &id)
 {
     Q_UNUSED(c)
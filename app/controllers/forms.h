@@ -38,6 +38,9 @@ public:
     C_ATTR(addRecipient, :Chained("baseForm") :PathPart("recipients/add") :Args(0))
     void addRecipient(Context *c);
 
+    C_ATTR(suppressions, :Chained("baseForm") :PathPart("recipients/suppressions") :Args(0))
+    void suppressions(Context *c);
+
     C_ATTR(baseRecipient, :Chained("baseForm") :PathPart("recipients") :CaptureArgs(1))
     void baseRecipient(Context *c, const QString &id);
 
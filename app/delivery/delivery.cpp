@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery.h"
+
+#include "deliveryworker.h"
+#include "loadmonitor.h"
+#include "logging.h"
+#include "objects/submission.h"
+#include "settings.h"
+
+#include <QCoreApplication>
+#include <QGlobalStatic>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#if defined(QT_DEBUG)
+Q_LOGGING_CATEGORY(HBNBOTA_DELIVERY, "hbnbota.delivery")
+#else
+Q_LOGGING_CATEGORY(HBNBOTA_DELIVERY, "hbnbota.delivery", QtInfoMsg)
+#endif
+
+using namespace Qt::Literals::StringLiterals;
+
+struct DeliveryVals {
+    QMutex mutex;
+    QList<QThread *> threads;
+    QList<DeliveryWorker *> workers;
+    qsizetype next{0};
+    LoadMonitor load;
+};
+
+Q_GLOBAL_STATIC(DeliveryVals, dlv) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+bool Delivery::start(const QVariantMap &dbConfig)
+{
+    QMutexLocker locker(&dlv->mutex);
+
+    if (!dlv->threads.empty()) {
+        return true;
+    }
+
+    const int count = Settings::deliveryWorkers();
+
+    qCDebug(HBNBOTA_DELIVERY) << "Starting" << count << "delivery threads";
+
+    dlv->threads.reserve(count);
+    dlv->workers.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        auto thread = new QThread; // NOLINT(cppcoreguidelines-owning-memory)
+        thread->setObjectName(u"delivery%1"_s.arg(i));
+
+        auto worker = new DeliveryWorker{dbConfig, i, count}; // NOLINT(cppcoreguidelines-owning-memory)
+        worker->moveToThread(thread);
+
+        QObject::connect(thread, &QThread::started, worker, &DeliveryWorker::init);
+        QObject::connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+
+        dlv->threads << thread;
+        dlv->workers << worker;
+    }
+
+    if (auto app = QCoreApplication::instance(); app) {
+        QObject::connect(app, &QCoreApplication::aboutToQuit, app, &Delivery::stop, Qt::DirectConnection);
+    }
+
+    for (QThread *thread : std::as_const(dlv->threads)) {
+        thread->start();
+    }
+
+    return true;
+}
+
+void Delivery::stop()
+{
+    QMutexLocker locker(&dlv->mutex);
+
+    if (dlv->threads.empty()) {
+        return;
+    }
+
+    qCDebug(HBNBOTA_DELIVERY) << "Stopping delivery threads";
+
+    for (QThread *thread : std::as_const(dlv->threads)) {
+        thread->quit();
+    }
+
+    for (QThread *thread : std::as_const(dlv->threads)) {
+        thread->wait();
+        delete thread;
+    }
+
+    dlv->threads.clear();
+    dlv->workers.clear();
+}
+
+bool Delivery::enqueue(const Submission &submission)
+{
+    QMutexLocker locker(&dlv->mutex);
+
+    if (Q_UNLIKELY(dlv->workers.empty())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Can not enqueue" << submission << "for delivery, delivery has not been started";
+        return false;
+    }
+
+    const qsizetype count = dlv->workers.size();
+    for (qsizetype i = 0; i < count; ++i) {
+        auto worker = dlv->workers.at(dlv->next);
+        dlv->next   = (dlv->next + 1) % count;
+        if (worker->enqueue(submission)) {
+            return true;
+        }
+    }
+
+    qCWarning(HBNBOTA_DELIVERY) << "All delivery queues are full, leaving" << submission << "in the outbox";
+
+    return false;
+}
+
+bool Delivery::isOverloaded()
+{
+    const LoadMonitor::Limits limits{
+        Settings::submitMaxLatency(), Settings::submitRetryAfter(), Settings::deliveryHighWaterMark()};
+
+    QMutexLocker locker(&dlv->mutex);
+
+    qsizetype queued = 0;
+    for (const DeliveryWorker *worker : std::as_const(dlv->workers)) {
+        queued += worker->queueSize();
+    }
+
+    return dlv->load.isOverloaded(queued, dlv->workers.size(), limits);
+}
+
+void Delivery::reportWriteLatency(std::chrono::microseconds latency)
+{
+    dlv->load.reportLatency(latency, Settings::submitRetryAfter());
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_DELIVERY_H
+#define HBNBOTA_DELIVERY_H
+
+#include <QVariantMap>
+
+#include <chrono>
+
+class Submission;
+
+/*!
+ * \brief Manages the background threads that send the messages for outbox entries to the recipients.
+ *
+ * The delivery runs outside of the Cutelyst worker threads, so that request handling
+ * never has to wait for a mail server. The number of threads per process is set by
+ * Settings::deliveryWorkers(). Because all entries are stored in the outbox table,
+ * nothing gets lost if a process dies before delivery has been completed.
+ */
+namespace Delivery {
+
+/*!
+ * \brief Starts the delivery threads for this process.
+ *
+ * \a dbConfig is the database configuration section that will be used by the
+ * delivery threads to establish their own database connections. Calling this
+ * more than once per process has no effect.
+ */
+bool start(const QVariantMap &dbConfig);
+
+/*!
+ * \brief Stops the delivery threads and waits for them to finish.
+ */
+void stop();
+
+/*!
+ * \brief Notifies one of the delivery threads about the new outbox entry \a submission and returns immediately.
+ *
+ * The submission is appended to the queue of the next delivery thread. If that queue
+ * is full, the other threads are tried. Returns \c false if the delivery has not been
+ * started or if all queues are full. The entry will then be picked up from the outbox
+ * by the next poll of any delivery thread.
+ */
+bool enqueue(const Submission &submission);
+
+/*!
+ * \brief Returns \c true if new submissions should be rejected.
+ *
+ * This is the case if the delivery queues contain on average more than
+ * Settings::deliveryHighWaterMark() submissions per thread or if the average
+ * latency reported by reportWriteLatency() exceeds Settings::submitMaxLatency().
+ * Latency samples older than Settings::submitRetryAfter() are not taken into account.
+ */
+[[nodiscard]] bool isOverloaded();
+
+/*!
+ * \brief Adds the \a latency of writing a new submission to the database to the moving average.
+ */
+void reportWriteLatency(std::chrono::microseconds latency);
+
+} // namespace Delivery
+
+#endif // HBNBOTA_DELIVERY_H
@@ -0,0 +1,722 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "deliveryworker.h"
+
+#include "botaskaf.h"
+#include "dkimsigner.h"
+#include "logging.h"
+#include "maildirwriter.h"
+#include "mimeassembler.h"
+#include "objects/form.h"
+#include "objects/recipient.h"
+#include "objects/submission.h"
+#include "objects/suppression.h"
+#include "outbox.h"
+#include "relaylimiter.h"
+#include "sendmailsender.h"
+#include "settings.h"
+#include "suppressionlist.h"
+#include "webhooksender.h"
+
+#include <Cutelyst/Plugins/Utils/Sql>
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QSysInfo>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// time a worker has to deliver a leased entry before others can lease it again
+constexpr std::chrono::minutes leaseDuration{5};
+// fallback for entries that are not scheduled in any running process
+constexpr std::chrono::minutes pollInterval{5};
+constexpr int pollBatchSize{20};
+constexpr std::chrono::seconds tickInterval{1};
+// overdue entries found on startup are spread over this time
+constexpr std::chrono::milliseconds resumeSpread{std::chrono::seconds{60}};
+constexpr std::chrono::minutes retryBaseDelay{1};
+constexpr std::chrono::seconds maxRetryDelay{std::chrono::hours{6}};
+
+// exponential backoff with equal jitter: half of the delay is fixed, the other half is random
+std::chrono::seconds retryDelay(int attempts)
+{
+    const int exponent = std::clamp(attempts - 1, 0, 16);
+    const auto delay   = std::min<std::chrono::seconds>(retryBaseDelay * (1 << exponent), maxRetryDelay);
+    const auto half    = delay / 2;
+    return half + std::chrono::seconds{QRandomGenerator::global()->bounded(static_cast<qint64>(half.count()) + 1)};
+}
+} // namespace
+
+DeliveryWorker::DeliveryWorker(const QVariantMap &dbConfig, int index, int count, QObject *parent)
+    : QObject{parent}
+    , m_dbConfig{dbConfig}
+    , m_queueLimit{Settings::deliveryQueueSize()}
+    , m_smtpPool{Settings::smtpPoolSize(), Settings::smtpIdleTimeout()}
+    , m_index{index}
+    , m_count{count}
+{
+}
+
+void DeliveryWorker::init()
+{
+    m_name = u"%1:%2:%3"_s.arg(QSysInfo::machineHostName(),
+                              QString::number(QCoreApplication::applicationPid()),
+                              QThread::currentThread()->objectName());
+
+    m_dbConnected = Botaskaf::connectDb(m_dbConfig, Cutelyst::Sql::databaseNameThread());
+    if (Q_UNLIKELY(!m_dbConnected)) {
+        qCCritical(HBNBOTA_DELIVERY) << "Delivery thread" << m_name << "failed to establish database connection";
+        return;
+    }
+
+    SuppressionList::instance()->refreshIfDue();
+
+    m_webhookSender = new WebhookSender{this};
+
+    resume();
+
+    m_tickTimer = new QTimer{this};
+    m_tickTimer->setInterval(tickInterval);
+    connect(m_tickTimer, &QTimer::timeout, this, &DeliveryWorker::tick);
+    m_tickTimer->start();
+
+    m_throttleTimer = new QTimer{this};
+    m_throttleTimer->setSingleShot(true);
+    connect(m_throttleTimer, &QTimer::timeout, this, &DeliveryWorker::drain);
+
+    m_pollTimer = new QTimer{this};
+    m_pollTimer->setInterval(pollInterval);
+    connect(m_pollTimer, &QTimer::timeout, this, &DeliveryWorker::poll);
+    m_pollTimer->start();
+}
+
+void DeliveryWorker::deliver(const Submission &submission)
+{
+    if (Q_UNLIKELY(!m_dbConnected)) {
+        qCCritical(HBNBOTA_DELIVERY) << "Can not deliver" << submission << "without database connection";
+        return;
+    }
+
+    const Form form = submission.form();
+    if (form.digestInterval() > std::chrono::minutes::zero()) {
+        // held back in the outbox until the digest is due, one tick later to not race the next attempt time
+        const auto due = std::chrono::milliseconds{
+            std::max<qint64>(QDateTime::currentDateTimeUtc().msecsTo(form.nextDigest(submission.created())), 0)};
+        m_retryWheel.schedule(submission.id(), TimerWheel::clock::now() + due + tickInterval);
+        return;
+    }
+
+    if (!Outbox::lease(submission.id(), m_name, leaseDuration)) {
+        qCDebug(HBNBOTA_DELIVERY) << "Can not lease" << submission << "for" << m_name;
+        return;
+    }
+
+    Outbox::Entry entry{submission, {}, m_name, 1};
+    process(entry);
+}
+
+bool DeliveryWorker::enqueue(const Submission &submission)
+{
+    QMutexLocker locker(&m_queueMutex);
+
+    if (m_queue.size() >= m_queueLimit) {
+        return false;
+    }
+
+    m_queue.push(submission.form().id(), submission, submission.form().deliveryWeight());
+    m_queueSize.store(m_queue.size(), std::memory_order_relaxed);
+
+    if (!m_drainPending) {
+        m_drainPending = true;
+        QMetaObject::invokeMethod(this, &DeliveryWorker::drain, Qt::QueuedConnection);
+    }
+
+    return true;
+}
+
+qsizetype DeliveryWorker::queueSize() const noexcept
+{
+    return m_queueSize.load(std::memory_order_relaxed);
+}
+
+void DeliveryWorker::drain()
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_drainPending = false;
+
+    if (m_queue.isEmpty()) {
+        return;
+    }
+
+    // skip forms whose mail server is throttled and remember when the first one is available again
+    auto wait       = std::chrono::milliseconds::max();
+    const auto next = m_queue.pop([&wait](const Submission &s) {
+        const Form form = s.form();
+        const auto d    = RelayLimiter::instance()->delay(SmtpClient::Config::fromForm(form).relay(),
+                                                       RelayLimiter::Limits::fromForm(form));
+        if (d > std::chrono::milliseconds::zero()) {
+            wait = std::min(wait, d);
+            return false;
+        }
+        return true;
+    });
+
+    if (!next) {
+        locker.unlock();
+        if (m_throttleTimer) {
+            m_throttleTimer->start(wait);
+        }
+        return;
+    }
+
+    m_queueSize.store(m_queue.size(), std::memory_order_relaxed);
+
+    // post the rest instead of looping, so that timers are not starved by a burst
+    if (!m_queue.isEmpty() && !m_drainPending) {
+        m_drainPending = true;
+        QMetaObject::invokeMethod(this, &DeliveryWorker::drain, Qt::QueuedConnection);
+    }
+    locker.unlock();
+
+    deliver(*next);
+}
+
+void DeliveryWorker::poll()
+{
+    if (Q_UNLIKELY(!m_dbConnected)) {
+        return;
+    }
+
+    auto entries = Outbox::leaseNext(m_name, leaseDuration, pollBatchSize);
+
+    // the first entry of a digest or batched webhook form takes all other leased entries of that form with it
+    QSet<Form::dbid_t> batchedForms;
+    for (Outbox::Entry &entry : entries) {
+        const Form form = entry.submission.form();
+        if (form.digestInterval() > std::chrono::minutes::zero() ||
+            WebhookSender::Config::fromForm(form).batchSize > 1) {
+            if (batchedForms.contains(form.id())) {
+                continue;
+            }
+            batchedForms << form.id();
+        }
+        process(entry);
+    }
+}
+
+void DeliveryWorker::tick()
+{
+    m_smtpPool.expire();
+    SuppressionList::instance()->refreshIfDue();
+
+    const auto ids = m_retryWheel.advance();
+    for (const Submission::dbid_t id : ids) {
+        retry(id);
+    }
+}
+
+void DeliveryWorker::retry(Submission::dbid_t id)
+{
+    // the entry might have been delivered by another process in the meantime
+    if (!Outbox::lease(id, m_name, leaseDuration)) {
+        return;
+    }
+
+    bool ok    = false;
+    auto entry = Outbox::get(id, &ok);
+    if (ok) {
+        entry.leasedBy = m_name;
+        process(entry);
+    }
+}
+
+void DeliveryWorker::resume()
+{
+    const auto schedules = Outbox::schedules();
+    const auto now       = QDateTime::currentDateTimeUtc();
+    const auto steadyNow = TimerWheel::clock::now();
+
+    qsizetype count = 0;
+    for (const Outbox::Schedule &schedule : schedules) {
+        // every thread of a process takes its own share
+        if (static_cast<int>(schedule.id % static_cast<Submission::dbid_t>(m_count)) != m_index) {
+            continue;
+        }
+
+        std::chrono::milliseconds delay{0};
+        if (schedule.nextAttempt.isValid() && schedule.nextAttempt > now) {
+            delay = std::chrono::milliseconds{now.msecsTo(schedule.nextAttempt)};
+        } else {
+            delay =
+                std::chrono::milliseconds{QRandomGenerator::global()->bounded(static_cast<qint64>(resumeSpread.count()))};
+        }
+
+        m_retryWheel.schedule(schedule.id, steadyNow + delay);
+        ++count;
+    }
+
+    if (count > 0) {
+        qCInfo(HBNBOTA_DELIVERY) << "Delivery thread" << m_name << "resumed the schedule for" << count << "outbox entries";
+    }
+}
+
+void DeliveryWorker::scheduleRetry(const Outbox::Entry &entry, const QString &error)
+{
+    const auto delay            = retryDelay(entry.attempts);
+    const QDateTime nextAttempt = QDateTime::currentDateTimeUtc().addSecs(delay.count());
+
+    qCWarning(HBNBOTA_DELIVERY) << "Failed to deliver" << entry.submission << "in attempt" << entry.attempts
+                                << ", will try again at" << nextAttempt;
+
+    if (Outbox::release(entry, error, nextAttempt)) {
+        m_retryWheel.schedule(entry.submission.id(), TimerWheel::clock::now() + delay);
+    }
+}
+
+void DeliveryWorker::defer(const Outbox::Entry &entry, std::chrono::milliseconds wait)
+{
+    qCDebug(HBNBOTA_DELIVERY) << "Deferring" << entry.submission << "for" << wait.count()
+                              << "ms because the mail server is throttled";
+
+    const QDateTime nextAttempt = QDateTime::currentDateTimeUtc().addMSecs(wait.count());
+    if (Outbox::defer(entry, nextAttempt)) {
+        m_retryWheel.schedule(entry.submission.id(), TimerWheel::clock::now() + wait);
+    }
+}
+
+void DeliveryWorker::process(Outbox::Entry &entry)
+{
+    const Submission &submission = entry.submission;
+    const Form form              = submission.form();
+
+    if (form.settings().value(u"mailer"_s).toMap().value(u"type"_s).toString() == "Webhook"_L1) {
+        processWebhook(entry);
+        return;
+    }
+
+    if (form.digestInterval() > std::chrono::minutes::zero()) {
+        processDigest(entry);
+        return;
+    }
+
+    bool ok              = false;
+    const auto receivers = Recipient::list(form, &ok);
+    if (Q_UNLIKELY(!ok)) {
+        scheduleRetry(entry, u"Failed to query recipients"_s);
+        return;
+    }
+
+    if (receivers.empty()) {
+        qCWarning(HBNBOTA_DELIVERY) << "Can not deliver" << submission << "because" << form << "has no recipients";
+    }
+
+    const auto values   = submission.placeholderValues();
+    const auto excluded = form.routing().excluded(values);
+
+    QString lastError;
+    QList<Recipient> batchRecipients;
+    QList<SmtpClient::Message> batch;
+    batchRecipients.reserve(receivers.size());
+    batch.reserve(receivers.size());
+
+    for (const Recipient &r : receivers) {
+        if (entry.delivered.contains(r.id()) || excluded.contains(r.id())) {
+            continue;
+        }
+
+        SmtpClient::Message message;
+        if (!buildMessage(submission, values, r, m_mime, message)) {
+            if (!message.error.isEmpty()) {
+                lastError = message.error;
+            }
+            continue;
+        }
+
+        batchRecipients << r;
+        batch << message;
+    }
+
+    m_mime.clearBodies();
+
+    std::chrono::milliseconds wait{0};
+    if (!batch.empty() && !send(form, batch, wait)) {
+        defer(entry, wait);
+        return;
+    }
+
+    for (qsizetype i = 0; i < batch.size(); ++i) {
+        if (batch.at(i).sent) {
+            qCInfo(HBNBOTA_DELIVERY) << "Delivered" << submission << "to" << batchRecipients.at(i);
+            entry.delivered << batchRecipients.at(i).id();
+        } else if (batch.at(i).rejected) {
+            suppress(form, batch.at(i));
+        } else {
+            qCWarning(HBNBOTA_DELIVERY) << "Failed to deliver" << submission << "to" << batchRecipients.at(i) << ':'
+                                        << batch.at(i).error;
+            lastError = batch.at(i).error;
+        }
+    }
+
+    if (lastError.isEmpty()) {
+        if (Outbox::complete(entry)) {
+            qCDebug(HBNBOTA_DELIVERY) << "Completed" << submission << "after" << entry.attempts << "attempt(s)";
+        }
+        return;
+    }
+
+    scheduleRetry(entry, lastError);
+}
+
+void DeliveryWorker::processDigest(Outbox::Entry &entry)
+{
+    const Form form = entry.submission.form();
+
+    // also contains the given entry, it has already been leased by this worker
+    auto entries = Outbox::leaseDue(form.id(), m_name, leaseDuration);
+    if (std::ranges::none_of(entries, [&entry](const Outbox::Entry &e) {
+            return e.submission.id() == entry.submission.id();
+        })) {
+        entries.prepend(entry);
+    }
+
+    bool ok              = false;
+    const auto receivers = Recipient::list(form, &ok);
+    if (Q_UNLIKELY(!ok)) {
+        for (const Outbox::Entry &e : std::as_const(entries)) {
+            scheduleRetry(e, u"Failed to query recipients"_s);
+        }
+        return;
+    }
+
+    if (receivers.empty()) {
+        qCWarning(HBNBOTA_DELIVERY) << "Can not deliver digest of" << entries.size() << "submissions because" << form
+                                    << "has no recipients";
+    }
+
+    const RoutingTable routing = form.routing();
+    QList<MessageTemplate::Values> values;
+    QList<QList<quint32>> excluded;
+    values.reserve(entries.size());
+    excluded.reserve(entries.size());
+    for (const Outbox::Entry &e : std::as_const(entries)) {
+        values << e.submission.placeholderValues();
+        excluded << routing.excluded(values.constLast());
+    }
+
+    QList<QString> errors(entries.size());
+    QList<Recipient> batchRecipients;
+    QList<QList<qsizetype>> batchEntries;
+    QList<SmtpClient::Message> batch;
+
+    for (const Recipient &r : receivers) {
+        QList<qsizetype> pending;
+        for (qsizetype i = 0; i < entries.size(); ++i) {
+            if (!entries.at(i).delivered.contains(r.id()) && !excluded.at(i).contains(r.id())) {
+                pending << i;
+            }
+        }
+
+        if (pending.empty()) {
+            continue;
+        }
+
+        // if the receiver is taken from the submission, every submission has its own receiver
+        if (r.templates().toEmail.hasPlaceholders()) {
+            for (const qsizetype i : std::as_const(pending)) {
+                SmtpClient::Message message;
+                if (!buildMessage(entries.at(i).submission, values.at(i), r, m_mime, message)) {
+                    if (!message.error.isEmpty()) {
+                        errors[i] = message.error;
+                    }
+                    continue;
+                }
+                batchRecipients << r;
+                batchEntries << QList<qsizetype>{i};
+                batch << message;
+            }
+            continue;
+        }
+
+        QList<Submission> digestSubmissions;
+        QList<MessageTemplate::Values> digestValues;
+        digestSubmissions.reserve(pending.size());
+        digestValues.reserve(pending.size());
+        for (const qsizetype i : std::as_const(pending)) {
+            digestSubmissions << entries.at(i).submission;
+            digestValues << values.at(i);
+        }
+
+        SmtpClient::Message message;
+        if (!buildDigest(digestSubmissions, digestValues, r, m_mime, message)) {
+            if (!message.error.isEmpty()) {
+                for (const qsizetype i : std::as_const(pending)) {
+                    errors[i] = message.error;
+                }
+            }
+            continue;
+        }
+        batchRecipients << r;
+        batchEntries << pending;
+        batch << message;
+    }
+
+    m_mime.clearBodies();
+
+    std::chrono::milliseconds wait{0};
+    if (!batch.empty() && !send(form, batch, wait)) {
+        for (const Outbox::Entry &e : std::as_const(entries)) {
+            defer(e, wait);
+        }
+        return;
+    }
+
+    for (qsizetype m = 0; m < batch.size(); ++m) {
+        const Recipient &r = batchRecipients.at(m);
+        if (batch.at(m).sent) {
+            qCInfo(HBNBOTA_DELIVERY) << "Delivered digest of" << batchEntries.at(m).size() << "submissions to" << r;
+            for (const qsizetype i : batchEntries.at(m)) {
+                entries[i].delivered << r.id();
+            }
+        } else if (batch.at(m).rejected) {
+            suppress(form, batch.at(m));
+        } else {
+            qCWarning(HBNBOTA_DELIVERY) << "Failed to deliver digest to" << r << ':' << batch.at(m).error;
+            for (const qsizetype i : batchEntries.at(m)) {
+                errors[i] = batch.at(m).error;
+            }
+        }
+    }
+
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        if (errors.at(i).isEmpty()) {
+            if (Outbox::complete(entries.at(i))) {
+                qCDebug(HBNBOTA_DELIVERY) << "Completed" << entries.at(i).submission << "after" << entries.at(i).attempts
+                                          << "attempt(s)";
+            }
+        } else {
+            scheduleRetry(entries.at(i), errors.at(i));
+        }
+    }
+}
+
+void DeliveryWorker::processWebhook(const Outbox::Entry &entry)
+{
+    const Form form   = entry.submission.form();
+    const auto config = WebhookSender::Config::fromForm(form);
+
+    QList<Outbox::Entry> entries;
+    if (config.batchSize > 1 || form.digestInterval() > std::chrono::minutes::zero()) {
+        // also contains the entries leased by this worker whose requests are still running
+        entries = Outbox::leaseDue(form.id(), m_name, leaseDuration);
+        entries.removeIf([this, &entry](const Outbox::Entry &e) {
+            return e.submission.id() == entry.submission.id() || m_webhookPending.contains(e.submission.id());
+        });
+    }
+    entries.prepend(entry);
+
+    for (qsizetype offset = 0; offset < entries.size(); offset += config.batchSize) {
+        const QList<Outbox::Entry> batch = entries.mid(offset, config.batchSize);
+
+        QList<Submission> submissions;
+        submissions.reserve(batch.size());
+        for (const Outbox::Entry &e : batch) {
+            submissions << e.submission;
+            m_webhookPending << e.submission.id();
+        }
+
+        m_webhookSender->post(form, config, submissions, [this, batch](const QString &error) {
+            for (const Outbox::Entry &e : batch) {
+                m_webhookPending.remove(e.submission.id());
+                if (!error.isEmpty()) {
+                    scheduleRetry(e, error);
+                } else if (Outbox::complete(e)) {
+                    qCInfo(HBNBOTA_DELIVERY) << "Posted" << e.submission << "to webhook after" << e.attempts
+                                             << "attempt(s)";
+                }
+            }
+        });
+    }
+}
+
+bool DeliveryWorker::buildMessage(const Submission &submission,
+                                  const MessageTemplate::Values &values,
+                                  const Recipient &r,
+                                  MimeAssembler &mime,
+                                  SmtpClient::Message &message)
+{
+    const auto templates = r.templates();
+
+    MessageParts parts;
+    parts.toEmail = templates.toEmail.render(values);
+    if (parts.toEmail.isEmpty()) {
+        qCWarning(HBNBOTA_DELIVERY) << "Skipping" << r << "for" << submission << "because the receiver address is empty";
+        return false;
+    }
+
+    if (SuppressionList::instance()->contains(r.form().id(), parts.toEmail)) {
+        qCDebug(HBNBOTA_DELIVERY) << "Skipping" << r << "for" << submission << "because" << parts.toEmail
+                                  << "is suppressed";
+        return false;
+    }
+
+    parts.fromName     = templates.fromName.render(values);
+    parts.toName       = templates.toName.render(values);
+    parts.replyToEmail = templates.replyToEmail.render(values);
+    parts.replyToName  = templates.replyToName.render(values);
+    parts.subject      = templates.subject.render(values);
+    parts.text         = templates.text.render(values);
+    parts.html         = templates.html.render(values, MessageTemplate::HtmlEscape);
+
+    encodeMessage(r, parts, mime, message);
+
+    return true;
+}
+
+bool DeliveryWorker::buildDigest(const QList<Submission> &submissions,
+                                 const QList<MessageTemplate::Values> &values,
+                                 const Recipient &r,
+                                 MimeAssembler &mime,
+                                 SmtpClient::Message &message)
+{
+    const auto templates             = r.templates();
+    const MessageTemplate::Values &v = values.first();
+
+    // envelope and headers are rendered with the values of the first submission
+    MessageParts parts;
+    parts.toEmail = templates.toEmail.render(v);
+    if (parts.toEmail.isEmpty()) {
+        qCWarning(HBNBOTA_DELIVERY) << "Skipping digest for" << r << "because the receiver address is empty";
+        return false;
+    }
+
+    if (SuppressionList::instance()->contains(r.form().id(), parts.toEmail)) {
+        qCDebug(HBNBOTA_DELIVERY) << "Skipping digest for" << r << "because" << parts.toEmail << "is suppressed";
+        return false;
+    }
+
+    parts.fromName = templates.fromName.render(v);
+    parts.toName   = templates.toName.render(v);
+
+    // a reply-to address taken from one of the submissions would be misleading
+    if (submissions.size() == 1 || !templates.replyToEmail.hasPlaceholders()) {
+        parts.replyToEmail = templates.replyToEmail.render(v);
+        parts.replyToName  = templates.replyToName.render(v);
+    }
+
+    parts.subject = templates.subject.render(v);
+    if (submissions.size() > 1) {
+        parts.subject += u" (+%1)"_s.arg(submissions.size() - 1);
+    }
+
+    QStringList texts;
+    QStringList htmls;
+    texts.reserve(values.size());
+    htmls.reserve(values.size());
+    for (const MessageTemplate::Values &submissionValues : values) {
+        if (!templates.text.isEmpty()) {
+            texts << templates.text.render(submissionValues);
+        }
+        if (!templates.html.isEmpty()) {
+            htmls << templates.html.render(submissionValues, MessageTemplate::HtmlEscape);
+        }
+    }
+    parts.text = texts.join(u"\n\n----------------------------------------\n\n");
+    parts.html = htmls.join(u"\n<hr>\n");
+
+    encodeMessage(r, parts, mime, message);
+
+    return true;
+}
+
+void DeliveryWorker::encodeMessage(const Recipient &r,
+                                   const MessageParts &parts,
+                                   MimeAssembler &mime,
+                                   SmtpClient::Message &message)
+{
+    // recipients with the same bodies share one encoded entity
+    const QByteArray body = mime.body(parts.text, parts.html);
+
+    message.data = MimeAssembler::assemble(mime.address(parts.fromName, r.fromEmail()),
+                                           mime.address(parts.toName, parts.toEmail),
+                                           parts.replyToEmail.isEmpty()
+                                               ? QByteArray{}
+                                               : mime.address(parts.replyToName, parts.replyToEmail),
+                                           parts.subject,
+                                           MimeAssembler::messageId(r.fromEmail()),
+                                           body);
+    message.from = r.fromEmail().toUtf8();
+    message.to   = parts.toEmail.toUtf8();
+}
+
+void DeliveryWorker::suppress(const Form &form, const SmtpClient::Message &message)
+{
+    const QString email = QString::fromUtf8(message.to);
+
+    qCWarning(HBNBOTA_DELIVERY) << "Suppressing" << email << "for" << form
+                                << "because the mail server rejected it permanently:" << message.error;
+
+    Suppression::add(form.id(), email, message.error);
+}
+
+bool DeliveryWorker::send(const Form &form, QList<SmtpClient::Message> &messages, std::chrono::milliseconds &wait)
+{
+    const QString senderType = form.settings().value(u"mailer"_s).toMap().value(u"type"_s).toString();
+    const bool smtp          = senderType != "Sendmail"_L1 && senderType != "Maildir"_L1;
+
+    // all recipients of a form share the same mailer settings and thereby one session
+    SmtpClient::Config config;
+    QString relay;
+    if (smtp) {
+        config            = SmtpClient::Config::fromForm(form);
+        relay             = config.relay();
+        const auto limits = RelayLimiter::Limits::fromForm(form);
+        if (!RelayLimiter::instance()->tryAcquire(relay, limits, messages.size(), &wait)) {
+            return false;
+        }
+    }
+
+    // signed after the throttling check, deferred messages are built again later anyway
+    if (const auto dkim = DkimSigner::Config::fromForm(form); dkim.isValid()) {
+        m_dkim.sign(dkim, messages);
+    }
+
+    if (senderType == "Sendmail"_L1) {
+        SendmailSender{Settings::sendmailPath()}.sendMails(messages);
+    } else if (senderType == "Maildir"_L1) {
+        MaildirWriter{MaildirWriter::pathForForm(form)}.sendMails(messages);
+    } else {
+        sendMails(form, config, messages);
+        RelayLimiter::instance()->release(relay);
+    }
+
+    return true;
+}
+
+void DeliveryWorker::sendMails(const Form &form, const SmtpClient::Config &config, QList<SmtpClient::Message> &messages)
+{
+    QString error;
+    auto client = m_smtpPool.acquire(config, error);
+    if (Q_UNLIKELY(!client)) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to send messages for" << form << "via" << config.host << ':' << error;
+        for (SmtpClient::Message &message : messages) {
+            message.error = error;
+        }
+        return;
+    }
+
+    client->sendMails(messages);
+
+    m_smtpPool.release(std::move(client));
+}
+
+#include "moc_deliveryworker.cpp"
@@ -0,0 +1,195 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_DELIVERYWORKER_H
+#define HBNBOTA_DELIVERYWORKER_H
+
+#include "dkimsigner.h"
+#include "fairqueue.h"
+#include "mimeassembler.h"
+#include "objects/form.h"
+#include "objects/messagetemplate.h"
+#include "objects/submission.h"
+#include "smtppool.h"
+#include "timerwheel.h"
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QVariantMap>
+
+#include <atomic>
+
+class QTimer;
+class Recipient;
+class WebhookSender;
+
+namespace Outbox {
+struct Entry;
+}
+
+/*!
+ * \brief Sends the messages for outbox entries to the form recipients.
+ *
+ * Objects of this class live in a delivery thread and have their own
+ * database connection and their own pool of SMTP sessions. Entries are leased
+ * from the outbox directly after they have been created via deliver(). Failed
+ * deliveries are retried with exponential backoff, scheduled in a TimerWheel that
+ * is advanced every second. On startup, the schedule is restored from the next
+ * attempt times stored in the outbox.
+ *
+ * New submissions are handed over via enqueue() into a bounded in-memory queue
+ * that is drained one entry at a time inside the delivery thread. The queue takes
+ * turns between the forms, so that a flood of submissions for one form does not
+ * delay the submissions for other forms. Submissions whose mail server is throttled
+ * by the RelayLimiter stay in the queue until the server can be used again.
+ *
+ * Submissions for forms with a digest interval are held back in the outbox until
+ * the next digest is due. Then all due entries of the form are sent together as one
+ * message per recipient, see buildDigest().
+ *
+ * Receiver addresses are checked against the SuppressionList before a message is
+ * built for them, suppressed receivers are skipped without error. Receivers that
+ * the mail server rejects permanently are added to the suppressions of the form
+ * and are not retried.
+ *
+ * Forms with the Webhook sender type do not send messages to their recipients.
+ * Their submissions are posted asynchronously by the WebhookSender of the worker,
+ * up to the configured batch size of due submissions in one request.
+ *
+ * Messages of forms with DKIM settings are signed in the delivery thread right
+ * before they are sent, using the DkimSigner of the worker.
+ */
+class DeliveryWorker final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(DeliveryWorker)
+public:
+    /*!
+     * \brief Constructs a new %DeliveryWorker.
+     *
+     * \a index is the number of this worker among all \a count workers of the process.
+     */
+    DeliveryWorker(const QVariantMap &dbConfig, int index, int count, QObject *parent = nullptr);
+    ~DeliveryWorker() override = default;
+
+    /*!
+     * \brief Initializes the worker inside its thread.
+     */
+    void init();
+
+    /*!
+     * \brief Leases the outbox entry for the new \a submission and delivers it.
+     */
+    void deliver(const Submission &submission);
+
+    /*!
+     * \brief Appends the new \a submission to the queue of this worker.
+     *
+     * This function is thread-safe. Returns \c false if the queue already contains
+     * Settings::deliveryQueueSize() submissions. The submission is not lost then,
+     * it stays in the outbox and will be delivered by a later poll().
+     */
+    bool enqueue(const Submission &submission);
+
+    /*!
+     * \brief Returns the number of submissions waiting in the queue of this worker.
+     *
+     * This function is thread-safe.
+     */
+    [[nodiscard]] qsizetype queueSize() const noexcept;
+
+    /*!
+     * \brief Leases available outbox entries and delivers them.
+     *
+     * This is the fallback for entries whose lease has expired or whose retry is
+     * not scheduled in any running process.
+     */
+    void poll();
+
+    /*!
+     * \brief Renders and encodes the message for recipient \a r of \a submission into \a message.
+     *
+     * \a values have to be the placeholder values of the \a submission. Encoded bodies and
+     * addresses are taken from and stored in \a mime, so use the same assembler for all
+     * recipients of a submission. Returns \c false if the message can not be sent to \a r,
+     * the error of \a message is empty if the receiver address is suppressed.
+     */
+    [[nodiscard]] static bool buildMessage(const Submission &submission,
+                                           const MessageTemplate::Values &values,
+                                           const Recipient &r,
+                                           MimeAssembler &mime,
+                                           SmtpClient::Message &message);
+
+    /*!
+     * \brief Renders and encodes one digest message for recipient \a r containing all \a submissions.
+     *
+     * \a values have to be the placeholder values of the \a submissions in the same order.
+     * Sender, receiver and subject are rendered with the values of the first submission,
+     * the subject gets the number of additional submissions appended. The text and HTML
+     * bodies of all submissions are joined. Returns \c false if the message can not be
+     * sent to \a r.
+     */
+    [[nodiscard]] static bool buildDigest(const QList<Submission> &submissions,
+                                          const QList<MessageTemplate::Values> &values,
+                                          const Recipient &r,
+                                          MimeAssembler &mime,
+                                          SmtpClient::Message &message);
+
+private:
+    struct MessageParts {
+        QString fromName;
+        QString toEmail;
+        QString toName;
+        QString replyToEmail;
+        QString replyToName;
+        QString subject;
+        QString text;
+        QString html;
+    };
+
+    static void encodeMessage(const Recipient &r,
+                              const MessageParts &parts,
+                              MimeAssembler &mime,
+                              SmtpClient::Message &message);
+
+    void drain();
+    void tick();
+    void retry(Submission::dbid_t id);
+    void resume();
+    void scheduleRetry(const Outbox::Entry &entry, const QString &error);
+    void defer(const Outbox::Entry &entry, std::chrono::milliseconds wait);
+    void process(Outbox::Entry &entry);
+    void processDigest(Outbox::Entry &entry);
+    void processWebhook(const Outbox::Entry &entry);
+    void suppress(const Form &form, const SmtpClient::Message &message);
+
+    [[nodiscard]] bool send(const Form &form, QList<SmtpClient::Message> &messages, std::chrono::milliseconds &wait);
+    void sendMails(const Form &form, const SmtpClient::Config &config, QList<SmtpClient::Message> &messages);
+
+    QVariantMap m_dbConfig;
+    QString m_name;
+    QMutex m_queueMutex;
+    FairQueue<Form::dbid_t, Submission> m_queue;
+    std::atomic<qsizetype> m_queueSize{0};
+    qsizetype m_queueLimit{0};
+    bool m_drainPending{false};
+    SmtpPool m_smtpPool;
+    MimeAssembler m_mime;
+    DkimSigner m_dkim;
+    TimerWheel m_retryWheel;
+    WebhookSender *m_webhookSender{nullptr};
+    // outbox entries whose webhook request is still running
+    QSet<Submission::dbid_t> m_webhookPending;
+    QTimer *m_pollTimer{nullptr};
+    QTimer *m_tickTimer{nullptr};
+    QTimer *m_throttleTimer{nullptr};
+    int m_index{0};
+    int m_count{1};
+    bool m_dbConnected{false};
+};
+
+#endif // HBNBOTA_DELIVERYWORKER_H
@@ -0,0 +1,307 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "dkimsigner.h"
+
+#include "logging.h"
+#include "objects/form.h"
+
+#include <botan/auto_rng.h>
+#include <botan/data_src.h>
+#include <botan/pk_keys.h>
+#include <botan/pkcs8.h>
+#include <botan/pubkey.h>
+
+#include <QByteArrayList>
+#include <QCryptographicHash>
+#include <QDateTime>
+
+#include <array>
+#include <exception>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// signed if present, in this order
+constexpr std::array<const char *, 9> signedHeaders{"from",
+                                                    "reply-to",
+                                                    "to",
+                                                    "subject",
+                                                    "date",
+                                                    "message-id",
+                                                    "mime-version",
+                                                    "content-type",
+                                                    "content-transfer-encoding"};
+
+bool isWsp(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+// splits a header block into its fields, continuation lines stay with their field
+QByteArrayList headerFields(QByteArrayView headers)
+{
+    QByteArrayList fields;
+    qsizetype pos = 0;
+    while (pos < headers.size()) {
+        qsizetype end = headers.indexOf("\r\n", pos);
+        if (end < 0) {
+            end = headers.size();
+        }
+        const QByteArrayView line = headers.sliced(pos, end - pos);
+        if (!line.isEmpty() && isWsp(line.front()) && !fields.empty()) {
+            fields.last().append("\r\n").append(line);
+        } else if (!line.isEmpty()) {
+            fields << line.toByteArray();
+        }
+        pos = end + 2;
+    }
+    return fields;
+}
+
+QByteArray fieldName(const QByteArray &field)
+{
+    return field.left(field.indexOf(':')).trimmed().toLower();
+}
+} // namespace
+
+struct DkimSigner::Key {
+    QByteArray pem;
+    std::unique_ptr<Botan::Private_Key> privateKey;
+    std::unique_ptr<Botan::PK_Signer> signer;
+    // the tags that are the same for every signature, followed by a semicolon
+    QByteArray tags;
+    bool ed25519{false};
+};
+
+DkimSigner::Config DkimSigner::Config::fromForm(const Form &form)
+{
+    const auto dkim = form.settings().value(u"mailer"_s).toMap().value(u"dkim"_s).toMap();
+
+    Config config;
+    config.domain   = dkim.value(u"domain"_s).toString();
+    config.selector = dkim.value(u"selector"_s).toString();
+    config.key      = dkim.value(u"key"_s).toString().toLatin1();
+    return config;
+}
+
+DkimSigner::DkimSigner()
+    : m_rng{std::make_unique<Botan::AutoSeeded_RNG>()}
+{
+}
+
+DkimSigner::~DkimSigner() = default;
+
+bool DkimSigner::sign(const Config &config, SmtpClient::Message &message)
+{
+    const auto k = key(config);
+    if (!k) {
+        return false;
+    }
+
+    const qsizetype headerEnd = message.data.indexOf("\r\n\r\n");
+    const QByteArrayView headers =
+        headerEnd < 0 ? QByteArrayView{message.data} : QByteArrayView{message.data}.first(headerEnd);
+    const QByteArrayView body = headerEnd < 0 ? QByteArrayView{} : QByteArrayView{message.data}.sliced(headerEnd + 4);
+
+    const QByteArrayList fields = headerFields(headers);
+
+    QByteArray signedData;
+    signedData.reserve(headers.size() + 512);
+    QByteArrayList names;
+    for (const char *name : signedHeaders) {
+        // the last occurrence of a field is signed first
+        for (auto it = fields.crbegin(); it != fields.crend(); ++it) {
+            if (fieldName(*it) == name) {
+                signedData += canonicalizeHeader(*it) + "\r\n"_ba;
+                names << QByteArray{name};
+                break;
+            }
+        }
+    }
+
+    const QByteArray bodyHash =
+        QCryptographicHash::hash(canonicalizeBody(body.toByteArray()), QCryptographicHash::Sha256).toBase64();
+
+    const QByteArray header = "DKIM-Signature: "_ba + k->tags + "\r\n\tt="_ba +
+                              QByteArray::number(QDateTime::currentSecsSinceEpoch()) + "; h="_ba + names.join(':') +
+                              ";\r\n\tbh="_ba + bodyHash + ";\r\n\tb="_ba;
+
+    // the signature header itself is signed with an empty b tag and without trailing line break
+    signedData += canonicalizeHeader(header);
+
+    std::vector<uint8_t> signature;
+    try {
+        if (k->ed25519) {
+            // RFC 8463: the SHA-256 hash of the data is signed with PureEdDSA
+            const QByteArray hash = QCryptographicHash::hash(signedData, QCryptographicHash::Sha256);
+            signature             = k->signer->sign_message(
+                reinterpret_cast<const uint8_t *>(hash.constData()), static_cast<size_t>(hash.size()), *m_rng);
+        } else {
+            signature = k->signer->sign_message(reinterpret_cast<const uint8_t *>(signedData.constData()),
+                                                static_cast<size_t>(signedData.size()),
+                                                *m_rng);
+        }
+    } catch (const std::exception &e) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to create DKIM signature for selector" << config.selector << "of"
+                                     << config.domain << ':' << e.what();
+        return false;
+    }
+
+    const QByteArray b =
+        QByteArray::fromRawData(reinterpret_cast<const char *>(signature.data()), static_cast<qsizetype>(signature.size()))
+            .toBase64();
+
+    message.data = header + b + "\r\n"_ba + message.data;
+
+    return true;
+}
+
+void DkimSigner::sign(const Config &config, QList<SmtpClient::Message> &messages)
+{
+    for (SmtpClient::Message &message : messages) {
+        if (Q_UNLIKELY(!sign(config, message))) {
+            qCWarning(HBNBOTA_DELIVERY) << "Sending message to" << message.to << "without DKIM signature";
+        }
+    }
+}
+
+bool DkimSigner::checkKey(const QByteArray &pem)
+{
+    try {
+        Botan::DataSource_Memory source{reinterpret_cast<const uint8_t *>(pem.constData()),
+                                        static_cast<size_t>(pem.size())};
+        const auto privateKey = Botan::PKCS8::load_key(source);
+        return privateKey && (privateKey->algo_name() == "Ed25519" ||
+                              (privateKey->algo_name() == "RSA" && privateKey->key_length() >= 1024));
+    } catch (const std::exception &) {
+        return false;
+    }
+}
+
+QByteArray DkimSigner::canonicalizeHeader(const QByteArray &field)
+{
+    const qsizetype colon = field.indexOf(':');
+    if (colon < 0) {
+        return field.trimmed().toLower();
+    }
+
+    QByteArray out = field.left(colon).trimmed().toLower();
+    out.reserve(field.size());
+    out += ':';
+
+    // unfold and reduce whitespace to single spaces, without leading and trailing whitespace
+    const qsizetype valueStart = out.size();
+    bool wsp                   = false;
+    for (qsizetype i = colon + 1; i < field.size(); ++i) {
+        const char c = field.at(i);
+        if (c == '\r' || c == '\n' || isWsp(c)) {
+            wsp = true;
+            continue;
+        }
+        if (wsp && out.size() > valueStart) {
+            out += ' ';
+        }
+        wsp = false;
+        out += c;
+    }
+
+    return out;
+}
+
+QByteArray DkimSigner::canonicalizeBody(const QByteArray &body)
+{
+    QByteArray out;
+    out.reserve(body.size());
+
+    // empty lines are only written once a non-empty line follows, trailing ones are dropped
+    qsizetype emptyLines = 0;
+    qsizetype pos        = 0;
+    while (pos < body.size()) {
+        qsizetype end = body.indexOf("\r\n", pos);
+        if (end < 0) {
+            end = body.size();
+        }
+
+        QByteArray line;
+        line.reserve(end - pos);
+        bool wsp = false;
+        for (qsizetype i = pos; i < end; ++i) {
+            const char c = body.at(i);
+            if (isWsp(c)) {
+                wsp = true;
+                continue;
+            }
+            if (wsp) {
+                line += ' ';
+            }
+            wsp = false;
+            line += c;
+        }
+
+        if (line.isEmpty()) {
+            ++emptyLines;
+        } else {
+            for (; emptyLines > 0; --emptyLines) {
+                out += "\r\n";
+            }
+            out += line;
+            out += "\r\n";
+        }
+
+        pos = end + 2;
+    }
+
+    return out;
+}
+
+std::shared_ptr<DkimSigner::Key> DkimSigner::key(const Config &config)
+{
+    const QString id = config.selector + "._domainkey."_L1 + config.domain;
+
+    auto it = m_keys.find(id);
+    if (it != m_keys.end() && it.value()->pem == config.key) {
+        return it.value()->signer ? it.value() : nullptr;
+    }
+
+    // unusable keys are cached too, so that they are not parsed again for every message
+    auto k = std::make_shared<Key>();
+    k->pem = config.key;
+    m_keys.insert(id, k);
+
+    try {
+        Botan::DataSource_Memory source{reinterpret_cast<const uint8_t *>(config.key.constData()),
+                                        static_cast<size_t>(config.key.size())};
+        k->privateKey = Botan::PKCS8::load_key(source);
+    } catch (const std::exception &e) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to load DKIM key for selector" << config.selector << "of"
+                                     << config.domain << ':' << e.what();
+        return nullptr;
+    }
+
+    const std::string algorithm = k->privateKey ? k->privateKey->algo_name() : std::string{};
+    if (algorithm != "RSA" && algorithm != "Ed25519") {
+        qCCritical(HBNBOTA_DELIVERY) << "Unsupported DKIM key type" << algorithm.c_str() << "for selector"
+                                     << config.selector << "of" << config.domain;
+        return nullptr;
+    }
+
+    k->ed25519 = algorithm == "Ed25519";
+    try {
+        k->signer = std::make_unique<Botan::PK_Signer>(*k->privateKey, *m_rng, k->ed25519 ? "Pure" : "EMSA3(SHA-256)");
+    } catch (const std::exception &e) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to create DKIM signer for selector" << config.selector << "of"
+                                     << config.domain << ':' << e.what();
+        return nullptr;
+    }
+
+    k->tags = "v=1; a="_ba + (k->ed25519 ? "ed25519-sha256"_ba : "rsa-sha256"_ba) +
+              "; c=relaxed/relaxed; d="_ba + config.domain.toLatin1() + "; s="_ba + config.selector.toLatin1() + ";"_ba;
+
+    qCDebug(HBNBOTA_DELIVERY) << "Loaded" << algorithm.c_str() << "DKIM key for selector" << config.selector << "of"
+                              << config.domain;
+
+    return k;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_DKIMSIGNER_H
+#define HBNBOTA_DKIMSIGNER_H
+
+#include "smtpclient.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <memory>
+
+class Form;
+
+namespace Botan {
+class RandomNumberGenerator;
+}
+
+/*!
+ * \brief Adds DKIM signatures according to RFC 6376 to encoded messages.
+ *
+ * Header and body are canonicalized with the relaxed algorithm. RSA keys are used
+ * with rsa-sha256, Ed25519 keys with ed25519-sha256 according to RFC 8463. Keys have
+ * to be PKCS #8 encoded private keys in PEM format.
+ *
+ * Parsing a private key is expensive compared to signing a message. Parsed keys
+ * are therefore cached per selector and domain together with their signing
+ * operation and the constant tags of the signature header. A cached key is only
+ * parsed again if the key stored for the selector changes.
+ *
+ * Objects of this class are not thread-safe, every delivery thread has its own signer.
+ */
+class DkimSigner final
+{
+public:
+    /*!
+     * \brief DKIM settings of a form.
+     */
+    struct Config {
+        QString domain;
+        QString selector;
+        QByteArray key;
+
+        /*!
+         * \brief Returns the configuration stored in the mailer settings of \a form.
+         */
+        [[nodiscard]] static Config fromForm(const Form &form);
+
+        /*!
+         * \brief Returns \c true if messages should be signed.
+         */
+        [[nodiscard]] bool isValid() const noexcept
+        {
+            return !domain.isEmpty() && !selector.isEmpty() && !key.isEmpty();
+        }
+    };
+
+    DkimSigner();
+    ~DkimSigner();
+
+    /*!
+     * \brief Signs \a message with the key in \a config.
+     *
+     * Returns \c false if the key can not be used, the message is left unchanged then.
+     */
+    bool sign(const Config &config, SmtpClient::Message &message);
+
+    /*!
+     * \brief Signs all \a messages with the key in \a config.
+     *
+     * Messages that can not be signed are sent without signature.
+     */
+    void sign(const Config &config, QList<SmtpClient::Message> &messages);
+
+    /*!
+     * \brief Returns the number of cached keys.
+     */
+    [[nodiscard]] qsizetype keyCount() const noexcept { return m_keys.size(); }
+
+    /*!
+     * \brief Returns \c true if \a pem contains a private key that can be used for signing.
+     */
+    [[nodiscard]] static bool checkKey(const QByteArray &pem);
+
+    /*!
+     * \brief Returns the relaxed canonicalization of the header \a field including its name.
+     *
+     * The result does not contain the trailing line break.
+     */
+    [[nodiscard]] static QByteArray canonicalizeHeader(const QByteArray &field);
+
+    /*!
+     * \brief Returns the relaxed canonicalization of the message \a body.
+     */
+    [[nodiscard]] static QByteArray canonicalizeBody(const QByteArray &body);
+
+private:
+    struct Key;
+
+    [[nodiscard]] std::shared_ptr<Key> key(const Config &config);
+
+    QHash<QString, std::shared_ptr<Key>> m_keys;
+    std::unique_ptr<Botan::RandomNumberGenerator> m_rng;
+};
+
+#endif // HBNBOTA_DKIMSIGNER_H
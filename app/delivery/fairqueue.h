@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_FAIRQUEUE_H
+#define HBNBOTA_FAIRQUEUE_H
+
+#include <QHash>
+#include <QList>
+
+#include <algorithm>
+#include <optional>
+
+/*!
+ * \brief Queue that serves its flows with deficit round robin.
+ *
+ * Every item belongs to a flow identified by a \a Key. Items of the same flow are
+ * returned in the order they have been pushed, but the flows take turns: in every
+ * round a flow can take as many items as its weight. So a flow with a lot of
+ * waiting items can not delay the items of other flows for more than one round.
+ *
+ * pop() can skip flows whose next item is currently not ready, for example because
+ * the mail server it has to be sent to is rate limited. Skipped flows lose the rest
+ * of their turn. It is not thread-safe.
+ */
+template <typename Key, typename T>
+class FairQueue final
+{
+public:
+    /*!
+     * \brief Appends \a item to the flow \a key.
+     *
+     * \a weight is the number of items the flow can take per round, it is updated with
+     * every push and will at least be \c 1.
+     */
+    void push(const Key &key, const T &item, int weight = 1)
+    {
+        auto it = m_flows.find(key);
+        if (it == m_flows.end()) {
+            it = m_flows.insert(key, Flow{});
+            m_active << key;
+        }
+        it->weight = std::max(weight, 1);
+        it->items << item;
+        ++m_size;
+    }
+
+    /*!
+     * \brief Removes and returns the next item for which \a ready returns \c true.
+     *
+     * \a ready is called with the first item of a flow. Returns an empty optional if the
+     * queue is empty or if the first items of all flows are not ready.
+     */
+    template <typename Ready>
+    [[nodiscard]] std::optional<T> pop(Ready ready)
+    {
+        for (qsizetype checked = 0; checked < m_active.size();) {
+            const Key key = m_active.first();
+            Flow &flow    = m_flows[key];
+
+            if (!ready(std::as_const(flow.items).first())) {
+                flow.deficit = 0;
+                m_active.append(m_active.takeFirst());
+                ++checked;
+                continue;
+            }
+
+            if (flow.deficit <= 0) {
+                flow.deficit += flow.weight;
+            }
+
+            T item = flow.items.takeFirst();
+            --flow.deficit;
+            --m_size;
+
+            if (flow.items.empty()) {
+                m_flows.remove(key);
+                m_active.removeFirst();
+            } else if (flow.deficit <= 0) {
+                m_active.append(m_active.takeFirst());
+            }
+
+            return item;
+        }
+
+        return std::nullopt;
+    }
+
+    /*!
+     * \brief Removes and returns the next item.
+     */
+    [[nodiscard]] std::optional<T> pop()
+    {
+        return pop([](const T &) { return true; });
+    }
+
+    /*!
+     * \brief Returns the number of items in all flows.
+     */
+    [[nodiscard]] qsizetype size() const noexcept { return m_size; }
+
+    [[nodiscard]] bool isEmpty() const noexcept { return m_size == 0; }
+
+    /*!
+     * \brief Returns the number of flows that have waiting items.
+     */
+    [[nodiscard]] qsizetype flows() const noexcept { return m_active.size(); }
+
+private:
+    struct Flow {
+        QList<T> items;
+        int weight{1};
+        int deficit{0};
+    };
+
+    QHash<Key, Flow> m_flows;
+    QList<Key> m_active;
+    qsizetype m_size{0};
+};
+
+#endif // HBNBOTA_FAIRQUEUE_H
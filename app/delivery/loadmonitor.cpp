@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "loadmonitor.h"
+
+namespace {
+qint64 toMSecs(LoadMonitor::clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+} // namespace
+
+void LoadMonitor::reportLatency(std::chrono::microseconds latency,
+                                std::chrono::milliseconds sampleLifetime,
+                                clock::time_point now)
+{
+    const qint64 nowMSecs = toMSecs(now);
+
+    // a sample that follows a long pause starts a new average, otherwise weight new samples with 1/8
+    const qint64 lastSample = m_lastSample.exchange(nowMSecs);
+    if (lastSample == 0 || nowMSecs - lastSample >= sampleLifetime.count()) {
+        m_latency.store(latency.count(), std::memory_order_relaxed);
+        return;
+    }
+
+    qint64 current = m_latency.load(std::memory_order_relaxed);
+    qint64 next    = 0;
+    do {
+        next = current + (latency.count() - current) / 8;
+    } while (!m_latency.compare_exchange_weak(current, next, std::memory_order_relaxed));
+}
+
+std::chrono::microseconds LoadMonitor::latency(std::chrono::milliseconds sampleLifetime, clock::time_point now) const
+{
+    const qint64 lastSample = m_lastSample.load(std::memory_order_relaxed);
+    if (lastSample == 0 || toMSecs(now) - lastSample >= sampleLifetime.count()) {
+        return std::chrono::microseconds::zero();
+    }
+
+    return std::chrono::microseconds{m_latency.load(std::memory_order_relaxed)};
+}
+
+bool LoadMonitor::isOverloaded(qsizetype queued, qsizetype workers, const Limits &limits, clock::time_point now) const
+{
+    if (latency(limits.sampleLifetime, now) > limits.maxLatency) {
+        return true;
+    }
+
+    return workers > 0 && queued > limits.highWaterMark * workers;
+}
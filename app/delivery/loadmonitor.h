@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_LOADMONITOR_H
+#define HBNBOTA_LOADMONITOR_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <chrono>
+
+/*!
+ * \brief Decides if new submissions should be rejected because the delivery can not keep up.
+ *
+ * Keeps an exponentially weighted moving average of the time it takes to write a new
+ * submission to the database, where every new sample is weighted with 1/8. A sample that
+ * follows a pause longer than Limits::sampleLifetime starts a new average. All functions
+ * are thread-safe and do not lock.
+ */
+class LoadMonitor final
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Limits {
+        /*!
+         * \brief Average write latency above which the system is overloaded.
+         */
+        std::chrono::microseconds maxLatency{0};
+        /*!
+         * \brief Time after which the average latency is not taken into account anymore.
+         */
+        std::chrono::milliseconds sampleLifetime{0};
+        /*!
+         * \brief Average number of queued submissions per delivery thread above which the system is overloaded.
+         */
+        qsizetype highWaterMark{0};
+    };
+
+    LoadMonitor() = default;
+
+    /*!
+     * \brief Adds the write \a latency measured at \a now to the moving average.
+     */
+    void reportLatency(std::chrono::microseconds latency,
+                       std::chrono::milliseconds sampleLifetime,
+                       clock::time_point now = clock::now());
+
+    /*!
+     * \brief Returns the moving average of the write latency at \a now.
+     *
+     * Returns a zero duration if there is no sample that is younger than \a sampleLifetime.
+     */
+    [[nodiscard]] std::chrono::microseconds latency(std::chrono::milliseconds sampleLifetime,
+                                                    clock::time_point now = clock::now()) const;
+
+    /*!
+     * \brief Returns \c true if the average latency or the \a queued submissions of \a workers delivery threads exceed
+     * the \a limits.
+     */
+    [[nodiscard]] bool
+        isOverloaded(qsizetype queued, qsizetype workers, const Limits &limits, clock::time_point now = clock::now()) const;
+
+private:
+    // microseconds
+    std::atomic<qint64> m_latency{0};
+    // steady clock time of the last sample in milliseconds, 0 if there is none
+    std::atomic<qint64> m_lastSample{0};
+};
+
+#endif // HBNBOTA_LOADMONITOR_H
@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "maildirwriter.h"
+
+#include "logging.h"
+#include "objects/form.h"
+#include "settings.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSysInfo>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+bool syncDir(const QString &path)
+{
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+} // namespace
+
+MaildirWriter::MaildirWriter(const QString &path)
+    : m_path{path}
+{
+}
+
+QString MaildirWriter::pathForForm(const Form &form)
+{
+    return pathForForm(Settings::maildirPath(), form);
+}
+
+QString MaildirWriter::pathForForm(const QString &base, const Form &form)
+{
+    if (base.isEmpty()) {
+        return {};
+    }
+
+    static const QRegularExpression folderRegex{uR"(^[A-Za-z0-9][A-Za-z0-9_.-]*$)"_s};
+
+    // the folder is chosen by the form owner, so it is kept below the form UUID to not reach into other Maildirs
+    const QString formPath = base + '/'_L1 + form.uuid();
+    const QString folder =
+        form.settings().value(u"mailer"_s).toMap().value(u"maildir"_s).toMap().value(u"folder"_s).toString();
+    if (folder.isEmpty() || folder == form.uuid() || !folderRegex.match(folder).hasMatch()) {
+        return formPath;
+    }
+
+    return formPath + '/'_L1 + folder;
+}
+
+void MaildirWriter::sendMails(QList<SmtpClient::Message> &messages)
+{
+    const auto failAll = [&messages](const QString &error) {
+        for (SmtpClient::Message &message : messages) {
+            message.error = error;
+        }
+    };
+
+    if (Q_UNLIKELY(m_path.isEmpty())) {
+        failAll(u"No Maildir path has been configured"_s);
+        return;
+    }
+
+    const QString tmpDir = m_path + "/tmp/"_L1;
+    const QString newDir = m_path + "/new/"_L1;
+
+    QDir dir;
+    for (const QString &sub : {tmpDir, newDir, m_path + "/cur/"_L1}) {
+        if (Q_UNLIKELY(!dir.mkpath(sub))) {
+            failAll(u"Failed to create Maildir directory %1"_s.arg(sub));
+            return;
+        }
+    }
+
+    struct Pending {
+        SmtpClient::Message *message{nullptr};
+        std::unique_ptr<QFile> file;
+        QString name;
+    };
+    std::vector<Pending> pending;
+    pending.reserve(static_cast<size_t>(messages.size()));
+
+    for (SmtpClient::Message &message : messages) {
+        const QString name = uniqueName();
+        auto file          = std::make_unique<QFile>(tmpDir + name);
+        if (Q_UNLIKELY(!file->open(QIODevice::WriteOnly | QIODevice::NewOnly))) {
+            message.error = u"Failed to create %1: %2"_s.arg(file->fileName(), file->errorString());
+            continue;
+        }
+
+        const QByteArray header = "Return-Path: <"_ba + message.from + ">\nDelivered-To: "_ba + message.to + '\n';
+
+        // files in a Maildir use local line endings
+        QByteArray data = message.data;
+        data.replace("\r\n"_ba, "\n"_ba);
+
+        if (Q_UNLIKELY(file->write(header) != header.size() || file->write(data) != data.size() || !file->flush())) {
+            message.error = u"Failed to write %1: %2"_s.arg(file->fileName(), file->errorString());
+            file->remove();
+            continue;
+        }
+
+        pending.push_back(Pending{&message, std::move(file), name});
+    }
+
+    // sync the whole batch before any of the files becomes visible in new
+    for (Pending &p : pending) {
+        if (Q_UNLIKELY(::fsync(p.file->handle()) != 0)) {
+            p.message->error = u"Failed to sync %1 to disk"_s.arg(p.file->fileName());
+            p.file->remove();
+            p.file.reset();
+        }
+    }
+
+    bool moved = false;
+    for (Pending &p : pending) {
+        if (!p.file) {
+            continue;
+        }
+
+        p.file->close();
+        const QByteArray from = QFile::encodeName(p.file->fileName());
+        const QByteArray to   = QFile::encodeName(newDir + p.name);
+        if (Q_UNLIKELY(std::rename(from.constData(), to.constData()) != 0)) {
+            p.message->error = u"Failed to move %1 into %2"_s.arg(p.file->fileName(), newDir);
+            p.file->remove();
+            continue;
+        }
+
+        p.message->sent = true;
+        moved           = true;
+    }
+
+    if (moved && Q_UNLIKELY(!syncDir(newDir))) {
+        // the messages are already visible, failing them now would only lead to duplicates
+        qCWarning(HBNBOTA_DELIVERY) << "Failed to sync Maildir directory" << newDir << "to disk";
+    }
+}
+
+QString MaildirWriter::uniqueName()
+{
+    static std::atomic<quint64> counter{0};
+
+    const auto now  = std::chrono::system_clock::now().time_since_epoch();
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(now);
+    const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(now - secs);
+
+    // slash and colon are not allowed in the host part, see the Maildir specification
+    QString host = QSysInfo::machineHostName();
+    host.replace('/'_L1, "\\057"_L1);
+    host.replace(':'_L1, "\\072"_L1);
+
+    return u"%1.M%2P%3Q%4.%5"_s.arg(QString::number(secs.count()),
+                                    QString::number(usec.count()),
+                                    QString::number(QCoreApplication::applicationPid()),
+                                    QString::number(counter.fetch_add(1, std::memory_order_relaxed)),
+                                    host);
+}
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_MAILDIRWRITER_H
+#define HBNBOTA_MAILDIRWRITER_H
+
+#include "smtpclient.h"
+
+#include <QList>
+#include <QString>
+
+class Form;
+
+/*!
+ * \brief Stores messages as files in a Maildir.
+ *
+ * Messages are first written into the \c tmp directory and then renamed into the
+ * \c new directory, so readers never see incomplete files. All files of one call to
+ * sendMails() are synced to disk together before they are moved, followed by a single
+ * sync of the \c new directory, instead of syncing after every single file.
+ */
+class MaildirWriter final
+{
+public:
+    /*!
+     * \brief Constructs a new %MaildirWriter for the Maildir at \a path.
+     */
+    explicit MaildirWriter(const QString &path);
+
+    /*!
+     * \brief Returns the path of the Maildir used by \a form below Settings::maildirPath().
+     *
+     * The Maildir is the directory named after the form UUID, or the folder set in the form
+     * settings below that directory.
+     *
+     * Returns an empty string if no Maildir path has been configured.
+     */
+    [[nodiscard]] static QString pathForForm(const Form &form);
+
+    /*!
+     * \brief Returns the path of the Maildir used by \a form below \a base.
+     *
+     * Returns an empty string if \a base is empty.
+     */
+    [[nodiscard]] static QString pathForForm(const QString &base, const Form &form);
+
+    /*!
+     * \brief Stores all \a messages and sets their sent and error members.
+     */
+    void sendMails(QList<SmtpClient::Message> &messages);
+
+private:
+    [[nodiscard]] static QString uniqueName();
+
+    QString m_path;
+};
+
+#endif // HBNBOTA_MAILDIRWRITER_H
@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "mimeassembler.h"
+
+#include <QDateTime>
+#include <QSysInfo>
+#include <QUrl>
+#include <QUuid>
+
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// encoded lines have at most 76 characters including the equals sign of a soft line break
+constexpr int maxQpLineLength{75};
+// 45 bytes of UTF-8 result in 60 Base64 characters, the encoded word stays below 75 characters
+constexpr qsizetype maxEncodedWordBytes{45};
+
+bool isPrintableAscii(const QString &text)
+{
+    return std::ranges::all_of(text, [](QChar ch) { return ch.unicode() >= 0x20 && ch.unicode() <= 0x7E; }) &&
+           !text.contains("=?"_L1);
+}
+
+QByteArray textPart(const QByteArray &type, const QString &content)
+{
+    QByteArray part =
+        "Content-Type: "_ba + type + "; charset=utf-8\r\nContent-Transfer-Encoding: quoted-printable\r\n\r\n"_ba;
+    part += MimeAssembler::quotedPrintable(content.toUtf8());
+    return part;
+}
+} // namespace
+
+QByteArray MimeAssembler::body(const QString &text, const QString &html)
+{
+    const auto key = std::make_pair(text, html);
+    auto it        = m_bodies.constFind(key);
+    if (it != m_bodies.cend()) {
+        return it.value();
+    }
+
+    QByteArray entity;
+    if (!text.isEmpty() && !html.isEmpty()) {
+        // equals signs are always encoded in quoted-printable, so this can never appear in a part
+        const QByteArray boundary = "=_"_ba + QUuid::createUuid().toByteArray(QUuid::Id128);
+        entity = "Content-Type: multipart/alternative; boundary=\""_ba + boundary + "\"\r\n\r\n--"_ba + boundary + "\r\n"_ba;
+        entity += textPart("text/plain"_ba, text);
+        entity += "\r\n--"_ba + boundary + "\r\n"_ba;
+        entity += textPart("text/html"_ba, html);
+        entity += "\r\n--"_ba + boundary + "--\r\n"_ba;
+    } else if (!html.isEmpty()) {
+        entity = textPart("text/html"_ba, html);
+    } else {
+        entity = textPart("text/plain"_ba, text);
+    }
+
+    m_bodies.insert(key, entity);
+    return entity;
+}
+
+QByteArray MimeAssembler::address(const QString &name, const QString &email)
+{
+    const auto key = std::make_pair(name, email);
+    auto it        = m_addresses.constFind(key);
+    if (it != m_addresses.cend()) {
+        return it.value();
+    }
+
+    QByteArray mailbox;
+    if (name.isEmpty()) {
+        mailbox = email.toUtf8();
+    } else {
+        QByteArray phrase;
+        if (isPrintableAscii(name)) {
+            phrase = name.toLatin1();
+            if (phrase.contains('"') || phrase.contains('\\')) {
+                phrase.replace('\\', "\\\\"_ba);
+                phrase.replace('"', "\\\""_ba);
+            }
+            phrase = "\""_ba + phrase + "\""_ba;
+        } else {
+            phrase = encodeWord(name);
+        }
+        mailbox = phrase + " <"_ba + email.toUtf8() + ">"_ba;
+    }
+
+    if (m_addresses.size() >= maxAddresses) {
+        m_addresses.clear();
+    }
+    m_addresses.insert(key, mailbox);
+
+    return mailbox;
+}
+
+QByteArray MimeAssembler::assemble(const QByteArray &from,
+                                   const QByteArray &to,
+                                   const QByteArray &replyTo,
+                                   const QString &subject,
+                                   const QByteArray &messageId,
+                                   const QByteArray &body)
+{
+    const QByteArray encodedSubject = encodeWord(subject);
+    const QByteArray date           = QDateTime::currentDateTime().toString(Qt::RFC2822Date).toLatin1();
+
+    QByteArray data;
+    data.reserve(from.size() + to.size() + replyTo.size() + encodedSubject.size() + date.size() + messageId.size()
+                 + body.size() + 80);
+    data += "From: "_ba + from + "\r\nTo: "_ba + to + "\r\n"_ba;
+    if (!replyTo.isEmpty()) {
+        data += "Reply-To: "_ba + replyTo + "\r\n"_ba;
+    }
+    data += "Subject: "_ba + encodedSubject + "\r\nDate: "_ba + date + "\r\n"_ba;
+    if (!messageId.isEmpty()) {
+        data += "Message-ID: "_ba + messageId + "\r\n"_ba;
+    }
+    data += "MIME-Version: 1.0\r\n"_ba;
+    data += body;
+
+    return data;
+}
+
+QByteArray MimeAssembler::messageId(const QString &fromEmail)
+{
+    // IDN domains are used in their ASCII form, header fields are ASCII only
+    QByteArray domain = QUrl::toAce(fromEmail.sliced(fromEmail.lastIndexOf(u'@') + 1));
+    if (domain.isEmpty()) {
+        domain = QUrl::toAce(QSysInfo::machineHostName());
+        if (domain.isEmpty()) {
+            domain = "localhost"_ba;
+        }
+    }
+
+    return '<' + QUuid::createUuid().toByteArray(QUuid::WithoutBraces) + '@' + domain + '>';
+}
+
+void MimeAssembler::clearBodies()
+{
+    m_bodies.clear();
+}
+
+QByteArray MimeAssembler::quotedPrintable(const QByteArray &data)
+{
+    static constexpr char hex[] = "0123456789ABCDEF";
+
+    QByteArray out;
+    out.reserve(data.size() + data.size() / 8 + 16);
+    int lineLength = 0;
+
+    const auto append = [&out, &lineLength](const char *token, int length) {
+        if (lineLength + length > maxQpLineLength) {
+            out.append("=\r\n");
+            lineLength = 0;
+        }
+        out.append(token, length);
+        lineLength += length;
+    };
+
+    const qsizetype size = data.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        const auto c = static_cast<uchar>(data.at(i));
+
+        if (c == '\r' && i + 1 < size && data.at(i + 1) == '\n') {
+            continue;
+        }
+
+        if (c == '\n') {
+            out.append("\r\n");
+            lineLength = 0;
+            continue;
+        }
+
+        // whitespace at the end of a line would be removed in transport
+        const bool lineEnd = i + 1 == size || data.at(i + 1) == '\n' ||
+                             (data.at(i + 1) == '\r' && i + 2 < size && data.at(i + 2) == '\n');
+
+        if ((c >= 33 && c <= 126 && c != '=') || ((c == ' ' || c == '\t') && !lineEnd)) {
+            const char ch = static_cast<char>(c);
+            append(&ch, 1);
+        } else {
+            const char token[3] = {'=', hex[c >> 4], hex[c & 0x0F]};
+            append(token, 3);
+        }
+    }
+
+    return out;
+}
+
+QByteArray MimeAssembler::encodeWord(const QString &text)
+{
+    if (isPrintableAscii(text)) {
+        return text.toLatin1();
+    }
+
+    const QByteArray utf8 = text.toUtf8();
+
+    QByteArray out;
+    out.reserve(utf8.size() * 2);
+
+    qsizetype pos = 0;
+    while (pos < utf8.size()) {
+        qsizetype length = std::min(maxEncodedWordBytes, utf8.size() - pos);
+        // do not split multibyte characters between encoded words
+        while (pos + length < utf8.size() && length > 1 && (static_cast<uchar>(utf8.at(pos + length)) & 0xC0) == 0x80) {
+            --length;
+        }
+
+        if (!out.isEmpty()) {
+            out += "\r\n "_ba;
+        }
+        out += "=?utf-8?B?"_ba + utf8.mid(pos, length).toBase64() + "?="_ba;
+
+        pos += length;
+    }
+
+    return out;
+}
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_MIMEASSEMBLER_H
+#define HBNBOTA_MIMEASSEMBLER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include <utility>
+
+/*!
+ * \brief Assembles MIME messages from encoded fragments that are shared between messages.
+ *
+ * When a submission is sent to several recipients, most of the messages are the same:
+ * the bodies are rendered from the same submission values and the sender addresses are
+ * often the same. The assembler encodes every distinct body only once into a complete
+ * MIME entity and every distinct address only once into an RFC 2047 header fragment.
+ * Encoded fragments are implicitly shared QByteArrays, so a body used for several
+ * recipients only exists once in memory until the messages are assembled.
+ *
+ * Bodies are cached until clearBodies() is called, usually after all messages for one
+ * submission or digest have been built. Encoded addresses are kept across submissions
+ * up to maxAddresses entries.
+ *
+ * Text parts are encoded as quoted-printable UTF-8, all lines end with CRLF.
+ */
+class MimeAssembler final
+{
+public:
+    /*!
+     * \brief Maximum number of encoded addresses kept in the cache.
+     */
+    static constexpr qsizetype maxAddresses{1024};
+
+    /*!
+     * \brief Returns the encoded MIME entity for the \a text and \a html bodies.
+     *
+     * If both are not empty, the entity is a multipart/alternative with both parts.
+     * The entity contains its own content headers, followed by an empty line and the
+     * encoded content. Calling this again with the same bodies returns the cached entity.
+     */
+    [[nodiscard]] QByteArray body(const QString &text, const QString &html);
+
+    /*!
+     * \brief Returns the encoded mailbox for \a email with the display \a name.
+     */
+    [[nodiscard]] QByteArray address(const QString &name, const QString &email);
+
+    /*!
+     * \brief Returns the complete message with the given headers and the encoded \a body.
+     *
+     * \a from, \a to and \a replyTo have to be encoded by address(), \a replyTo is omitted
+     * if it is empty. \a messageId should be created by messageId(). \a body has to be returned
+     * by body().
+     */
+    [[nodiscard]] static QByteArray assemble(const QByteArray &from,
+                                             const QByteArray &to,
+                                             const QByteArray &replyTo,
+                                             const QString &subject,
+                                             const QByteArray &messageId,
+                                             const QByteArray &body);
+
+    /*!
+     * \brief Returns a new unique Message-ID with the domain of \a fromEmail, including the angle brackets.
+     */
+    [[nodiscard]] static QByteArray messageId(const QString &fromEmail);
+
+    /*!
+     * \brief Removes all cached bodies.
+     */
+    void clearBodies();
+
+    /*!
+     * \brief Returns the number of distinct bodies encoded since the last clearBodies().
+     */
+    [[nodiscard]] qsizetype bodyCount() const noexcept { return m_bodies.size(); }
+
+    /*!
+     * \brief Encodes \a data as quoted-printable with CRLF line endings.
+     */
+    [[nodiscard]] static QByteArray quotedPrintable(const QByteArray &data);
+
+    /*!
+     * \brief Encodes \a text for use in a header according to RFC 2047.
+     *
+     * Printable ASCII text is returned unchanged, everything else is encoded as
+     * Base64 encoded words folded onto continuation lines.
+     */
+    [[nodiscard]] static QByteArray encodeWord(const QString &text);
+
+private:
+    QHash<std::pair<QString, QString>, QByteArray> m_bodies;
+    QHash<std::pair<QString, QString>, QByteArray> m_addresses;
+};
+
+#endif // HBNBOTA_MIMEASSEMBLER_H
@@ -0,0 +1,362 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "outbox.h"
+
+#include "logging.h"
+
+#include <Cutelyst/Plugins/Utils/Sql>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+using namespace Qt::Literals::StringLiterals;
+
+bool Outbox::lease(Submission::dbid_t id, const QString &leaser, std::chrono::seconds duration)
+{
+    QSqlQuery q = CPreparedSqlQueryThread(
+        u"UPDATE outbox SET leasedBy = :leasedBy, leasedUntil = :leasedUntil, attempts = attempts + 1 WHERE id = :id "
+        "AND (leasedUntil IS NULL OR leasedUntil < :now) AND (nextAttempt IS NULL OR nextAttempt <= :now)"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to lease outbox entry" << id << "in database:" << q.lastError().text();
+        return false;
+    }
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    q.bindValue(u":leasedBy"_s, leaser);
+    q.bindValue(u":leasedUntil"_s, now.addSecs(duration.count()));
+    q.bindValue(u":id"_s, id);
+    q.bindValue(u":now"_s, now);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to lease outbox entry" << id << "in database:" << q.lastError().text();
+        return false;
+    }
+
+    return q.numRowsAffected() == 1;
+}
+
+QList<Outbox::Entry> Outbox::leaseNext(const QString &leaser, std::chrono::seconds duration, int limit)
+{
+    QSqlQuery q = CPreparedSqlQueryThreadFO(
+        u"SELECT id FROM outbox WHERE (leasedUntil IS NULL OR leasedUntil < :now) "
+        "AND (nextAttempt IS NULL OR nextAttempt <= :now) ORDER BY id LIMIT :limit"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query outbox entries from database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":now"_s, QDateTime::currentDateTimeUtc());
+    q.bindValue(u":limit"_s, limit);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query outbox entries from database:" << q.lastError().text();
+        return {};
+    }
+
+    // the result set has to be read completely before the lease queries are executed
+    QList<Submission::dbid_t> ids;
+    while (q.next()) {
+        ids << Submission::toDbId(q.value(0));
+    }
+
+    QList<Entry> entries;
+    entries.reserve(ids.size());
+
+    for (const Submission::dbid_t id : std::as_const(ids)) {
+        if (!Outbox::lease(id, leaser, duration)) {
+            // another thread has been faster
+            continue;
+        }
+
+        bool ok     = false;
+        Entry entry = Outbox::get(id, &ok);
+        if (ok) {
+            entry.leasedBy = leaser;
+            entries << entry;
+        }
+    }
+
+    return entries;
+}
+
+QList<Outbox::Entry> Outbox::leaseDue(Form::dbid_t formId, const QString &leaser, std::chrono::seconds duration)
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    QSqlQuery q = CPreparedSqlQueryThread(
+        u"UPDATE outbox SET leasedBy = :leasedBy, leasedUntil = :leasedUntil, attempts = attempts + 1 "
+        "WHERE formId = :formId AND (leasedUntil IS NULL OR leasedUntil < :now) "
+        "AND (nextAttempt IS NULL OR nextAttempt <= :now)"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to lease due outbox entries of form" << formId
+                                     << "in database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":leasedBy"_s, leaser);
+    q.bindValue(u":leasedUntil"_s, now.addSecs(duration.count()));
+    q.bindValue(u":formId"_s, formId);
+    q.bindValue(u":now"_s, now);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to lease due outbox entries of form" << formId
+                                     << "in database:" << q.lastError().text();
+        return {};
+    }
+
+    q = CPreparedSqlQueryThreadFO(
+        u"SELECT id FROM outbox WHERE formId = :formId AND leasedBy = :leasedBy AND leasedUntil >= :now ORDER BY id"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query leased outbox entries of form" << formId
+                                     << "from database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":formId"_s, formId);
+    q.bindValue(u":leasedBy"_s, leaser);
+    q.bindValue(u":now"_s, now);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query leased outbox entries of form" << formId
+                                     << "from database:" << q.lastError().text();
+        return {};
+    }
+
+    QList<Submission::dbid_t> ids;
+    while (q.next()) {
+        ids << Submission::toDbId(q.value(0));
+    }
+
+    QList<Entry> entries;
+    entries.reserve(ids.size());
+
+    for (const Submission::dbid_t id : std::as_const(ids)) {
+        bool ok     = false;
+        Entry entry = Outbox::get(id, &ok);
+        if (ok) {
+            entry.leasedBy = leaser;
+            entries << entry;
+        }
+    }
+
+    return entries;
+}
+
+Outbox::Entry Outbox::get(Submission::dbid_t id, bool *ok)
+{
+    if (ok) {
+        *ok = false;
+    }
+
+    QSqlQuery q = CPreparedSqlQueryThreadFO(
+        u"SELECT formId, data, remoteAddress, created, attempts, delivered FROM outbox WHERE id = :id"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query outbox entry" << id << "from database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":id"_s, id);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query outbox entry" << id << "from database:" << q.lastError().text();
+        return {};
+    }
+
+    if (Q_UNLIKELY(!q.next())) {
+        qCWarning(HBNBOTA_DELIVERY) << "Can not find outbox entry" << id << "in the database";
+        return {};
+    }
+
+    const auto formId = Form::toDbId(q.value(0));
+    const Form form   = Form::get(formId);
+    if (Q_UNLIKELY(form.isNull())) {
+        qCWarning(HBNBOTA_DELIVERY) << "Can not find form with ID" << formId << "for outbox entry" << id;
+        return {};
+    }
+
+    Entry entry;
+    entry.submission = Submission{id,
+                                  form,
+                                  QJsonDocument::fromJson(q.value(1).toByteArray()).object().toVariantMap(),
+                                  q.value(2).toString(),
+                                  q.value(3).toDateTime()};
+    entry.attempts   = q.value(4).toInt();
+
+    const QJsonArray delivered = QJsonDocument::fromJson(q.value(5).toByteArray()).array();
+    entry.delivered.reserve(delivered.size());
+    for (const auto &rid : delivered) {
+        entry.delivered << Recipient::toDbId(rid.toVariant());
+    }
+
+    if (ok) {
+        *ok = true;
+    }
+
+    return entry;
+}
+
+QList<Outbox::Schedule> Outbox::schedules()
+{
+    QSqlQuery q = CPreparedSqlQueryThreadFO(
+        u"SELECT id, nextAttempt FROM outbox WHERE leasedUntil IS NULL OR leasedUntil < :now"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query outbox schedules from database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":now"_s, QDateTime::currentDateTimeUtc());
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query outbox schedules from database:" << q.lastError().text();
+        return {};
+    }
+
+    QList<Schedule> lst;
+    if (q.size() > 0) {
+        lst.reserve(q.size());
+    }
+
+    while (q.next()) {
+        QDateTime nextAttempt = q.value(1).toDateTime();
+        if (nextAttempt.isValid()) {
+            nextAttempt.setTimeSpec(Qt::UTC);
+        }
+        lst << Schedule{Submission::toDbId(q.value(0)), nextAttempt};
+    }
+
+    return lst;
+}
+
+bool Outbox::complete(const Entry &entry)
+{
+    const Submission &s = entry.submission;
+
+    QSqlDatabase db = Cutelyst::Sql::databaseThread();
+    if (Q_UNLIKELY(!db.transaction())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to start database transaction to complete" << s << ':'
+                                     << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery q = CPreparedSqlQueryThread(u"INSERT INTO submissions (formId, data, remoteAddress, created) "
+                                          "VALUES (:formId, :data, :remoteAddress, :created)"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to archive" << s << "in database:" << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    q.bindValue(u":formId"_s, s.form().id());
+    q.bindValue(u":data"_s, QJsonDocument(s.toJson()).toJson(QJsonDocument::Compact));
+    q.bindValue(u":remoteAddress"_s, s.remoteAddress());
+    q.bindValue(u":created"_s, s.created());
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to archive" << s << "in database:" << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    q = CPreparedSqlQueryThread(u"DELETE FROM outbox WHERE id = :id AND leasedBy = :leasedBy"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to remove" << s << "from outbox:" << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    q.bindValue(u":id"_s, s.id());
+    q.bindValue(u":leasedBy"_s, entry.leasedBy);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to remove" << s << "from outbox:" << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    // the lease expired and another thread has leased the entry, that one will archive it
+    if (Q_UNLIKELY(q.numRowsAffected() != 1)) {
+        qCWarning(HBNBOTA_DELIVERY) << "Can not complete" << s << "because the lease has been lost";
+        db.rollback();
+        return false;
+    }
+
+    if (Q_UNLIKELY(!db.commit())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to commit database transaction to complete" << s << ':'
+                                     << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    return true;
+}
+
+bool Outbox::release(const Entry &entry, const QString &error, const QDateTime &nextAttempt)
+{
+    QSqlQuery q = CPreparedSqlQueryThread(
+        u"UPDATE outbox SET leasedBy = NULL, leasedUntil = NULL, nextAttempt = :nextAttempt, delivered = :delivered, "
+        "lastError = :lastError WHERE id = :id AND leasedBy = :leasedBy"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to release" << entry.submission
+                                     << "in outbox:" << q.lastError().text();
+        return false;
+    }
+
+    QJsonArray delivered;
+    for (const Recipient::dbid_t rid : entry.delivered) {
+        delivered.append(static_cast<qint64>(rid));
+    }
+
+    q.bindValue(u":nextAttempt"_s, nextAttempt);
+    q.bindValue(u":delivered"_s, QJsonDocument(delivered).toJson(QJsonDocument::Compact));
+    q.bindValue(u":lastError"_s, error);
+    q.bindValue(u":id"_s, entry.submission.id());
+    q.bindValue(u":leasedBy"_s, entry.leasedBy);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to release" << entry.submission
+                                     << "in outbox:" << q.lastError().text();
+        return false;
+    }
+
+    if (Q_UNLIKELY(q.numRowsAffected() != 1)) {
+        qCWarning(HBNBOTA_DELIVERY) << "Can not release" << entry.submission << "because the lease has been lost";
+        return false;
+    }
+
+    return true;
+}
+
+bool Outbox::defer(const Entry &entry, const QDateTime &nextAttempt)
+{
+    QSqlQuery q = CPreparedSqlQueryThread(
+        u"UPDATE outbox SET leasedBy = NULL, leasedUntil = NULL, nextAttempt = :nextAttempt, "
+        "attempts = CASE WHEN attempts > 0 THEN attempts - 1 ELSE 0 END WHERE id = :id AND leasedBy = :leasedBy"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to defer" << entry.submission << "in outbox:" << q.lastError().text();
+        return false;
+    }
+
+    q.bindValue(u":nextAttempt"_s, nextAttempt);
+    q.bindValue(u":id"_s, entry.submission.id());
+    q.bindValue(u":leasedBy"_s, entry.leasedBy);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to defer" << entry.submission << "in outbox:" << q.lastError().text();
+        return false;
+    }
+
+    if (Q_UNLIKELY(q.numRowsAffected() != 1)) {
+        qCWarning(HBNBOTA_DELIVERY) << "Can not defer" << entry.submission << "because the lease has been lost";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_OUTBOX_H
+#define HBNBOTA_OUTBOX_H
+
+#include "objects/recipient.h"
+#include "objects/submission.h"
+
+#include <QDateTime>
+#include <QList>
+
+#include <chrono>
+
+/*!
+ * \brief Database backed queue of submissions that still have to be delivered.
+ *
+ * New submissions are stored in the outbox table. Delivery threads lease entries
+ * for a limited time before they send the messages. After all recipients have been
+ * served, the entry is moved into the submissions table. Entries whose lease has
+ * expired, for example because the process died while sending, will be leased
+ * again by any other delivery thread. Entries that failed can not be leased again
+ * before their next attempt time.
+ */
+namespace Outbox {
+
+/*!
+ * \brief A leased outbox entry.
+ */
+struct Entry {
+    Submission submission;
+    /*!
+     * \brief IDs of the recipients that already got their message in a previous attempt.
+     */
+    QList<Recipient::dbid_t> delivered;
+    /*!
+     * \brief Name of the delivery thread that holds the lease.
+     */
+    QString leasedBy;
+    int attempts{0};
+};
+
+/*!
+ * \brief Time of the next delivery attempt for an outbox entry.
+ */
+struct Schedule {
+    Submission::dbid_t id{0};
+    /*!
+     * \brief Invalid if the entry has not been tried before.
+     */
+    QDateTime nextAttempt;
+};
+
+/*!
+ * \brief Leases the outbox entry identified by \a id for \a leaser.
+ *
+ * Returns \c true if the entry is now leased by \a leaser for \a duration, otherwise
+ * \c false, e.g. if it is leased by another thread or if it does not exist anymore.
+ */
+bool lease(Submission::dbid_t id, const QString &leaser, std::chrono::seconds duration);
+
+/*!
+ * \brief Leases up to \a limit available outbox entries for \a leaser and returns them.
+ */
+QList<Entry> leaseNext(const QString &leaser, std::chrono::seconds duration, int limit);
+
+/*!
+ * \brief Leases all due outbox entries of the form \a formId for \a leaser.
+ *
+ * Returns these entries together with the entries of the form that are already
+ * leased by \a leaser. This is used to collect the submissions for a digest.
+ */
+QList<Entry> leaseDue(Form::dbid_t formId, const QString &leaser, std::chrono::seconds duration);
+
+/*!
+ * \brief Returns the leased outbox entry identified by \a id.
+ *
+ * If \a ok is not \c nullptr, failure is reported by setting \a *ok to \c false,
+ * and success by setting \a *ok to \c true.
+ */
+Entry get(Submission::dbid_t id, bool *ok = nullptr);
+
+/*!
+ * \brief Returns the schedules of all outbox entries that are not leased.
+ *
+ * This is used to resume the retry schedule after a restart.
+ */
+QList<Schedule> schedules();
+
+/*!
+ * \brief Moves the delivered \a entry from the outbox into the submissions table.
+ *
+ * Returns \c false and changes nothing if the lease for \a entry has been lost,
+ * e.g. because it has expired and the entry has been leased by another thread.
+ */
+bool complete(const Entry &entry);
+
+/*!
+ * \brief Releases the lease for \a entry that could not be delivered completely.
+ *
+ * The entry will not be leased again before \a nextAttempt. \a error will be stored
+ * as the reason of the last failure. Returns \c false if the lease for \a entry has
+ * been lost.
+ */
+bool release(const Entry &entry, const QString &error, const QDateTime &nextAttempt);
+
+/*!
+ * \brief Releases the lease for \a entry that has not been tried to deliver.
+ *
+ * Other than release(), this does not count the lease as delivery attempt. It is
+ * used if the mail server of the entry is currently throttled. The entry will not
+ * be leased again before \a nextAttempt. Returns \c false if the lease for \a entry
+ * has been lost.
+ */
+bool defer(const Entry &entry, const QDateTime &nextAttempt);
+
+} // namespace Outbox
+
+#endif // HBNBOTA_OUTBOX_H
@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "relaylimiter.h"
+
+#include "objects/form.h"
+
+#include <QGlobalStatic>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// wait time if all sessions of a relay are in use, the next one is most likely released after a few sends
+constexpr std::chrono::milliseconds sessionWait{500};
+
+// 0 means unlimited, so it is only used if both values are 0
+template <typename T>
+T mostRestrictive(T a, T b)
+{
+    if (a <= 0) {
+        return b;
+    }
+    if (b <= 0) {
+        return a;
+    }
+    return std::min(a, b);
+}
+} // namespace
+
+Q_GLOBAL_STATIC(RelayLimiter, relayLimiter) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+RelayLimiter::Limits RelayLimiter::Limits::fromForm(const Form &form)
+{
+    const auto mailer = form.settings().value(u"mailer"_s).toMap();
+
+    Limits limits;
+    limits.rate        = std::max(mailer.value(u"rateLimit"_s).toDouble(), 0.0);
+    limits.maxSessions = std::max(mailer.value(u"maxSessions"_s).toInt(), 0);
+    return limits;
+}
+
+std::chrono::milliseconds RelayLimiter::delay(const QString &relay, const Limits &limits, clock::time_point now)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Bucket &bucket            = m_buckets[relay];
+    bucket.limits.rate        = mostRestrictive(bucket.limits.rate, limits.rate);
+    bucket.limits.maxSessions = mostRestrictive(bucket.limits.maxSessions, limits.maxSessions);
+
+    return delay(bucket, now);
+}
+
+bool RelayLimiter::tryAcquire(const QString &relay,
+                              const Limits &limits,
+                              qsizetype messages,
+                              std::chrono::milliseconds *wait,
+                              clock::time_point now)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Bucket &bucket            = m_buckets[relay];
+    bucket.limits.rate        = mostRestrictive(bucket.limits.rate, limits.rate);
+    bucket.limits.maxSessions = mostRestrictive(bucket.limits.maxSessions, limits.maxSessions);
+
+    const auto d = delay(bucket, now);
+    if (d > std::chrono::milliseconds::zero()) {
+        if (wait) {
+            *wait = d;
+        }
+        return false;
+    }
+
+    if (bucket.limits.rate > 0.0) {
+        bucket.tokens -= static_cast<double>(messages);
+    }
+    ++bucket.sessions;
+
+    return true;
+}
+
+void RelayLimiter::release(const QString &relay)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_buckets.find(relay);
+    if (it != m_buckets.end() && it->sessions > 0) {
+        --it->sessions;
+    }
+}
+
+RelayLimiter *RelayLimiter::instance()
+{
+    return relayLimiter;
+}
+
+std::chrono::milliseconds RelayLimiter::delay(Bucket &bucket, clock::time_point now) const
+{
+    const Limits &limits = bucket.limits;
+    std::chrono::milliseconds d{0};
+
+    if (limits.rate > 0.0) {
+        // the bucket holds the tokens for one second, but at least one
+        const double capacity = std::max(limits.rate, 1.0);
+        if (!bucket.initialized) {
+            bucket.tokens      = capacity;
+            bucket.refilled    = now;
+            bucket.initialized = true;
+        } else if (now > bucket.refilled) {
+            const std::chrono::duration<double> elapsed = now - bucket.refilled;
+            bucket.tokens   = std::min(bucket.tokens + elapsed.count() * limits.rate, capacity);
+            bucket.refilled = now;
+        }
+
+        if (bucket.tokens < 1.0) {
+            d = std::chrono::milliseconds{static_cast<qint64>(std::ceil((1.0 - bucket.tokens) * 1'000.0 / limits.rate))};
+        }
+    }
+
+    if (limits.maxSessions > 0 && bucket.sessions >= limits.maxSessions) {
+        d = std::max(d, sessionWait);
+    }
+
+    return d;
+}
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_RELAYLIMITER_H
+#define HBNBOTA_RELAYLIMITER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <chrono>
+
+class Form;
+
+/*!
+ * \brief Limits the message rate and the concurrent sessions per mail server.
+ *
+ * Every relay has a token bucket that is refilled with Limits::rate tokens per
+ * second and holds at most the tokens for one second. Sending a batch of messages
+ * needs at least one token, the bucket is then debited with the number of messages
+ * and may go negative, so that the long-term average never exceeds the rate even
+ * if a batch is larger than the bucket. Additionally, at most Limits::maxSessions
+ * deliveries can use the relay at the same time.
+ *
+ * The limits are stored in the mailer settings of a form. Forms that use the same
+ * relay share its bucket and the most restrictive limits seen for the relay apply
+ * to all of them, also to forms without own limits, so that no form can flood a
+ * relay that is throttled for other forms. All functions are thread-safe, instance() returns the limiter shared by all
+ * delivery threads of the process.
+ */
+class RelayLimiter final
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Limits {
+        /*!
+         * \brief Messages per second, \c 0 means unlimited.
+         */
+        double rate{0.0};
+        /*!
+         * \brief Concurrent sessions, \c 0 means unlimited.
+         */
+        int maxSessions{0};
+
+        /*!
+         * \brief Returns the limits stored in the mailer settings of \a form.
+         */
+        [[nodiscard]] static Limits fromForm(const Form &form);
+
+        [[nodiscard]] bool isUnlimited() const noexcept { return rate <= 0.0 && maxSessions <= 0; }
+    };
+
+    RelayLimiter() = default;
+
+    /*!
+     * \brief Returns the time to wait until \a relay can be used again.
+     *
+     * Returns a zero duration if a call to tryAcquire() would succeed now.
+     */
+    [[nodiscard]] std::chrono::milliseconds delay(const QString &relay,
+                                                  const Limits &limits,
+                                                  clock::time_point now = clock::now());
+
+    /*!
+     * \brief Tries to acquire a session on \a relay to send \a messages.
+     *
+     * Returns \c false if the relay is currently throttled, \a wait will then be set to
+     * the time after which the next try might succeed. A successful call has to be
+     * followed by release() after the messages have been sent.
+     */
+    [[nodiscard]] bool tryAcquire(const QString &relay,
+                                  const Limits &limits,
+                                  qsizetype messages,
+                                  std::chrono::milliseconds *wait = nullptr,
+                                  clock::time_point now           = clock::now());
+
+    /*!
+     * \brief Releases the session on \a relay acquired by tryAcquire().
+     */
+    void release(const QString &relay);
+
+    /*!
+     * \brief Returns the limiter shared by all delivery threads of this process.
+     */
+    [[nodiscard]] static RelayLimiter *instance();
+
+private:
+    struct Bucket {
+        Limits limits;
+        clock::time_point refilled;
+        double tokens{0.0};
+        int sessions{0};
+        bool initialized{false};
+    };
+
+    std::chrono::milliseconds delay(Bucket &bucket, clock::time_point now) const;
+
+    QMutex m_mutex;
+    QHash<QString, Bucket> m_buckets;
+};
+
+#endif // HBNBOTA_RELAYLIMITER_H
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "sendmailsender.h"
+
+#include <QProcess>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr int startTimeoutMSecs  = 15'000;
+constexpr int finishTimeoutMSecs = 60'000;
+} // namespace
+
+SendmailSender::SendmailSender(const QString &program)
+    : m_program{program}
+{
+}
+
+void SendmailSender::sendMails(QList<SmtpClient::Message> &messages)
+{
+    for (SmtpClient::Message &message : messages) {
+        message.sent = send(message);
+    }
+}
+
+bool SendmailSender::send(SmtpClient::Message &message)
+{
+    if (Q_UNLIKELY(m_program.isEmpty())) {
+        message.error = u"No sendmail binary has been configured"_s;
+        return false;
+    }
+
+    // -i: a line with a single dot does not end the message, so no dot-stuffing is needed
+    QProcess proc;
+    proc.start(m_program,
+               {u"-i"_s, u"-f"_s, QString::fromUtf8(message.from), u"--"_s, QString::fromUtf8(message.to)});
+    if (Q_UNLIKELY(!proc.waitForStarted(startTimeoutMSecs))) {
+        message.error = u"Failed to start %1: %2"_s.arg(m_program, proc.errorString());
+        return false;
+    }
+
+    // the MTA expects local line endings
+    QByteArray data = message.data;
+    data.replace("\r\n"_ba, "\n"_ba);
+
+    proc.write(data);
+    proc.closeWriteChannel();
+
+    if (Q_UNLIKELY(!proc.waitForFinished(finishTimeoutMSecs))) {
+        message.error = u"%1 did not finish in time: %2"_s.arg(m_program, proc.errorString());
+        proc.kill();
+        proc.waitForFinished();
+        return false;
+    }
+
+    if (Q_UNLIKELY(proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0)) {
+        message.error = u"%1 failed with exit code %2: %3"_s.arg(
+            m_program, QString::number(proc.exitCode()), QString::fromUtf8(proc.readAllStandardError().trimmed()));
+        return false;
+    }
+
+    return true;
+}
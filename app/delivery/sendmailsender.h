@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_SENDMAILSENDER_H
+#define HBNBOTA_SENDMAILSENDER_H
+
+#include "smtpclient.h"
+
+#include <QList>
+#include <QString>
+
+/*!
+ * \brief Hands messages over to the local MTA by piping them into its sendmail binary.
+ *
+ * Every message is sent by its own sendmail process with the envelope sender and
+ * recipient given on the command line. The path to the binary is configured by
+ * Settings::sendmailPath() and can not be changed per form.
+ */
+class SendmailSender final
+{
+public:
+    explicit SendmailSender(const QString &program);
+
+    /*!
+     * \brief Sends all \a messages and sets their sent and error members.
+     */
+    void sendMails(QList<SmtpClient::Message> &messages);
+
+private:
+    bool send(SmtpClient::Message &message);
+
+    QString m_program;
+};
+
+#endif // HBNBOTA_SENDMAILSENDER_H
@@ -0,0 +1,398 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "smtpclient.h"
+
+#include "objects/form.h"
+
+#include <QMessageAuthenticationCode>
+#include <QSslSocket>
+#include <QSysInfo>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr int connectTimeoutMSecs = 15'000;
+constexpr int commandTimeoutMSecs = 60'000;
+} // namespace
+
+SmtpClient::Config SmtpClient::Config::fromForm(const Form &form)
+{
+    const auto smtp = form.settings().value(u"mailer"_s).toMap().value(u"smtp"_s).toMap();
+
+    Config config;
+    config.host     = smtp.value(u"host"_s).toString();
+    config.port     = static_cast<quint16>(smtp.value(u"port"_s).toUInt());
+    config.user     = smtp.value(u"user"_s).toString();
+    config.password = smtp.value(u"password"_s).toString();
+
+    const QString encryption = smtp.value(u"encryption"_s).toString();
+    if (encryption == "TLS"_L1) {
+        config.encryption = Encryption::Tls;
+    } else if (encryption == "StartTLS"_L1) {
+        config.encryption = Encryption::StartTls;
+    }
+
+    const QString authentication = smtp.value(u"authentication"_s).toString();
+    if (authentication == "PLAIN"_L1) {
+        config.authentication = Authentication::Plain;
+    } else if (authentication == "LOGIN"_L1) {
+        config.authentication = Authentication::Login;
+    } else if (authentication == "CRAM-MD5"_L1) {
+        config.authentication = Authentication::CramMd5;
+    }
+
+    return config;
+}
+
+QString SmtpClient::Config::relay() const
+{
+    return u"%1:%2"_s.arg(host.toLower(), QString::number(port));
+}
+
+SmtpClient::SmtpClient(const Config &config)
+    : m_config{config}
+    , m_socket{std::make_unique<QSslSocket>()}
+{
+}
+
+SmtpClient::~SmtpClient()
+{
+    quit();
+}
+
+bool SmtpClient::connectToServer()
+{
+    m_lastError.clear();
+
+    if (m_config.encryption == Encryption::Tls) {
+        m_socket->connectToHostEncrypted(m_config.host, m_config.port);
+        if (Q_UNLIKELY(!m_socket->waitForEncrypted(connectTimeoutMSecs))) {
+            setError(u"Failed to establish encrypted connection to %1:%2: %3"_s.arg(
+                m_config.host, QString::number(m_config.port), m_socket->errorString()));
+            abort();
+            return false;
+        }
+    } else {
+        m_socket->connectToHost(m_config.host, m_config.port);
+        if (Q_UNLIKELY(!m_socket->waitForConnected(connectTimeoutMSecs))) {
+            setError(u"Failed to connect to %1:%2: %3"_s.arg(
+                m_config.host, QString::number(m_config.port), m_socket->errorString()));
+            abort();
+            return false;
+        }
+    }
+
+    if (Q_UNLIKELY(!readResponse(220))) {
+        abort();
+        return false;
+    }
+
+    if (Q_UNLIKELY(!ehlo())) {
+        abort();
+        return false;
+    }
+
+    if (m_config.encryption == Encryption::StartTls) {
+        if (Q_UNLIKELY(!startTls() || !ehlo())) {
+            abort();
+            return false;
+        }
+    }
+
+    if (m_config.authentication != Authentication::None) {
+        if (Q_UNLIKELY(!authenticate())) {
+            abort();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SmtpClient::sendMails(QList<Message> &messages)
+{
+    // with pipelining the reset does not cost an extra round trip
+    const bool pipelining = m_extensions.contains("PIPELINING"_ba);
+
+    for (qsizetype i = 0; i < messages.size(); ++i) {
+        Message &message = messages[i];
+        m_lastError.clear();
+
+        if (Q_UNLIKELY(!isConnected())) {
+            message.error = u"Not connected to %1:%2"_s.arg(m_config.host, QString::number(m_config.port));
+            continue;
+        }
+
+        message.sent = transaction(message, m_dirty || (pipelining && i > 0));
+        m_dirty      = !message.sent;
+        if (!message.sent) {
+            message.error = m_lastError;
+        }
+    }
+}
+
+bool SmtpClient::transaction(Message &message, bool reset)
+{
+    const QByteArray mailFrom = "MAIL FROM:<"_ba + message.from + ">\r\n"_ba;
+    const QByteArray rcptTo   = "RCPT TO:<"_ba + message.to + ">\r\n"_ba;
+
+    if (!m_extensions.contains("PIPELINING"_ba)) {
+        if (reset && !sendCommand("RSET"_ba, 250)) {
+            return false;
+        }
+        if (!write(mailFrom) || !readResponse(250) || !write(rcptTo)) {
+            return false;
+        }
+        if (!readResponse(250)) {
+            message.rejected = m_responseCode / 100 == 5;
+            return false;
+        }
+        return sendCommand("DATA"_ba, 354) && sendData(message.data);
+    }
+
+    // RFC 2920: send the envelope at once, then read all responses in order
+    QByteArray commands;
+    if (reset) {
+        commands.append("RSET\r\n"_ba);
+    }
+    commands.append(mailFrom);
+    commands.append(rcptTo);
+    commands.append("DATA\r\n"_ba);
+
+    if (!write(commands)) {
+        return false;
+    }
+
+    QString error;
+    const auto check = [this, &error](int expectedCode) {
+        if (!readResponse(expectedCode) && error.isEmpty()) {
+            error = m_lastError;
+        }
+        return isConnected();
+    };
+
+    if ((reset && !check(250)) || !check(250)) {
+        return false;
+    }
+
+    // only a refused recipient of an accepted sender is a permanent failure of the address
+    const bool senderAccepted = error.isEmpty();
+    if (!check(250)) {
+        return false;
+    }
+    message.rejected = senderAccepted && !error.isEmpty() && m_responseCode / 100 == 5;
+
+    const bool dataAccepted = readResponse(354);
+    if (!dataAccepted && error.isEmpty()) {
+        error = m_lastError;
+    }
+
+    if (!error.isEmpty()) {
+        if (dataAccepted) {
+            // never finish a transaction with an empty message, drop the session instead
+            abort();
+        }
+        m_lastError = error;
+        return false;
+    }
+
+    return sendData(message.data);
+}
+
+bool SmtpClient::sendData(const QByteArray &data)
+{
+    // transparency procedure, see RFC 5321 section 4.5.2
+    QByteArray stuffed = data;
+    stuffed.replace("\r\n."_ba, "\r\n.."_ba);
+    if (stuffed.startsWith('.')) {
+        stuffed.prepend('.');
+    }
+    if (!stuffed.endsWith("\r\n"_ba)) {
+        stuffed.append("\r\n"_ba);
+    }
+    stuffed.append(".\r\n"_ba);
+
+    return write(stuffed) && readResponse(250);
+}
+
+bool SmtpClient::noop()
+{
+    return isConnected() && sendCommand("NOOP"_ba, 250);
+}
+
+void SmtpClient::quit()
+{
+    if (isConnected()) {
+        if (write("QUIT\r\n"_ba)) {
+            std::ignore = readResponse(221);
+        }
+        m_socket->disconnectFromHost();
+    }
+    abort();
+}
+
+bool SmtpClient::isConnected() const
+{
+    return m_socket && m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+bool SmtpClient::ehlo()
+{
+    QString name = QSysInfo::machineHostName();
+    if (name.isEmpty()) {
+        name = u"localhost"_s;
+    }
+
+    if (!sendCommand("EHLO "_ba + name.toLatin1(), 250)) {
+        return false;
+    }
+
+    m_extensions.clear();
+    m_authMethods.clear();
+
+    // the first line is the greeting
+    for (qsizetype i = 1; i < m_responseLines.size(); ++i) {
+        const QByteArrayList parts = m_responseLines.at(i).toUpper().split(' ');
+        m_extensions << parts.first();
+        if (parts.first() == "AUTH"_ba) {
+            m_authMethods << parts.mid(1);
+        }
+    }
+
+    return true;
+}
+
+bool SmtpClient::startTls()
+{
+    if (Q_UNLIKELY(!m_extensions.contains("STARTTLS"_ba))) {
+        setError(u"Server %1 does not support STARTTLS"_s.arg(m_config.host));
+        return false;
+    }
+
+    if (!sendCommand("STARTTLS"_ba, 220)) {
+        return false;
+    }
+
+    m_socket->startClientEncryption();
+    if (Q_UNLIKELY(!m_socket->waitForEncrypted(connectTimeoutMSecs))) {
+        setError(u"Failed to start encryption with %1: %2"_s.arg(m_config.host, m_socket->errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+bool SmtpClient::authenticate()
+{
+    const QByteArray user     = m_config.user.toUtf8();
+    const QByteArray password = m_config.password.toUtf8();
+
+    switch (m_config.authentication) {
+    case Authentication::Plain:
+    {
+        const QByteArray credentials = '\0' + user + '\0' + password;
+        return sendCommand("AUTH PLAIN "_ba + credentials.toBase64(), 235);
+    }
+    case Authentication::Login:
+        return sendCommand("AUTH LOGIN"_ba, 334) && sendCommand(user.toBase64(), 334) &&
+               sendCommand(password.toBase64(), 235);
+    case Authentication::CramMd5:
+    {
+        if (!sendCommand("AUTH CRAM-MD5"_ba, 334)) {
+            return false;
+        }
+        const QByteArray challenge = QByteArray::fromBase64(m_responseLines.value(0));
+        const QByteArray digest =
+            QMessageAuthenticationCode::hash(challenge, password, QCryptographicHash::Md5).toHex();
+        const QByteArray response = user + ' ' + digest;
+        return sendCommand(response.toBase64(), 235);
+    }
+    case Authentication::None:
+        break;
+    }
+
+    return true;
+}
+
+bool SmtpClient::sendCommand(const QByteArray &command, int expectedCode)
+{
+    return write(command + "\r\n"_ba) && readResponse(expectedCode);
+}
+
+bool SmtpClient::write(const QByteArray &data)
+{
+    if (Q_UNLIKELY(m_socket->write(data) != data.size())) {
+        setError(u"Failed to write to %1: %2"_s.arg(m_config.host, m_socket->errorString()));
+        abort();
+        return false;
+    }
+
+    while (m_socket->bytesToWrite() > 0) {
+        if (Q_UNLIKELY(!m_socket->waitForBytesWritten(commandTimeoutMSecs))) {
+            setError(u"Failed to write to %1: %2"_s.arg(m_config.host, m_socket->errorString()));
+            abort();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SmtpClient::readResponse(int expectedCode)
+{
+    m_responseLines.clear();
+    m_responseCode = 0;
+
+    for (;;) {
+        while (!m_socket->canReadLine()) {
+            if (Q_UNLIKELY(!m_socket->waitForReadyRead(commandTimeoutMSecs))) {
+                setError(u"Failed to read response from %1: %2"_s.arg(m_config.host, m_socket->errorString()));
+                abort();
+                return false;
+            }
+        }
+
+        const QByteArray line = m_socket->readLine();
+        bool ok               = false;
+        const int code        = line.left(3).toInt(&ok);
+        if (Q_UNLIKELY(!ok || line.size() < 4)) {
+            setError(u"Invalid response from %1: %2"_s.arg(m_config.host, QString::fromLatin1(line.trimmed())));
+            abort();
+            return false;
+        }
+
+        m_responseLines << line.mid(4).trimmed();
+
+        // multiline responses use a hyphen after the code on all but the last line
+        if (line.at(3) != '-') {
+            m_responseCode = code;
+            break;
+        }
+    }
+
+    // only compare the reply class, e.g. 251 is as good as 250
+    if (Q_UNLIKELY(m_responseCode / 100 != expectedCode / 100)) {
+        setError(u"Unexpected response from %1: %2 %3"_s.arg(
+            m_config.host, QString::number(m_responseCode), QString::fromUtf8(m_responseLines.join(' '))));
+        return false;
+    }
+
+    m_lastUsed = std::chrono::steady_clock::now();
+
+    return true;
+}
+
+void SmtpClient::setError(const QString &error)
+{
+    m_lastError = error;
+}
+
+void SmtpClient::abort()
+{
+    if (m_socket) {
+        m_socket->abort();
+    }
+}
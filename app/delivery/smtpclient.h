@@ -0,0 +1,138 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_SMTPCLIENT_H
+#define HBNBOTA_SMTPCLIENT_H
+
+#include <QByteArrayList>
+#include <QList>
+#include <QString>
+
+#include <chrono>
+#include <memory>
+
+class Form;
+class QSslSocket;
+
+/*!
+ * \brief Blocking SMTP client that keeps its session open between messages.
+ *
+ * Objects of this class are used by the delivery threads. They are not thread-safe
+ * and have to be used in the thread they have been created in.
+ */
+class SmtpClient final
+{
+public:
+    enum class Encryption : quint8 { None, StartTls, Tls };
+
+    enum class Authentication : quint8 { None, Plain, Login, CramMd5 };
+
+    /*!
+     * \brief Connection settings for a SMTP server.
+     *
+     * Clients with equal configuration can be reused for each other.
+     */
+    struct Config {
+        QString host;
+        QString user;
+        QString password;
+        quint16 port{25};
+        Encryption encryption{Encryption::None};
+        Authentication authentication{Authentication::None};
+
+        /*!
+         * \brief Returns the configuration stored in the mailer settings of \a form.
+         */
+        static Config fromForm(const Form &form);
+
+        /*!
+         * \brief Returns the identifier of the mail server used for rate limiting.
+         */
+        [[nodiscard]] QString relay() const;
+
+        bool operator==(const Config &other) const = default;
+    };
+
+    /*!
+     * \brief An already encoded message and its envelope.
+     */
+    struct Message {
+        QByteArray from;
+        QByteArray to;
+        QByteArray data;
+        QString error;
+        bool sent{false};
+        // the server permanently refused the recipient address
+        bool rejected{false};
+    };
+
+    explicit SmtpClient(const Config &config);
+    ~SmtpClient();
+
+    /*!
+     * \brief Connects to the server, negotiates encryption and authenticates.
+     */
+    [[nodiscard]] bool connectToServer();
+
+    /*!
+     * \brief Sends all \a messages over the current session.
+     *
+     * Each message is sent in its own mail transaction, separated by RSET. If the
+     * server supports PIPELINING, the envelope commands of a transaction are sent
+     * in one batch. The result for every message will be written to its \a sent
+     * and \a error members, \a rejected is set if the server refused the recipient
+     * with a permanent error. A failed transaction does not abort the following ones
+     * as long as the connection is still open.
+     */
+    void sendMails(QList<Message> &messages);
+
+    /*!
+     * \brief Checks if the session is still usable.
+     */
+    [[nodiscard]] bool noop();
+
+    /*!
+     * \brief Ends the session and closes the connection.
+     */
+    void quit();
+
+    [[nodiscard]] bool isConnected() const;
+
+    [[nodiscard]] QString lastError() const { return m_lastError; }
+
+    [[nodiscard]] const Config &config() const noexcept { return m_config; }
+
+    /*!
+     * \brief Returns the time of the last successful server response.
+     */
+    [[nodiscard]] std::chrono::steady_clock::time_point lastUsed() const noexcept { return m_lastUsed; }
+
+private:
+    Q_DISABLE_COPY(SmtpClient)
+
+    [[nodiscard]] bool ehlo();
+    [[nodiscard]] bool startTls();
+    [[nodiscard]] bool authenticate();
+    [[nodiscard]] bool transaction(Message &message, bool reset);
+    [[nodiscard]] bool sendData(const QByteArray &data);
+    [[nodiscard]] bool sendCommand(const QByteArray &command, int expectedCode);
+    [[nodiscard]] bool write(const QByteArray &data);
+    [[nodiscard]] bool readResponse(int expectedCode);
+    void setError(const QString &error);
+    void abort();
+
+    Config m_config;
+    QString m_lastError;
+    QByteArrayList m_responseLines;
+    QByteArrayList m_extensions;
+    QByteArrayList m_authMethods;
+    std::unique_ptr<QSslSocket> m_socket;
+    std::chrono::steady_clock::time_point m_lastUsed;
+    int m_responseCode{0};
+    // the last transaction failed and the server might still be in its middle
+    bool m_dirty{false};
+};
+
+#endif // HBNBOTA_SMTPCLIENT_H
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "smtppool.h"
+
+#include "logging.h"
+
+#include <algorithm>
+
+namespace {
+// sessions that have been idle for longer than this are checked with NOOP before reuse
+constexpr std::chrono::seconds checkAfterIdle{5};
+} // namespace
+
+SmtpPool::SmtpPool(qsizetype maxIdle, std::chrono::seconds idleTimeout)
+    : m_idleTimeout{idleTimeout}
+    , m_maxIdle{maxIdle}
+{
+}
+
+SmtpPool::~SmtpPool() = default;
+
+std::unique_ptr<SmtpClient> SmtpPool::acquire(const SmtpClient::Config &config, QString &error)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    for (auto it = m_idle.rbegin(); it != m_idle.rend(); ++it) {
+        if ((*it)->config() != config) {
+            continue;
+        }
+
+        std::unique_ptr<SmtpClient> client = std::move(*it);
+        m_idle.erase(std::next(it).base());
+
+        if (now - client->lastUsed() < checkAfterIdle || client->noop()) {
+            qCDebug(HBNBOTA_DELIVERY) << "Reusing SMTP session to" << config.host;
+            return client;
+        }
+
+        qCDebug(HBNBOTA_DELIVERY) << "Dropping stale SMTP session to" << config.host;
+        break;
+    }
+
+    auto client = std::make_unique<SmtpClient>(config);
+    if (Q_UNLIKELY(!client->connectToServer())) {
+        error = client->lastError();
+        return nullptr;
+    }
+
+    qCDebug(HBNBOTA_DELIVERY) << "Opened new SMTP session to" << config.host;
+
+    return client;
+}
+
+void SmtpPool::release(std::unique_ptr<SmtpClient> client)
+{
+    if (!client || !client->isConnected()) {
+        return;
+    }
+
+    m_idle.push_back(std::move(client));
+
+    if (std::ssize(m_idle) > m_maxIdle) {
+        // the destructor of the client ends the session
+        m_idle.erase(m_idle.begin());
+    }
+}
+
+void SmtpPool::expire()
+{
+    const auto now = std::chrono::steady_clock::now();
+    std::erase_if(m_idle, [this, now](const std::unique_ptr<SmtpClient> &client) {
+        return !client->isConnected() || now - client->lastUsed() > m_idleTimeout;
+    });
+}
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_SMTPPOOL_H
+#define HBNBOTA_SMTPPOOL_H
+
+#include "smtpclient.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+/*!
+ * \brief Keeps authenticated SMTP sessions open for reuse.
+ *
+ * Sessions are identified by their SmtpClient::Config, so consecutive messages for
+ * forms with the same mailer settings share one connection instead of doing the TCP,
+ * TLS and authentication handshakes for every message. The pool keeps at most
+ * \a maxIdle idle sessions, dropping the least recently used ones first. Sessions
+ * that have been idle for longer than \a idleTimeout will be closed by expire().
+ *
+ * Every delivery thread has its own pool, the pool is not thread-safe.
+ */
+class SmtpPool final
+{
+public:
+    SmtpPool(qsizetype maxIdle, std::chrono::seconds idleTimeout);
+    ~SmtpPool();
+
+    /*!
+     * \brief Returns a connected client for \a config.
+     *
+     * Returns \c nullptr if no connection can be established, \a error will then
+     * contain the reason.
+     */
+    [[nodiscard]] std::unique_ptr<SmtpClient> acquire(const SmtpClient::Config &config, QString &error);
+
+    /*!
+     * \brief Gives \a client back to the pool.
+     *
+     * Clients that are not connected anymore will be destroyed.
+     */
+    void release(std::unique_ptr<SmtpClient> client);
+
+    /*!
+     * \brief Closes all sessions that have been idle for longer than the idle timeout.
+     */
+    void expire();
+
+private:
+    Q_DISABLE_COPY(SmtpPool)
+
+    // least recently used first
+    std::vector<std::unique_ptr<SmtpClient>> m_idle;
+    std::chrono::seconds m_idleTimeout;
+    qsizetype m_maxIdle;
+};
+
+#endif // HBNBOTA_SMTPPOOL_H
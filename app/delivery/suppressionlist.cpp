@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "suppressionlist.h"
+
+#include "logging.h"
+#include "objects/suppression.h"
+
+#include <Cutelyst/Plugins/Utils/Sql>
+
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QWriteLocker>
+
+#include <algorithm>
+#include <mutex>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// how long changes made by other processes might take to become effective
+constexpr std::chrono::seconds refreshInterval{30};
+} // namespace
+
+Q_GLOBAL_STATIC(SuppressionList, suppressionList) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+bool SuppressionList::contains(Form::dbid_t formId, const QString &email) const
+{
+    const Key key{formId, Suppression::normalize(email)};
+    QReadLocker locker(&m_lock);
+    return m_entries.contains(key);
+}
+
+void SuppressionList::insert(Form::dbid_t formId, const QString &email)
+{
+    Key key{formId, Suppression::normalize(email)};
+    QWriteLocker locker(&m_lock);
+    m_entries.insert(std::move(key));
+}
+
+void SuppressionList::remove(Form::dbid_t formId, const QString &email)
+{
+    const Key key{formId, Suppression::normalize(email)};
+    QWriteLocker locker(&m_lock);
+    m_entries.remove(key);
+}
+
+qsizetype SuppressionList::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_entries.size();
+}
+
+bool SuppressionList::refresh()
+{
+    QMutexLocker locker(&m_refreshMutex);
+    m_lastRefresh = clock::now();
+    return m_loaded ? loadNew() : reload();
+}
+
+void SuppressionList::refreshIfDue(clock::time_point now)
+{
+    std::unique_lock locker{m_refreshMutex, std::try_to_lock};
+    if (!locker.owns_lock() || (m_loaded && now - m_lastRefresh < refreshInterval)) {
+        return;
+    }
+    m_lastRefresh = now;
+    if (m_loaded) {
+        loadNew();
+    } else {
+        reload();
+    }
+}
+
+SuppressionList *SuppressionList::instance()
+{
+    return suppressionList;
+}
+
+bool SuppressionList::reload()
+{
+    QSqlQuery q = CPreparedSqlQueryThreadFO(u"SELECT id, formId, email FROM suppressions"_s);
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query suppressions from database:" << q.lastError().text();
+        return false;
+    }
+
+    QSet<Key> entries;
+    if (q.size() > 0) {
+        entries.reserve(q.size());
+    }
+
+    quint64 rows  = 0;
+    quint32 maxId = 0;
+    while (q.next()) {
+        maxId = std::max(maxId, Suppression::toDbId(q.value(0)));
+        entries.insert({Form::toDbId(q.value(1)), Suppression::normalize(q.value(2).toString())});
+        ++rows;
+    }
+
+    {
+        QWriteLocker locker(&m_lock);
+        m_entries.swap(entries);
+    }
+
+    m_loadedRows = rows;
+    m_lastId     = maxId;
+    m_loaded     = true;
+
+    qCDebug(HBNBOTA_DELIVERY) << "Loaded" << rows << "suppressed addresses";
+
+    return true;
+}
+
+bool SuppressionList::loadNew()
+{
+    // rows deleted by other processes can only be found by counting the already loaded ones
+    QSqlQuery q = CPreparedSqlQueryThreadFO(u"SELECT COUNT(*) FROM suppressions WHERE id <= :lastId"_s);
+    q.bindValue(u":lastId"_s, m_lastId);
+    if (Q_UNLIKELY(!q.exec() || !q.next())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to count suppressions in database:" << q.lastError().text();
+        return false;
+    }
+
+    if (q.value(0).toULongLong() != m_loadedRows) {
+        return reload();
+    }
+
+    q = CPreparedSqlQueryThreadFO(u"SELECT id, formId, email FROM suppressions WHERE id > :lastId"_s);
+    q.bindValue(u":lastId"_s, m_lastId);
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query new suppressions from database:" << q.lastError().text();
+        return false;
+    }
+
+    QList<Key> added;
+    quint32 maxId = m_lastId;
+    while (q.next()) {
+        maxId = std::max(maxId, Suppression::toDbId(q.value(0)));
+        added.emplace_back(Form::toDbId(q.value(1)), Suppression::normalize(q.value(2).toString()));
+    }
+
+    if (added.empty()) {
+        return true;
+    }
+
+    {
+        QWriteLocker locker(&m_lock);
+        for (Key &key : added) {
+            m_entries.insert(std::move(key));
+        }
+    }
+
+    m_loadedRows += static_cast<quint64>(added.size());
+    m_lastId = maxId;
+
+    qCDebug(HBNBOTA_DELIVERY) << "Loaded" << added.size() << "new suppressed addresses";
+
+    return true;
+}
@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_SUPPRESSIONLIST_H
+#define HBNBOTA_SUPPRESSIONLIST_H
+
+#include "objects/form.h"
+
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+
+#include <chrono>
+#include <utility>
+
+/*!
+ * \brief In-memory set of the suppressed receiver addresses of all forms.
+ *
+ * The delivery threads check every receiver address against this set before a
+ * message is built, so that a suppressed address costs a hash lookup instead of a
+ * mail transaction and a retry cycle. The set mirrors the suppressions table.
+ * Changes made in this process are applied directly via insert() and remove(),
+ * changes made by other processes are picked up by refresh(): new rows are loaded
+ * incrementally by their ID, deleted rows are detected by comparing the number of
+ * already loaded rows with the table and lead to a complete reload.
+ *
+ * All functions are thread-safe, instance() returns the list shared by all threads
+ * of the process.
+ */
+class SuppressionList final
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    SuppressionList() = default;
+
+    /*!
+     * \brief Returns \c true if \a email is suppressed for the form with \a formId.
+     *
+     * \a email does not have to be normalized.
+     */
+    [[nodiscard]] bool contains(Form::dbid_t formId, const QString &email) const;
+
+    /*!
+     * \brief Adds \a email to the suppressed addresses of the form with \a formId.
+     */
+    void insert(Form::dbid_t formId, const QString &email);
+
+    /*!
+     * \brief Removes \a email from the suppressed addresses of the form with \a formId.
+     */
+    void remove(Form::dbid_t formId, const QString &email);
+
+    /*!
+     * \brief Returns the number of suppressed addresses of all forms.
+     */
+    [[nodiscard]] qsizetype size() const;
+
+    /*!
+     * \brief Loads changes of the suppressions table using the database connection of the current thread.
+     *
+     * Returns \c false if the database can not be queried, the set stays unchanged then.
+     */
+    bool refresh();
+
+    /*!
+     * \brief Calls refresh() if the last refresh is older than the refresh interval.
+     *
+     * Does nothing if another thread is refreshing at the moment.
+     */
+    void refreshIfDue(clock::time_point now = clock::now());
+
+    /*!
+     * \brief Returns the list shared by all threads of this process.
+     */
+    [[nodiscard]] static SuppressionList *instance();
+
+private:
+    using Key = std::pair<Form::dbid_t, QString>;
+
+    bool reload();
+    bool loadNew();
+
+    mutable QReadWriteLock m_lock;
+    QSet<Key> m_entries;
+    // guards the refresh state below, only one thread refreshes at a time
+    QMutex m_refreshMutex;
+    clock::time_point m_lastRefresh;
+    quint64 m_loadedRows{0};
+    quint32 m_lastId{0};
+    bool m_loaded{false};
+};
+
+#endif // HBNBOTA_SUPPRESSIONLIST_H
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "timerwheel.h"
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, clock::time_point start)
+    : m_start{start}
+    , m_tick{tick}
+{
+}
+
+void TimerWheel::schedule(timer_id id, clock::time_point due)
+{
+    quint64 dueTick = 0;
+    if (due > m_start) {
+        // round up, timers must never expire early
+        const auto offset = std::chrono::duration_cast<std::chrono::milliseconds>(due - m_start);
+        dueTick           = static_cast<quint64>((offset.count() + m_tick.count() - 1) / m_tick.count());
+    }
+
+    ++m_size;
+    insert({dueTick, id});
+}
+
+QList<TimerWheel::timer_id> TimerWheel::advance(clock::time_point now)
+{
+    quint64 targetTick = 0;
+    if (now > m_start) {
+        const auto offset = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start);
+        targetTick        = static_cast<quint64>(offset.count() / m_tick.count());
+    }
+
+    while (m_currentTick < targetTick) {
+        if (m_size == static_cast<qsizetype>(m_expired.size())) {
+            // nothing left in the slots, no need to turn the wheel tick by tick
+            m_currentTick = targetTick;
+            break;
+        }
+
+        ++m_currentTick;
+
+        // when a level has done a full turn, the current slot of the next level is moved down
+        for (int level = 1; level < levels; ++level) {
+            if ((m_currentTick & ((quint64{1} << (level * levelBits)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+
+        auto &slot = m_slots[0][m_currentTick & levelMask];
+        if (!slot.empty()) {
+            std::vector<Timer> timers;
+            timers.swap(slot);
+            for (const Timer &timer : timers) {
+                insert(timer);
+            }
+        }
+    }
+
+    m_size -= m_expired.size();
+
+    QList<timer_id> expired;
+    expired.swap(m_expired);
+    return expired;
+}
+
+void TimerWheel::insert(const Timer &timer)
+{
+    if (timer.dueTick <= m_currentTick) {
+        m_expired << timer.id;
+        return;
+    }
+
+    const quint64 delta = timer.dueTick - m_currentTick;
+
+    for (int level = 0; level < levels; ++level) {
+        if (delta < (quint64{1} << ((level + 1) * levelBits))) {
+            m_slots[level][(timer.dueTick >> (level * levelBits)) & levelMask].push_back(timer);
+            return;
+        }
+    }
+
+    // out of range, park it in the slot of the top level that will be reached last
+    m_slots[levels - 1][(m_currentTick >> ((levels - 1) * levelBits)) & levelMask].push_back(timer);
+}
+
+void TimerWheel::cascade(int level)
+{
+    auto &slot = m_slots[level][(m_currentTick >> (level * levelBits)) & levelMask];
+    if (slot.empty()) {
+        return;
+    }
+
+    std::vector<Timer> timers;
+    timers.swap(slot);
+    for (const Timer &timer : timers) {
+        insert(timer);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_TIMERWHEEL_H
+#define HBNBOTA_TIMERWHEEL_H
+
+#include <QList>
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+/*!
+ * \brief Hierarchical timer wheel for a large number of timers with coarse resolution.
+ *
+ * The wheel has four levels of 64 slots each. With the default tick length of one
+ * second, the levels cover about one minute, one hour, three days and six months.
+ * Scheduling a timer and expiring it cost O(1), timers on the upper levels are moved
+ * down one level whenever the level below has done a full turn. Timers that are due
+ * after the range of the wheel are parked in the last slot of the top level and
+ * rescheduled when that slot is reached.
+ *
+ * The wheel does not have its own timer, advance() has to be called periodically.
+ * It is not thread-safe.
+ */
+class TimerWheel final
+{
+public:
+    using clock    = std::chrono::steady_clock;
+    using timer_id = quint32;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::seconds{1},
+                        clock::time_point start        = clock::now());
+
+    /*!
+     * \brief Schedules the timer \a id to expire at \a due.
+     *
+     * Timers that are already due will be returned by the next call to advance().
+     */
+    void schedule(timer_id id, clock::time_point due);
+
+    /*!
+     * \brief Advances the wheel to \a now and returns the IDs of all expired timers.
+     */
+    [[nodiscard]] QList<timer_id> advance(clock::time_point now = clock::now());
+
+    /*!
+     * \brief Returns the number of scheduled timers.
+     */
+    [[nodiscard]] qsizetype size() const noexcept { return m_size; }
+
+    [[nodiscard]] bool isEmpty() const noexcept { return m_size == 0; }
+
+private:
+    static constexpr int levelBits = 6;
+    static constexpr int levelSize = 1 << levelBits;
+    static constexpr int levelMask = levelSize - 1;
+    static constexpr int levels    = 4;
+
+    struct Timer {
+        quint64 dueTick{0};
+        timer_id id{0};
+    };
+
+    void insert(const Timer &timer);
+    void cascade(int level);
+
+    std::array<std::array<std::vector<Timer>, levelSize>, levels> m_slots;
+    QList<timer_id> m_expired;
+    clock::time_point m_start;
+    std::chrono::milliseconds m_tick;
+    quint64 m_currentTick{0};
+    qsizetype m_size{0};
+};
+
+#endif // HBNBOTA_TIMERWHEEL_H
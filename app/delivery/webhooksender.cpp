@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "webhooksender.h"
+
+#include "logging.h"
+#include "objects/form.h"
+
+#include <QCoreApplication>
+#include <QHostInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include <algorithm>
+#include <array>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// networks that webhooks must not be sent to, in addition to the ones QHostAddress can classify
+constexpr std::array<QStringView, 9> blockedNetworks{u"0.0.0.0/8",
+                                                     u"10.0.0.0/8",
+                                                     u"100.64.0.0/10",
+                                                     u"127.0.0.0/8",
+                                                     u"169.254.0.0/16",
+                                                     u"172.16.0.0/12",
+                                                     u"192.168.0.0/16",
+                                                     u"fc00::/7",
+                                                     u"fec0::/10"};
+} // namespace
+
+WebhookSender::Config WebhookSender::Config::fromForm(const Form &form)
+{
+    const auto webhook = form.settings().value(u"mailer"_s).toMap().value(u"webhook"_s).toMap();
+
+    Config config;
+    config.url       = QUrl{webhook.value(u"url"_s).toString()};
+    config.token     = webhook.value(u"token"_s).toString();
+    config.batchSize = std::max(webhook.value(u"batchSize"_s, 1).toInt(), 1);
+    return config;
+}
+
+WebhookSender::WebhookSender(QObject *parent)
+    : QObject{parent}
+    , m_nam{new QNetworkAccessManager{this}}
+{
+    // submissions contain personal data, a redirect must not send them to another host
+    m_nam->setRedirectPolicy(QNetworkRequest::ManualRedirectPolicy);
+    m_nam->setTransferTimeout(timeout);
+}
+
+void WebhookSender::post(const Form &form, const Config &config, const QList<Submission> &submissions, Callback done)
+{
+    if (Q_UNLIKELY(!config.isValid())) {
+        done(u"Invalid webhook URL"_s);
+        return;
+    }
+
+    if (!m_restrictTargets) {
+        send(config, payload(form, submissions), std::move(done));
+        return;
+    }
+
+    if (Q_UNLIKELY(!isAllowedUrl(config.url))) {
+        done(u"Webhook URL has to use https and must not point to a local host"_s);
+        return;
+    }
+
+    // the addresses of the host are checked before any data is sent
+    ++m_pending;
+    QHostInfo::lookupHost(
+        config.url.host(),
+        this,
+        [this, config, body = payload(form, submissions), done = std::move(done)](const QHostInfo &info) {
+            --m_pending;
+
+            if (info.error() != QHostInfo::NoError || info.addresses().empty()) {
+                qCWarning(HBNBOTA_DELIVERY) << "Failed to look up webhook host" << config.url.host() << ':'
+                                            << info.errorString();
+                done(info.errorString());
+                return;
+            }
+
+            const auto addresses = info.addresses();
+            if (!std::all_of(addresses.cbegin(), addresses.cend(), &WebhookSender::isAllowedAddress)) {
+                qCWarning(HBNBOTA_DELIVERY) << "Webhook host" << config.url.host() << "resolves to a local address";
+                done(u"Webhook host %1 resolves to a local address"_s.arg(config.url.host()));
+                return;
+            }
+
+            send(config, body, done);
+        });
+}
+
+bool WebhookSender::isAllowedUrl(const QUrl &url)
+{
+    if (url.scheme() != "https"_L1) {
+        return false;
+    }
+
+    const QString host = url.host().toLower();
+    if (host.isEmpty() || host == "localhost"_L1 || host.endsWith(".localhost"_L1) || host.endsWith(".local"_L1)
+        || host.endsWith(".internal"_L1)) {
+        return false;
+    }
+
+    if (const QHostAddress address{host}; !address.isNull()) {
+        return isAllowedAddress(address);
+    }
+
+    // no dots, resolved by the local search domains
+    return host.contains(u'.');
+}
+
+bool WebhookSender::isAllowedAddress(const QHostAddress &address)
+{
+    if (address.isNull() || address.isLoopback() || address.isLinkLocal() || address.isSiteLocal()
+        || address.isUniqueLocalUnicast() || address.isMulticast() || address.isBroadcast()
+        || address == QHostAddress{QHostAddress::AnyIPv4} || address == QHostAddress{QHostAddress::AnyIPv6}) {
+        return false;
+    }
+
+    // IPv4 mapped IPv6 addresses are checked as IPv4 addresses
+    bool isV4                  = false;
+    const quint32 ip4          = address.toIPv4Address(&isV4);
+    const QHostAddress checked = isV4 ? QHostAddress{ip4} : address;
+
+    return std::none_of(blockedNetworks.cbegin(), blockedNetworks.cend(), [&checked](QStringView network) {
+        return checked.isInSubnet(QHostAddress::parseSubnet(network.toString()));
+    });
+}
+
+void WebhookSender::send(const Config &config, const QByteArray &body, Callback done)
+{
+    QNetworkRequest request{config.url};
+    request.setHeader(QNetworkRequest::ContentTypeHeader, u"application/json"_s);
+    request.setHeader(QNetworkRequest::UserAgentHeader, QCoreApplication::applicationName());
+    if (!config.token.isEmpty()) {
+        request.setRawHeader("Authorization"_ba, "Bearer "_ba + config.token.toUtf8());
+    }
+
+    ++m_pending;
+    QNetworkReply *reply = m_nam->post(request, body);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, done = std::move(done)]() {
+        --m_pending;
+        reply->deleteLater();
+
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (reply->error() == QNetworkReply::NoError && status >= 200 && status < 300) {
+            done({});
+            return;
+        }
+
+        const QString error = status > 0 ? u"%1 responded with HTTP status %2"_s.arg(
+                                               reply->url().host(), QString::number(status))
+                                         : reply->errorString();
+        qCWarning(HBNBOTA_DELIVERY) << "Failed to post submissions to" << reply->url().host() << ':' << error;
+        done(error);
+    });
+}
+
+QByteArray WebhookSender::payload(const Form &form, const QList<Submission> &submissions)
+{
+    QJsonArray array;
+    for (const Submission &s : submissions) {
+        QJsonObject o = s.toJson();
+        o.insert(u"id"_s, static_cast<qint64>(s.id()));
+        o.insert(u"created"_s, s.created().toString(Qt::ISODate));
+        array.append(o);
+    }
+
+    const QJsonObject root{{u"form"_s, QJsonObject{{u"uuid"_s, form.uuid()}, {u"name"_s, form.name()}}},
+                           {u"submissions"_s, array}};
+
+    return QJsonDocument{root}.toJson(QJsonDocument::Compact);
+}
+
+#include "moc_webhooksender.cpp"
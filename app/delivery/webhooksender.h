@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_WEBHOOKSENDER_H
+#define HBNBOTA_WEBHOOKSENDER_H
+
+#include "objects/submission.h"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+#include <chrono>
+#include <functional>
+
+class Form;
+class QNetworkAccessManager;
+
+/*!
+ * \brief Posts submissions as JSON to the webhook URL of a form.
+ *
+ * All requests of a delivery thread go through the same QNetworkAccessManager,
+ * so that connections to a webhook host are kept alive and reused by following
+ * requests instead of doing a new TCP and TLS handshake for every submission.
+ * Requests are sent asynchronously, the delivery thread is not blocked while
+ * waiting for the response.
+ *
+ * The request body is a JSON object containing the form UUID and name and an array
+ * of submissions. Up to Config::batchSize submissions are sent in one request.
+ * Every status code in the 2xx range counts as success.
+ *
+ * Submissions contain personal data and the request contains the bearer token, so only
+ * \c https URLs are accepted, and the host must not resolve to a loopback, link-local or
+ * private address. See isAllowedUrl() and isAllowedAddress().
+ *
+ * Objects of this class have to be used in the thread they have been created in.
+ */
+class WebhookSender final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(WebhookSender)
+public:
+    /*!
+     * \brief Webhook settings of a form.
+     */
+    struct Config {
+        QUrl url;
+        /*!
+         * \brief Sent as bearer token in the Authorization header if not empty.
+         */
+        QString token;
+        /*!
+         * \brief Maximum number of submissions per request.
+         */
+        int batchSize{1};
+
+        /*!
+         * \brief Returns the configuration stored in the mailer settings of \a form.
+         */
+        [[nodiscard]] static Config fromForm(const Form &form);
+
+        [[nodiscard]] bool isValid() const { return url.isValid() && !url.isRelative(); }
+    };
+
+    /*!
+     * \brief Will be called with an empty error string if the request succeeded.
+     */
+    using Callback = std::function<void(const QString &error)>;
+
+    explicit WebhookSender(QObject *parent = nullptr);
+    ~WebhookSender() override = default;
+
+    /*!
+     * \brief Posts \a submissions of \a form to the webhook in \a config and calls \a done with the result.
+     *
+     * \a submissions should not contain more than Config::batchSize entries.
+     */
+    void post(const Form &form, const Config &config, const QList<Submission> &submissions, Callback done);
+
+    /*!
+     * \brief Returns the number of requests waiting for their response.
+     */
+    [[nodiscard]] qsizetype pending() const noexcept { return m_pending; }
+
+    /*!
+     * \brief Returns the JSON request body for \a submissions of \a form.
+     */
+    [[nodiscard]] static QByteArray payload(const Form &form, const QList<Submission> &submissions);
+
+    /*!
+     * \brief Returns \c true if \a url uses \c https and its host is not a local name or address.
+     *
+     * Host names are only checked for local names like \c localhost, the addresses they resolve
+     * to are checked by post().
+     */
+    [[nodiscard]] static bool isAllowedUrl(const QUrl &url);
+
+    /*!
+     * \brief Returns \c false if \a address is a loopback, link-local, private, unspecified or multicast address.
+     */
+    [[nodiscard]] static bool isAllowedAddress(const QHostAddress &address);
+
+    /*!
+     * \brief Sets \a restrict to \c false to also post to local addresses and without \c https.
+     *
+     * Enabled by default. Only meant for tests that post to a local server.
+     */
+    void setRestrictTargets(bool restrict) noexcept { m_restrictTargets = restrict; }
+
+    static constexpr std::chrono::seconds timeout{30};
+
+private:
+    void send(const Config &config, const QByteArray &body, Callback done);
+
+    QNetworkAccessManager *m_nam{nullptr};
+    qsizetype m_pending{0};
+    bool m_restrictTargets{true};
+};
+
+#endif // HBNBOTA_WEBHOOKSENDER_H
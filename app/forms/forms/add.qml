@@ -50,6 +50,43 @@ Form {
                 //% "The description is only used internally."
                 description: cTrId("hbnbota_form_description_desc")
             }
+
+            NumberForm {
+                htmlId: "digestInterval"
+                name: "digestInterval"
+                min: 0
+                max: 10080
+                //: Form field label, interval in minutes
+                //% "Digest interval"
+                label: cTrId("hbnbota_form_digestinterval_label")
+                //: Form field description
+                //% "Collect the submissions and send them as one digest per recipient every given number of minutes. 0 sends every submission on its own."
+                description: cTrId("hbnbota_form_digestinterval_desc")
+                value: 0
+            }
+
+            Select {
+                htmlId: "tokenAlgorithm"
+                name: "tokenAlgorithm"
+                //: Form field label
+                //% "Token algorithm"
+                label: cTrId("hbnbota_form_tokenalgorithm_label")
+                //: Form field description
+                //% "Algorithm used to protect the time token of the contact form. HMAC-SHA256 is the fastest, but the time in the token is readable."
+                description: cTrId("hbnbota_form_tokenalgorithm_desc")
+            }
+
+            CheckBoxForm {
+                htmlId: "tokenProofOfWork"
+                name: "tokenProofOfWork"
+                value: "true"
+                //: Form checkbox label
+                //% "Require proof of work"
+                label: cTrId("hbnbota_form_tokenproofofwork_label")
+                //: Form field description
+                //% "The token request returns a challenge that the browser has to solve before submitting. The difficulty rises with the number of submissions."
+                description: cTrId("hbnbota_form_tokenproofofwork_desc")
+            }
         },
         Fieldset {
             htmlId: "addFormFields"
@@ -233,7 +270,6 @@ Form {
             TextForm {
                 htmlId: "smtpHost"
                 name: "smtpHost"
-                required: true
                 minlength: 3
                 placeholder: "smtp.example.net"
                 pattern: "^[a-zA-Z]+[a-zA-Z0-9\\-_\\.]*\.[a-zA-Z]{2,}$"
@@ -245,7 +281,6 @@ Form {
             NumberForm {
                 htmlId: "smtpPort"
                 name: "smtpPort"
-                required: true
                 min: 1
                 max: 65535
                 //: Form field label
@@ -257,7 +292,6 @@ Form {
             TextForm {
                 htmlId: "smtpUser"
                 name: "smtpUser"
-                required: true
                 //: Form field label
                 //% "SMTP user"
                 label: cTrId("hbnbota_form_sender_smtpuser_label")
@@ -266,7 +300,6 @@ Form {
             PasswordForm {
                 htmlId: "smtpPassword"
                 name: "smtpPassword"
-                required: true;
                 //: Form field label
                 //% "SMTP password"
                 label: cTrId("hbnbota_form_sender_smtppassword_label")
@@ -275,7 +308,6 @@ Form {
             Select {
                 htmlId: "smtpEncryption"
                 name: "smtpEncryption"
-                required: true
                 //: Form field label
                 //% "SMTP encryption method"
                 label: cTrId("hbnbota_form_sender_smtpencryption_label")
@@ -284,11 +316,149 @@ Form {
             Select {
                 htmlId: "smtpAuthentication"
                 name: "smtpAuthentication"
-                required: true
                 //: Form field label
                 //% "SMTP authentication method"
                 label: cTrId("hbnbota_form_sender_smtpauthentication_label")
             }
+
+            TextForm {
+                htmlId: "maildirFolder"
+                name: "maildirFolder"
+                pattern: "^[A-Za-z0-9][A-Za-z0-9_.\\-]*$"
+                //: Form field label
+                //% "Maildir folder"
+                label: cTrId("hbnbota_form_sender_maildirfolder_label")
+                //: Form field description
+                //% "Only used by the Maildir sender type. Name of the Maildir below the directory of the form in the directory configured by the administrator. If empty, the directory of the form is used."
+                description: cTrId("hbnbota_form_sender_maildirfolder_desc")
+            }
+
+            TextForm {
+                htmlId: "webhookUrl"
+                name: "webhookUrl"
+                placeholder: "https://crm.example.com/hooks/contact"
+                //: Form field label
+                //% "Webhook URL"
+                label: cTrId("hbnbota_form_sender_webhookurl_label")
+                //: Form field description
+                //% "Only used by the Webhook sender type. Submissions are posted as JSON to this URL instead of being sent to the recipients."
+                description: cTrId("hbnbota_form_sender_webhookurl_desc")
+            }
+
+            PasswordForm {
+                htmlId: "webhookToken"
+                name: "webhookToken"
+                //: Form field label
+                //% "Webhook token"
+                label: cTrId("hbnbota_form_sender_webhooktoken_label")
+                //: Form field description
+                //% "Optional token that is sent as bearer token in the Authorization header."
+                description: cTrId("hbnbota_form_sender_webhooktoken_desc")
+            }
+
+            NumberForm {
+                htmlId: "webhookBatchSize"
+                name: "webhookBatchSize"
+                min: 1
+                max: 100
+                //: Form field label
+                //% "Submissions per request"
+                label: cTrId("hbnbota_form_sender_webhookbatchsize_label")
+                //: Form field description
+                //% "Maximum number of waiting submissions that are posted together in one request."
+                description: cTrId("hbnbota_form_sender_webhookbatchsize_desc")
+                value: 1
+            }
+
+            NumberForm {
+                htmlId: "rateLimit"
+                name: "rateLimit"
+                min: 0
+                max: 10000
+                step: 0.1
+                //: Form field label
+                //% "Messages per second"
+                label: cTrId("hbnbota_form_sender_ratelimit_label")
+                //: Form field description
+                //% "Maximum number of messages per second sent to this server by all forms using it. 0 means no limit."
+                description: cTrId("hbnbota_form_sender_ratelimit_desc")
+                value: 0
+            }
+
+            NumberForm {
+                htmlId: "maxSessions"
+                name: "maxSessions"
+                min: 0
+                max: 1000
+                //: Form field label
+                //% "Concurrent sessions"
+                label: cTrId("hbnbota_form_sender_maxsessions_label")
+                //: Form field description
+                //% "Maximum number of simultaneous deliveries to this server. 0 means no limit."
+                description: cTrId("hbnbota_form_sender_maxsessions_desc")
+                value: 0
+            }
+        },
+        Fieldset {
+            htmlId: "addFormDkim"
+            //: Fieldset legend
+            //% "DKIM signature"
+            legend: cTrId("hbnbota_form_dkim_fieldset_legend")
+
+            TextForm {
+                htmlId: "dkimDomain"
+                name: "dkimDomain"
+                placeholder: "example.com"
+                pattern: "^[a-zA-Z]+[a-zA-Z0-9\\-_\\.]*\.[a-zA-Z]{2,}$"
+                //: Form field label
+                //% "Signing domain"
+                label: cTrId("hbnbota_form_dkim_domain_label")
+                //: Form field description
+                //% "Domain the DKIM public key is published for. Defaults to the domain of the form."
+                description: cTrId("hbnbota_form_dkim_domain_desc")
+            }
+
+            TextForm {
+                htmlId: "dkimSelector"
+                name: "dkimSelector"
+                pattern: "^[A-Za-z0-9][A-Za-z0-9_.\\-]*$"
+                //: Form field label
+                //% "Selector"
+                label: cTrId("hbnbota_form_dkim_selector_label")
+                //: Form field description
+                //% "The public key has to be published in the TXT record selector._domainkey.domain."
+                description: cTrId("hbnbota_form_dkim_selector_desc")
+            }
+
+            TextAreaForm {
+                htmlId: "dkimKey"
+                name: "dkimKey"
+                //: Form field label
+                //% "Private key"
+                label: cTrId("hbnbota_form_dkim_key_label")
+                //: Form field description
+                //% "Unencrypted RSA or Ed25519 private key in PKCS #8 PEM format. Leave empty to send messages without DKIM signature."
+                description: cTrId("hbnbota_form_dkim_key_desc")
+            }
+        },
+        Fieldset {
+            htmlId: "addFormAdmin"
+            //: Fieldset legend
+            //% "Administration"
+            legend: cTrId("hbnbota_form_admin_fieldset_legend")
+
+            NumberForm {
+                htmlId: "deliveryWeight"
+                name: "deliveryWeight"
+                min: 1
+                //: Form field label
+                //% "Delivery weight"
+                label: cTrId("hbnbota_form_sender_deliveryweight_label")
+                //: Form field description
+                //% "Share of the delivery threads this form gets while other forms are waiting too. A form with weight 2 sends twice as many messages per round as a form with weight 1. Only administrators can change this."
+                description: cTrId("hbnbota_form_sender_deliveryweight_desc")
+                value: 1
+            }
         }
     ]
 
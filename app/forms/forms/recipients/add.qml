@@ -94,6 +94,42 @@ Form {
                 //% "Email content in HTML form"
                 label: cTrId("hbnbota_form_recipient_html_label")
             }
+        },
+        Fieldset {
+            htmlId: "addRecipientRouting"
+            //: Form fieldset legend
+            //% "Routing"
+            legend: cTrId("hbnbota_form_recipient_fs_routing_legend")
+
+            Select {
+                htmlId: "routeField"
+                name: "routeField"
+                //: Form field label
+                //% "Send to this recipient"
+                label: cTrId("hbnbota_form_recipient_routeField_label")
+                //: Form field description
+                //% "Select a submitted field to only send submissions to this recipient if the field value matches."
+                description: cTrId("hbnbota_form_recipient_routeField_desc")
+            }
+
+            Select {
+                htmlId: "routeOperator"
+                name: "routeOperator"
+                //: Form field label
+                //% "Condition"
+                label: cTrId("hbnbota_form_recipient_routeOperator_label")
+            }
+
+            TextForm {
+                htmlId: "routeValue"
+                name: "routeValue"
+                //: Form field label
+                //% "Value"
+                label: cTrId("hbnbota_form_recipient_routeValue_label")
+                //: Form field description
+                //% "The comparison is case-insensitive."
+                description: cTrId("hbnbota_form_recipient_routeValue_desc")
+            }
         }
     ]
 
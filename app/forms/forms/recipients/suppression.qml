@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+// SPDX-License-Identifier: AGPL-3.0-or-later
+import de.huessenbergnetz.cutelystforms 1.0
+
+Form {
+    htmlId: "addSuppression"
+    method: Form.Post
+    autocomplete: false
+
+    fieldsets: [
+        Fieldset {
+            htmlId: "addSuppressionFs"
+            //: Form fieldset legend
+            //% "Suppress address"
+            legend: cTrId("hbnbota_form_suppression_fs_legend")
+
+            EmailForm {
+                htmlId: "email"
+                name: "email"
+                required: true
+                //: Form field label
+                //% "Email"
+                label: cTrId("hbnbota_form_suppression_email_label")
+                //: Form field description
+                //% "No messages of this contact form will be sent to this address."
+                description: cTrId("hbnbota_form_suppression_email_desc")
+            }
+
+            TextForm {
+                htmlId: "reason"
+                name: "reason"
+                //: Form field label
+                //% "Reason"
+                label: cTrId("hbnbota_form_suppression_reason_label")
+            }
+        }
+    ]
+
+    buttons: [
+        FormButton {
+            htmlId: "submitBtn"
+            text: cTrId("hbnbota_general_create")
+        }
+    ]
+}
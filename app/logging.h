@@ -13,5 +13,6 @@ Q_DECLARE_LOGGING_CATEGORY(HBNBOTA_SETTINGS)
 Q_DECLARE_LOGGING_CATEGORY(HBNBOTA_AUTHN)
 Q_DECLARE_LOGGING_CATEGORY(HBNBOTA_AUTHZ)
 Q_DECLARE_LOGGING_CATEGORY(HBNBOTA_CUTELEE)
+Q_DECLARE_LOGGING_CATEGORY(HBNBOTA_DELIVERY)
 
 #endif // HBNBOTA_LOGGING_H
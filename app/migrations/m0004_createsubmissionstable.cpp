@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "m0004_createsubmissionstable.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+M0004_CreateSubmissionsTable::M0004_CreateSubmissionsTable(Firfuorida::Migrator *parent)
+    : Firfuorida::Migration{parent}
+{
+}
+
+void M0004_CreateSubmissionsTable::up()
+{
+    auto t = create(u"submissions"_s);
+    t->increments();
+    t->integer(u"formId"_s)->unSigned()->nullable();
+    t->json(u"data"_s);
+    t->varChar(u"remoteAddress"_s)->nullable()->defaultValue(u"NULL"_s);
+    t->dateTime(u"created"_s);
+    t->foreignKey(u"formId"_s, u"forms"_s, u"id"_s, u"submissions_formId_idx"_s)
+        ->onDelete(u"CASCADE"_s)
+        ->onUpdate(u"CASCADE"_s);
+
+    switch (dbType()) {
+    case Firfuorida::Migrator::MariaDB:
+    case Firfuorida::Migrator::MySQL:
+        t->setEngine(u"InnoDB"_s);
+        t->setCharset(u"utf8mb4"_s);
+        break;
+    case Firfuorida::Migrator::DB2:
+    case Firfuorida::Migrator::InterBase:
+    case Firfuorida::Migrator::ODBC:
+    case Firfuorida::Migrator::OCI:
+    case Firfuorida::Migrator::PSQL:
+    case Firfuorida::Migrator::SQLite:
+    case Firfuorida::Migrator::Invalid:
+        break;
+    }
+}
+
+void M0004_CreateSubmissionsTable::down()
+{
+    drop(u"submissions"_s);
+}
+
+#include "moc_m0004_createsubmissionstable.cpp"
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef M0004_CREATESUBMISSIONSTABLE_H
+#define M0004_CREATESUBMISSIONSTABLE_H
+
+#include <Firfuorida/Migration>
+
+class M0004_CreateSubmissionsTable final : public Firfuorida::Migration
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(M0004_CreateSubmissionsTable)
+public:
+    explicit M0004_CreateSubmissionsTable(Firfuorida::Migrator *parent);
+    ~M0004_CreateSubmissionsTable() override = default;
+
+    void up() final;
+    void down() final;
+};
+
+#endif // M0004_CREATESUBMISSIONSTABLE_H
@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "m0005_createoutboxtable.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+M0005_CreateOutboxTable::M0005_CreateOutboxTable(Firfuorida::Migrator *parent)
+    : Firfuorida::Migration{parent}
+{
+}
+
+void M0005_CreateOutboxTable::up()
+{
+    auto t = create(u"outbox"_s);
+    t->increments();
+    t->integer(u"formId"_s)->unSigned()->nullable();
+    t->json(u"data"_s);
+    t->varChar(u"remoteAddress"_s)->nullable()->defaultValue(u"NULL"_s);
+    t->dateTime(u"created"_s);
+    t->integer(u"attempts"_s)->unSigned()->defaultValue(0);
+    t->json(u"delivered"_s)->nullable();
+    t->varChar(u"leasedBy"_s)->nullable()->defaultValue(u"NULL"_s);
+    t->dateTime(u"leasedUntil"_s)->nullable()->defaultValue(u"NULL"_s);
+    t->dateTime(u"nextAttempt"_s)->nullable()->defaultValue(u"NULL"_s);
+    t->text(u"lastError"_s)->nullable()->defaultValue(u"NULL"_s);
+    t->foreignKey(u"formId"_s, u"forms"_s, u"id"_s, u"outbox_formId_idx"_s)
+        ->onDelete(u"CASCADE"_s)
+        ->onUpdate(u"CASCADE"_s);
+
+    switch (dbType()) {
+    case Firfuorida::Migrator::MariaDB:
+    case Firfuorida::Migrator::MySQL:
+        t->setEngine(u"InnoDB"_s);
+        t->setCharset(u"utf8mb4"_s);
+        break;
+    case Firfuorida::Migrator::DB2:
+    case Firfuorida::Migrator::InterBase:
+    case Firfuorida::Migrator::ODBC:
+    case Firfuorida::Migrator::OCI:
+    case Firfuorida::Migrator::PSQL:
+    case Firfuorida::Migrator::SQLite:
+    case Firfuorida::Migrator::Invalid:
+        break;
+    }
+}
+
+void M0005_CreateOutboxTable::down()
+{
+    drop(u"outbox"_s);
+}
+
+#include "moc_m0005_createoutboxtable.cpp"
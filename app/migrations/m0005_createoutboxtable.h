@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef M0005_CREATEOUTBOXTABLE_H
+#define M0005_CREATEOUTBOXTABLE_H
+
+#include <Firfuorida/Migration>
+
+class M0005_CreateOutboxTable final : public Firfuorida::Migration
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(M0005_CreateOutboxTable)
+public:
+    explicit M0005_CreateOutboxTable(Firfuorida::Migrator *parent);
+    ~M0005_CreateOutboxTable() override = default;
+
+    void up() final;
+    void down() final;
+};
+
+#endif // M0005_CREATEOUTBOXTABLE_H
@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "m0006_createsuppressionstable.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+M0006_CreateSuppressionsTable::M0006_CreateSuppressionsTable(Firfuorida::Migrator *parent)
+    : Firfuorida::Migration{parent}
+{
+}
+
+void M0006_CreateSuppressionsTable::up()
+{
+    auto t = create(u"suppressions"_s);
+    t->increments();
+    t->integer(u"formId"_s)->unSigned();
+    t->varChar(u"email"_s);
+    t->text(u"reason"_s)->nullable()->defaultValue(u"NULL"_s);
+    t->dateTime(u"created"_s);
+    t->foreignKey(u"formId"_s, u"forms"_s, u"id"_s, u"suppressions_formId_idx"_s)
+        ->onDelete(u"CASCADE"_s)
+        ->onUpdate(u"CASCADE"_s);
+    t->uniqueKey(QStringList({u"formId"_s, u"email"_s}), u"suppressions_formId_email_idx"_s);
+
+    switch (dbType()) {
+    case Firfuorida::Migrator::MariaDB:
+    case Firfuorida::Migrator::MySQL:
+        t->setEngine(u"InnoDB"_s);
+        t->setCharset(u"utf8mb4"_s);
+        break;
+    case Firfuorida::Migrator::DB2:
+    case Firfuorida::Migrator::InterBase:
+    case Firfuorida::Migrator::ODBC:
+    case Firfuorida::Migrator::OCI:
+    case Firfuorida::Migrator::PSQL:
+    case Firfuorida::Migrator::SQLite:
+    case Firfuorida::Migrator::Invalid:
+        break;
+    }
+}
+
+void M0006_CreateSuppressionsTable::down()
+{
+    drop(u"suppressions"_s);
+}
+
+#include "moc_m0006_createsuppressionstable.cpp"
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef M0006_CREATESUPPRESSIONSTABLE_H
+#define M0006_CREATESUPPRESSIONSTABLE_H
+
+#include <Firfuorida/Migration>
+
+class M0006_CreateSuppressionsTable final : public Firfuorida::Migration
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(M0006_CreateSuppressionsTable)
+public:
+    explicit M0006_CreateSuppressionsTable(Firfuorida::Migrator *parent);
+    ~M0006_CreateSuppressionsTable() override = default;
+
+    void up() final;
+    void down() final;
+};
+
+#endif // M0006_CREATESUPPRESSIONSTABLE_H
@@ -60,6 +60,11 @@ void Error::Data::setTitle(Cutelyst::Context *c)
         //% "Method not allowed"
         title = c->qtTrId("hnbota_error_title_notallowed");
         break;
+    case Cutelyst::Response::ServiceUnavailable:
+        //: Error title
+        //% "Service unavailable"
+        title = c->qtTrId("hbnbota_error_title_unavailable");
+        break;
     default:
         //: Error title
         //% "Internal server error"
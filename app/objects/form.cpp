@@ -7,29 +7,65 @@
 
 #include "logging.h"
 #include "objects/error.h"
+#include "objects/localcache.h"
 #include "settings.h"
 
 #include <Cutelyst/Context>
 #include <Cutelyst/Plugins/Memcached/memcached.h>
 #include <Cutelyst/Plugins/Utils/sql.h>
-#include <botan/auto_rng.h>
-#include <botan/cipher_mode.h>
-#include <botan/hex.h>
-#include <botan/rng.h>
 
+#include <QByteArrayView>
+#include <QGlobalStatic>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSqlDatabase>
 #include <QSqlDriver>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QTimeZone>
 #include <QUuid>
 #include <QVariant>
 
+#include <algorithm>
+
 using namespace Qt::Literals::StringLiterals;
 
 #define HBNBOTA_FORM_STASH_KEY u"current_form"_s
 #define HBNBOTA_FORMBYID_MEMC_GROUP_KEY "formsbyid"_ba
-#define HBNBOTA_FORMBYUUID_MEMC_GROUP_KEY "formsbyuuid"_ba
+#define HBNBOTA_FORMIDBYUUID_MEMC_GROUP_KEY "formidsbyuuid"_ba
+
+namespace {
+FormToken::Algorithm tokenAlgorithmFromSettings(const QVariantMap &settings)
+{
+    bool ok              = false;
+    const auto algorithm = FormToken::fromName(settings.value(u"token"_s).toMap().value(u"algorithm"_s).toString(), &ok);
+    return ok ? algorithm : FormToken::Algorithm::Default;
+}
+
+bool proofOfWorkFromSettings(const QVariantMap &settings)
+{
+    return settings.value(u"token"_s).toMap().value(u"proofOfWork"_s).toBool();
+}
+
+struct LocalForms {
+    // every form is stored for both lookups, so they share the limits
+    LocalCache<Form::dbid_t, Form> byId{
+        Settings::localCacheEntries() / 2, Settings::localCacheMemory() / 2, Settings::localCacheTtl()};
+    LocalCache<QString, Form> byUuid{
+        Settings::localCacheEntries() / 2, Settings::localCacheMemory() / 2, Settings::localCacheTtl()};
+};
+
+Q_GLOBAL_STATIC(LocalForms, localForms) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+void toLocalCache(const Form &form)
+{
+    if (localForms->byId.isEnabled()) {
+        const qint64 cost = localCacheCost(form);
+        localForms->byId.insert(form.id(), form, cost);
+        localForms->byUuid.insert(form.uuid(), form, cost);
+    }
+}
+} // namespace
 
 Form::Data::Data(Form::dbid_t _id,
                  const QString &_name,
@@ -49,6 +85,7 @@ Form::Data::Data(Form::dbid_t _id,
     , lockedBy{_lockedBy}
     , uuid{_uuid}
     , secret{_secret}
+    , keys{FormToken::Keys::fromSecret(_secret)}
     , name{_name}
     , domain{_domain}
     , description{_description}
@@ -56,6 +93,9 @@ Form::Data::Data(Form::dbid_t _id,
     , updated{_updated}
     , lockedAt{_lockedAt}
     , settings{_settings}
+    , routing{_settings.value(u"routing"_s).toList()}
+    , tokenAlgorithm{tokenAlgorithmFromSettings(_settings)}
+    , proofOfWork{proofOfWorkFromSettings(_settings)}
     , id{_id}
     , recipientCount{_recipientCount}
 {
@@ -75,6 +115,7 @@ void Form::Data::setUrls(Cutelyst::Context *c)
         urls.insert(u"remoive"_s, c->uriForAction(u"/forms/removeForm", _id));
         urls.insert(u"recipients"_s, c->uriForAction(u"/forms/recipients", _id));
         urls.insert(u"addRecipient"_s, c->uriForAction(u"/forms/addRecipient", _id));
+        urls.insert(u"suppressions"_s, c->uriForAction(u"/forms/suppressions", _id));
     }
 }
 
@@ -167,6 +208,102 @@ QVariantMap Form::settings() const noexcept
     return data ? data->settings : QVariantMap();
 }
 
+int Form::deliveryWeight() const noexcept
+{
+    if (!data) {
+        return 1;
+    }
+    const int weight = data->settings.value(u"mailer"_s).toMap().value(u"weight"_s, 1).toInt();
+    return std::clamp(weight, 1, maxDeliveryWeight);
+}
+
+std::chrono::minutes Form::digestInterval() const noexcept
+{
+    if (!data) {
+        return std::chrono::minutes::zero();
+    }
+    const int interval = data->settings.value(u"digest"_s).toMap().value(u"interval"_s).toInt();
+    return std::chrono::minutes{std::max(interval, 0)};
+}
+
+QDateTime Form::nextDigest(const QDateTime &time) const
+{
+    const qint64 interval = std::chrono::duration_cast<std::chrono::seconds>(digestInterval()).count();
+    if (interval <= 0) {
+        return {};
+    }
+    return QDateTime::fromSecsSinceEpoch((time.toSecsSinceEpoch() / interval + 1) * interval, QTimeZone::UTC);
+}
+
+RoutingTable Form::routing() const noexcept
+{
+    return data ? data->routing : RoutingTable();
+}
+
+bool Form::addRoutingRule(Cutelyst::Context *c, Error &e, const QVariantMap &rule)
+{
+    // the cached settings might be outdated, changes by others must not be overwritten,
+    // SQLite has no row locks but locks the whole database for the write transaction
+    const bool rowLocks = Cutelyst::Sql::databaseThread().driver()->dbmsType() == QSqlDriver::MySqlServer;
+    QSqlQuery q         = rowLocks ? CPreparedSqlQueryThreadFO(u"SELECT settings FROM forms WHERE id = :id FOR UPDATE"_s)
+                                   : CPreparedSqlQueryThreadFO(u"SELECT settings FROM forms WHERE id = :id"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        //: Error message, %1 will be replaced by the form name
+        //% "Failed to update routing rules of form “%1” in database."
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_form_failed_update_routing_db").arg(name()));
+        qCCritical(HBNBOTA_CORE) << "Failed to update routing rules of" << *this << "in database:" << q.lastError().text();
+        return false;
+    }
+
+    q.bindValue(u":id"_s, id());
+
+    if (Q_UNLIKELY(!q.exec())) {
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_form_failed_update_routing_db").arg(name()));
+        qCCritical(HBNBOTA_CORE) << "Failed to update routing rules of" << *this << "in database:" << q.lastError().text();
+        return false;
+    }
+
+    if (Q_UNLIKELY(!q.next())) {
+        e = Error::create(c, Cutelyst::Response::NotFound, c->qtTrId("hbnbota_error_form_getbyid_not_found").arg(id()));
+        qCCritical(HBNBOTA_CORE) << "Can not find" << *this << "in the database";
+        return false;
+    }
+
+    QVariantMap settings = QJsonDocument::fromJson(q.value(0).toByteArray()).object().toVariantMap();
+    QVariantList rules   = settings.value(u"routing"_s).toList();
+    rules.append(rule);
+    settings.insert(u"routing"_s, rules);
+    const QByteArray jsonSettings = QJsonDocument(QJsonObject::fromVariantMap(settings)).toJson(QJsonDocument::Compact);
+    const QDateTime now           = QDateTime::currentDateTimeUtc();
+
+    q = CPreparedSqlQueryThreadFO(u"UPDATE forms SET settings = :settings, updated = :updated WHERE id = :id"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_form_failed_update_routing_db").arg(name()));
+        qCCritical(HBNBOTA_CORE) << "Failed to update routing rules of" << *this << "in database:" << q.lastError().text();
+        return false;
+    }
+
+    q.bindValue(u":settings"_s, jsonSettings);
+    q.bindValue(u":updated"_s, now);
+    q.bindValue(u":id"_s, id());
+
+    if (Q_UNLIKELY(!q.exec())) {
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_form_failed_update_routing_db").arg(name()));
+        qCCritical(HBNBOTA_CORE) << "Failed to update routing rules of" << *this << "in database:" << q.lastError().text();
+        return false;
+    }
+
+    data->settings       = settings;
+    data->routing        = RoutingTable{rules};
+    data->tokenAlgorithm = tokenAlgorithmFromSettings(settings);
+    data->proofOfWork    = proofOfWorkFromSettings(settings);
+    data->updated        = now;
+
+    qCInfo(HBNBOTA_CORE) << User::fromStash(c) << "added routing rule to" << *this;
+
+    return true;
+}
+
 QVariantMap Form::urls() const noexcept
 {
     return data ? data->urls : QVariantMap();
@@ -217,71 +354,37 @@ QByteArray Form::encrypt(const QDateTime &dt) const
         return {};
     }
 
-    const auto ba = QByteArray::number(dt.toMSecsSinceEpoch());
-
-    Botan::AutoSeeded_RNG rng;
-
-    const QByteArray sec           = secret().toUtf8();
-    const std::vector<uint8_t> key = Botan::hex_decode(sec.constData());
-
-    const auto enc = Botan::Cipher_Mode::create("AES-128/GCM", Botan::Cipher_Dir::ENCRYPTION);
-    if (!enc) {
-        qCCritical(HBNBOTA_CORE) << "Failed to encrypt token, can not create Botan::Cipher_Mode object";
-        return {};
-    }
-
-    enc->set_key(key);
-
-    Botan::secure_vector<uint8_t> iv = rng.random_vec(enc->default_nonce_length());
-    Botan::secure_vector<uint8_t> t{ba.constData(), ba.constData() + ba.length()};
-
-    enc->start(iv);
-    enc->finish(t);
-
-    return QByteArray::fromStdString(Botan::hex_encode(iv)) + ":"_ba + QByteArray::fromStdString(Botan::hex_encode(t));
+    return FormToken::create(data->tokenAlgorithm, data->keys, data->uuid, dt);
 }
 
-QDateTime Form::decrypt(const QByteArray &ba) const
+QDateTime Form::decrypt(QByteArrayView ba, FormToken::Nonce *nonce) const
 {
     if (!data) {
         qCCritical(HBNBOTA_CORE) << "Failed to decrypt token, invalid Form object";
         return {};
     }
 
-    const qsizetype colonPos = ba.indexOf(':');
-    if (colonPos < 1) {
-        qCCritical(HBNBOTA_CORE) << "Failed to decrypt token, invalid input data";
-        return {};
-    }
-
-    const QByteArray ivBa   = ba.left(colonPos);
-    const QByteArray dataBa = ba.mid(colonPos + 1);
-
-    Botan::AutoSeeded_RNG rng;
+    return FormToken::verify(data->keys, data->uuid, ba, nonce);
+}
 
-    const QByteArray sec           = secret().toUtf8();
-    const std::vector<uint8_t> key = Botan::hex_decode(sec.constData());
+bool Form::proofOfWork() const noexcept
+{
+    return data ? data->proofOfWork : false;
+}
 
-    const auto dec = Botan::Cipher_Mode::create("AES-128/GCM", Botan::Cipher_Dir::DECRYPTION);
-    if (!dec) {
-        qCCritical(HBNBOTA_CORE) << "Failed to decrypt token, can not create Botan::Cipher_Mode object";
+QByteArray Form::challenge(QByteArrayView token, int difficulty) const
+{
+    if (!data) {
+        qCCritical(HBNBOTA_CORE) << "Failed to create challenge, invalid Form object";
         return {};
     }
 
-    dec->set_key(key);
-
-    Botan::secure_vector<uint8_t> iv = Botan::hex_decode_locked(ivBa.toStdString());
-    Botan::secure_vector<uint8_t> t  = Botan::hex_decode_locked(dataBa.toStdString());
-
-    dec->start(iv);
-    dec->finish(t);
-
-    QByteArray outBa;
-    for (const auto c : t) {
-        outBa.append(static_cast<char>(c));
-    }
+    return FormToken::challenge(data->keys, token, difficulty);
+}
 
-    return QDateTime::fromMSecsSinceEpoch(outBa.toLongLong(), QTimeZone::utc());
+bool Form::verifyWork(QByteArrayView token, QByteArrayView work) const
+{
+    return data && FormToken::verifyWork(data->keys, token, work);
 }
 
 Form::dbid_t Form::toDbId(qulonglong id, bool *ok)
@@ -387,6 +490,11 @@ Form Form::create(Cutelyst::Context *c, Error &e, const QVariantHash &values)
     fields.insert(u"content"_s,
                   QVariantMap({{u"name"_s, values.value(u"formFieldContent"_s)},
                                {u"required"_s, values.value(u"formFieldContentRequired"_s, false)}}));
+    fields.insert(u"policy"_s,
+                  QVariantMap({{u"name"_s, values.value(u"formFieldPolicy"_s)},
+                               {u"required"_s, values.value(u"formFieldPolicyRequired"_s, false)}}));
+    fields.insert(u"time"_s,
+                  QVariantMap({{u"name"_s, values.value(u"formFieldTime"_s, u"token"_s)}, {u"required"_s, true}}));
     settings.insert(u"fields"_s, fields);
     QVariantMap mailer;
     mailer.insert(u"type"_s, values.value(u"senderType"_s));
@@ -398,7 +506,28 @@ Form Form::create(Cutelyst::Context *c, Error &e, const QVariantHash &values)
     smtp.insert(u"encryption"_s, values.value(u"smtpEncryption"_s));
     smtp.insert(u"authentication"_s, values.value(u"smtpAuthentication"_s));
     mailer.insert(u"smtp"_s, smtp);
+    QVariantMap maildir;
+    maildir.insert(u"folder"_s, values.value(u"maildirFolder"_s, uuid));
+    mailer.insert(u"maildir"_s, maildir);
+    QVariantMap webhook;
+    webhook.insert(u"url"_s, values.value(u"webhookUrl"_s));
+    webhook.insert(u"token"_s, values.value(u"webhookToken"_s));
+    webhook.insert(u"batchSize"_s, values.value(u"webhookBatchSize"_s, 1));
+    mailer.insert(u"webhook"_s, webhook);
+    QVariantMap dkim;
+    const QString dkimDomain = values.value(u"dkimDomain"_s).toString();
+    dkim.insert(u"domain"_s, dkimDomain.isEmpty() ? domain : dkimDomain);
+    dkim.insert(u"selector"_s, values.value(u"dkimSelector"_s));
+    dkim.insert(u"key"_s, values.value(u"dkimKey"_s));
+    mailer.insert(u"dkim"_s, dkim);
+    mailer.insert(u"rateLimit"_s, values.value(u"rateLimit"_s, 0));
+    mailer.insert(u"maxSessions"_s, values.value(u"maxSessions"_s, 0));
+    mailer.insert(u"weight"_s, values.value(u"deliveryWeight"_s, 1));
     settings.insert(u"mailer"_s, mailer);
+    settings.insert(u"digest"_s, QVariantMap({{u"interval"_s, values.value(u"digestInterval"_s, 0)}}));
+    settings.insert(u"token"_s,
+                    QVariantMap({{u"algorithm"_s, values.value(u"tokenAlgorithm"_s, u"auto"_s)},
+                                 {u"proofOfWork"_s, values.value(u"tokenProofOfWork"_s, false)}}));
     const QByteArray jsonSettings = QJsonDocument(QJsonObject::fromVariantMap(settings)).toJson(QJsonDocument::Compact);
 
     QSqlQuery q =
@@ -671,14 +800,76 @@ Form Form::get(Cutelyst::Context *c, Error &e, const QString &uuid)
     return f;
 }
 
+Form Form::get(Form::dbid_t id, bool *ok)
+{
+    Form f = Form::fromCache(id);
+    if (!f.isNull()) {
+        if (ok) {
+            *ok = true;
+        }
+        return f;
+    }
+
+    if (ok) {
+        *ok = false;
+    }
+
+    QSqlQuery q = CPreparedSqlQueryThreadFO(
+        u"SELECT f.id, f.name, f.domain, f.userId, f.uuid, f.secret, f.description, f.created, f.updated, f.lockedAt, "
+        "f.lockedBy, f.settings, (SELECT COUNT(*) FROM recipients r WHERE r.formId = f.id) AS recipientCount "
+        "FROM forms f WHERE f.id = :id"_s);
+
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_CORE) << "Failed to get form with ID" << id << "from database:" << q.lastError().text();
+        return f;
+    }
+
+    q.bindValue(u":id"_s, id);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_CORE) << "Failed to get form with ID" << id << "from database:" << q.lastError().text();
+        return f;
+    }
+
+    if (ok) {
+        *ok = true;
+    }
+
+    if (!q.next()) {
+        qCWarning(HBNBOTA_CORE) << "Can not find contact form ID" << id << "in the database";
+        return f;
+    }
+
+    f = Form{Form::toDbId(q.value(0)),
+             q.value(1).toString(),
+             q.value(2).toString(),
+             User(),
+             q.value(4).toString(),
+             q.value(5).toString(),
+             q.value(6).toString(),
+             q.value(7).toDateTime(),
+             q.value(8).toDateTime(),
+             q.value(9).toDateTime(),
+             User(),
+             QJsonDocument::fromJson(q.value(11).toByteArray()).object().toVariantMap(),
+             q.value(12).toInt()};
+
+    return f;
+}
+
 Form Form::fromCache(Form::dbid_t id)
 {
+    if (Form f = localForms->byId.object(id); !f.isNull()) {
+        return f;
+    }
+
     if (Settings::cache() == Settings::Cache::Memcached) {
         Cutelyst::Memcached::ReturnType rt{Cutelyst::Memcached::ReturnType::Failure};
         const Form f =
             Cutelyst::Memcached::getByKey<Form>(HBNBOTA_FORMBYID_MEMC_GROUP_KEY, QByteArray::number(id), nullptr, &rt);
         if (rt == Cutelyst::Memcached::ReturnType::Success) {
             qCDebug(HBNBOTA_CORE) << "Found contact form with ID" << id << "in memcached";
+            toLocalCache(f);
             return f;
         }
     }
@@ -688,12 +879,25 @@ Form Form::fromCache(Form::dbid_t id)
 
 Form Form::fromCache(const QString &uuid)
 {
+    if (Form f = localForms->byUuid.object(uuid); !f.isNull()) {
+        return f;
+    }
+
     if (Settings::cache() == Settings::Cache::Memcached) {
+        // the UUID group only contains the ID of the form that is stored in the ID group
         Cutelyst::Memcached::ReturnType rt{Cutelyst::Memcached::ReturnType::Failure};
-        const Form f = Cutelyst::Memcached::getByKey<Form>(HBNBOTA_FORMBYID_MEMC_GROUP_KEY, uuid.toUtf8(), nullptr, &rt);
-        if (rt == Cutelyst::Memcached::ReturnType::Success) {
-            qCDebug(HBNBOTA_CORE) << "Found contact form with UUID" << uuid << "in memcached";
-            return f;
+        const QByteArray idBa =
+            Cutelyst::Memcached::getByKey(HBNBOTA_FORMIDBYUUID_MEMC_GROUP_KEY, uuid.toUtf8(), nullptr, &rt);
+
+        bool ok               = false;
+        const Form::dbid_t id = Form::toDbId(idBa.toULongLong(&ok));
+        if (rt == Cutelyst::Memcached::ReturnType::Success && ok && id > 0) {
+            // an outdated index entry can point to another form
+            const Form f = Form::fromCache(id);
+            if (!f.isNull() && f.uuid() == uuid) {
+                qCDebug(HBNBOTA_CORE) << "Found contact form with UUID" << uuid << "in memcached";
+                return f;
+            }
         }
     }
 
@@ -702,10 +906,13 @@ Form Form::fromCache(const QString &uuid)
 
 void Form::toCache() const
 {
+    toLocalCache(*this);
+
     if (Settings::cache() == Settings::Cache::Memcached) {
         Cutelyst::Memcached::setByKey<Form>(
             HBNBOTA_FORMBYID_MEMC_GROUP_KEY, QByteArray::number(id()), *this, std::chrono::days{7});
-        Cutelyst::Memcached::setByKey<Form>(HBNBOTA_FORMBYUUID_MEMC_GROUP_KEY, uuid().toUtf8(), *this, std::chrono::days{7});
+        Cutelyst::Memcached::setByKey(
+            HBNBOTA_FORMIDBYUUID_MEMC_GROUP_KEY, uuid().toUtf8(), QByteArray::number(id()), std::chrono::days{7});
     }
 }
 
@@ -756,6 +963,7 @@ QDataStream &operator>>(QDataStream &in, Form &form)
         in >> form.data->uuid;
         in >> form.data->owner;
         in >> form.data->secret;
+        form.data->keys = FormToken::Keys::fromSecret(form.data->secret);
         in >> form.data->name;
         in >> form.data->domain;
         in >> form.data->description;
@@ -764,6 +972,9 @@ QDataStream &operator>>(QDataStream &in, Form &form)
         in >> form.data->lockedAt;
         in >> form.data->lockedBy;
         in >> form.data->settings;
+        form.data->routing        = RoutingTable{form.data->settings.value(u"routing"_s).toList()};
+        form.data->tokenAlgorithm = tokenAlgorithmFromSettings(form.data->settings);
+        form.data->proofOfWork    = proofOfWorkFromSettings(form.data->settings);
         in >> form.data->urls;
         in >> form.data->recipientCount;
     }
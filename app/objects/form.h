@@ -6,12 +6,17 @@
 #ifndef HBNBOTA_FORM_H
 #define HBNBOTA_FORM_H
 
+#include "objects/formtoken.h"
+#include "objects/routingtable.h"
 #include "objects/user.h"
 
+#include <QByteArrayView>
 #include <QDateTime>
 #include <QObject>
 #include <QSharedDataPointer>
 
+#include <chrono>
+
 class Error;
 
 namespace Cutelyst {
@@ -89,6 +94,56 @@ public:
 
     [[nodiscard]] QVariantMap settings() const noexcept;
 
+    /*!
+     * \brief Maximum value of deliveryWeight().
+     */
+    static constexpr int maxDeliveryWeight{100};
+
+    /*!
+     * \brief Returns the number of submissions of this form a delivery thread sends per round.
+     *
+     * Forms take turns in the delivery queue, a form with a higher weight gets a larger share
+     * while several forms have waiting submissions. Set by \c weight in the \c mailer settings.
+     */
+    [[nodiscard]] int deliveryWeight() const noexcept;
+
+    /*!
+     * \brief Returns the interval in which submissions are sent as digest.
+     *
+     * Returns \c 0 if every submission is sent on its own.
+     */
+    [[nodiscard]] std::chrono::minutes digestInterval() const noexcept;
+
+    /*!
+     * \brief Returns the time at which the digest that contains submissions created at \a time is sent.
+     *
+     * The intervals are aligned to the epoch, so all submissions created in the same
+     * interval share the same time. Returns an invalid QDateTime if digestInterval() is \c 0.
+     */
+    [[nodiscard]] QDateTime nextDigest(const QDateTime &time) const;
+
+    /*!
+     * \brief Returns the compiled recipient routing rules from the form settings.
+     */
+    [[nodiscard]] RoutingTable routing() const noexcept;
+
+    /*!
+     * \brief Appends \a rule to the routing rules of this form and stores them in the database.
+     *
+     * The settings are read from the database with a row lock on MySQL/MariaDB, so that concurrent
+     * changes are not overwritten. Call this inside a database transaction to hold the lock until
+     * the transaction is committed, and call toCache() after the commit succeeded. See RoutingTable
+     * for the structure of \a rule. Returns \c false on failure and sets \a e.
+     */
+    bool addRoutingRule(Cutelyst::Context *c, Error &e, const QVariantMap &rule);
+
+    /*!
+     * \brief Stores this form in the local cache and in memcached, if enabled.
+     *
+     * Only call this for data that has been committed to the database.
+     */
+    void toCache() const;
+
     [[nodiscard]] QVariantMap urls() const noexcept;
 
     [[nodiscard]] qint32 recipientCount() const noexcept;
@@ -109,9 +164,40 @@ public:
             *this = Form();
     }
 
+    /*!
+     * \brief Returns a token for the contact form that contains \a dt.
+     *
+     * The token is created with the algorithm set in the \c token settings of the form, or
+     * with FormToken::defaultAlgorithm(). See FormToken for the format.
+     */
     [[nodiscard]] QByteArray encrypt(const QDateTime &dt) const;
 
-    [[nodiscard]] QDateTime decrypt(const QByteArray &ba) const;
+    /*!
+     * \brief Returns the time encrypted in \a ba, or an invalid QDateTime if \a ba is not valid.
+     *
+     * \a ba is parsed in place. Tokens of all algorithms and in the old hex format are accepted.
+     * If \a nonce is not \c nullptr, it is set to the nonce of a valid token.
+     */
+    [[nodiscard]] QDateTime decrypt(QByteArrayView ba, FormToken::Nonce *nonce = nullptr) const;
+
+    /*!
+     * \brief Returns \c true if submissions have to solve a proof-of-work challenge.
+     *
+     * Set by \c proofOfWork in the \c token settings of the form.
+     */
+    [[nodiscard]] bool proofOfWork() const noexcept;
+
+    /*!
+     * \brief Returns a proof-of-work challenge with \a difficulty for \a token.
+     *
+     * See FormToken::challenge() for the format.
+     */
+    [[nodiscard]] QByteArray challenge(QByteArrayView token, int difficulty) const;
+
+    /*!
+     * \brief Returns \c true if \a work solves the challenge for \a token.
+     */
+    [[nodiscard]] bool verifyWork(QByteArrayView token, QByteArrayView work) const;
 
     /*!
      * \brief Returns \a id casted into dbid_t.
@@ -147,6 +233,16 @@ public:
 
     static Form get(Cutelyst::Context *c, Error &e, const QString &uuid);
 
+    /*!
+     * \brief Returns the form identified by \a id without a request context.
+     *
+     * This is used by background threads that deliver messages. The owner and lockedBy
+     * users will not be resolved and no URLs will be set if the form is not found in the
+     * cache. If \a ok is not \c nullptr, failure is reported by setting \a *ok to \c false,
+     * and success by setting \a *ok to \c true.
+     */
+    static Form get(Form::dbid_t id, bool *ok = nullptr);
+
 private:
     class Data : public QSharedData // NOLINT(cppcoreguidelines-special-member-functions)
     {
@@ -176,6 +272,8 @@ private:
         User lockedBy;
         QString uuid;
         QString secret;
+        // keys derived from the secret, so that they have not to be derived for every token
+        FormToken::Keys keys;
         QString name;
         QString domain;
         QString description;
@@ -184,6 +282,9 @@ private:
         QDateTime lockedAt;
         QVariantMap settings;
         QVariantMap urls;
+        RoutingTable routing;
+        FormToken::Algorithm tokenAlgorithm{FormToken::Algorithm::Default};
+        bool proofOfWork{false};
         Form::dbid_t id{0};
         qint32 recipientCount{0};
     };
@@ -192,7 +293,6 @@ private:
 
     static Form fromCache(Form::dbid_t id);
     static Form fromCache(const QString &uuid);
-    void toCache() const;
 
     friend QDataStream &operator<<(QDataStream &out, const Form &form);
     friend QDataStream &operator>>(QDataStream &in, Form &form);
@@ -0,0 +1,757 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "formtoken.h"
+
+#include "logging.h"
+
+#include <botan/aead.h>
+#include <botan/auto_rng.h>
+#include <botan/hash.h>
+#include <botan/hex.h>
+#include <botan/mac.h>
+#include <botan/mem_ops.h>
+
+#include <QGlobalStatic>
+#include <QTimeZone>
+#include <QtEndian>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string_view>
+
+using namespace Qt::Literals::StringLiterals;
+using FormToken::Algorithm;
+
+namespace {
+constexpr qsizetype nonceLength{12};
+constexpr qsizetype timeLength{8};
+constexpr qsizetype tagLength{16};
+constexpr qsizetype keyIdLength{4};
+constexpr qsizetype outerMacLength{8};
+// nonce, encrypted time and tag
+constexpr qsizetype aeadBodyLength{nonceLength + timeLength + tagLength};
+// time and truncated MAC, wrapped tokens start with a nonce too
+constexpr qsizetype macBodyLength{timeLength + tagLength};
+// set in the version byte of tokens that contain the key ID and the outer MAC
+constexpr uint8_t wrappedFlag{0x80};
+constexpr qsizetype maxTokenLength{1 + aeadBodyLength + keyIdLength + outerMacLength};
+
+constexpr qsizetype rawLength(Algorithm algorithm, bool wrapped)
+{
+    if (algorithm == Algorithm::HmacSha256) {
+        return 1 + macBodyLength + (wrapped ? nonceLength + keyIdLength + outerMacLength : 0);
+    }
+    return 1 + aeadBodyLength + (wrapped ? keyIdLength + outerMacLength : 0);
+}
+
+constexpr qsizetype encodedLength(qsizetype length)
+{
+    // base64url without padding
+    return (length * 4 + 2) / 3;
+}
+
+std::atomic<Algorithm> defAlgorithm{Algorithm::Aes128Gcm};
+
+// tokens without key ID and outer MAC have been created by older versions, they are
+// accepted until the configured time, that does not change on restarts
+std::atomic<qint64> legacyDeadline{0};
+
+bool acceptUnwrapped()
+{
+    return QDateTime::currentMSecsSinceEpoch() < legacyDeadline.load(std::memory_order_relaxed);
+}
+
+bool isHex(QByteArrayView ba)
+{
+    return std::all_of(ba.cbegin(), ba.cend(), [](char ch) {
+        return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+    });
+}
+
+// hex(iv) ":" hex(ciphertext + tag), the ciphertext is the time as decimal string
+bool isLegacyToken(QByteArrayView token, qsizetype colonPos)
+{
+    constexpr qsizetype ivHexLength{24};
+    constexpr qsizetype minDataHexLength{(1 + 16) * 2};
+    constexpr qsizetype maxDataHexLength{(19 + 16) * 2};
+
+    const qsizetype dataLength = token.size() - colonPos - 1;
+    return colonPos == ivHexLength && dataLength >= minDataHexLength && dataLength <= maxDataHexLength
+           && dataLength % 2 == 0 && isHex(token.first(colonPos)) && isHex(token.sliced(colonPos + 1));
+}
+
+/*!
+ * \internal
+ * \brief Key of the outer MAC, set by FormToken::setAppSecret().
+ *
+ * Without a secret, the outer MAC is still created but not checked, because a random
+ * key would differ between the processes of the application.
+ */
+struct AppKey {
+    std::array<uint8_t, 16> key{};
+    std::atomic<bool> isSet{false};
+};
+
+Q_GLOBAL_STATIC(AppKey, appKey) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+constexpr std::string_view base64UrlAlphabet{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"};
+
+constexpr std::array<int8_t, 128> base64UrlTable = []() {
+    std::array<int8_t, 128> table{};
+    table.fill(-1);
+    for (size_t i = 0; i < base64UrlAlphabet.size(); ++i) {
+        table[static_cast<uint8_t>(base64UrlAlphabet[i])] = static_cast<int8_t>(i);
+    }
+    return table;
+}();
+
+/*!
+ * \internal
+ * \brief Decodes unpadded base64url \a in into \a out that has to be large enough.
+ *
+ * Returns \c false if \a in contains invalid characters, has an invalid length or is not
+ * canonically encoded.
+ */
+bool decodeBase64Url(QByteArrayView in, uint8_t *out)
+{
+    if (in.size() % 4 == 1) {
+        return false;
+    }
+
+    quint32 buffer = 0;
+    int bits       = 0;
+    for (const char ch : in) {
+        const auto uc = static_cast<uint8_t>(ch);
+        if (uc >= base64UrlTable.size() || base64UrlTable[uc] < 0) {
+            return false;
+        }
+        buffer = (buffer << 6) | static_cast<quint32>(base64UrlTable[uc]);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            *out++ = static_cast<uint8_t>(buffer >> bits);
+        }
+    }
+
+    // unused bits have to be zero, otherwise several inputs would decode to the same data
+    return (buffer & ((1U << bits) - 1)) == 0;
+}
+
+QByteArray encodeBase64Url(const uint8_t *data, qsizetype size)
+{
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(data), size)
+        .toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+}
+
+/*!
+ * \internal
+ * \brief Cipher, MAC and RNG objects used to create and check tokens in the current thread.
+ *
+ * Creating an AutoSeeded_RNG seeds it from the operating system and creating the cipher
+ * objects looks up the implementation, both are much more expensive than creating a token.
+ * The buffer keeps its capacity, so that en- and decrypting does not allocate memory.
+ */
+struct TokenContext {
+    Botan::AutoSeeded_RNG rng;
+    std::unique_ptr<Botan::AEAD_Mode> aesEnc{Botan::AEAD_Mode::create("AES-128/GCM", Botan::Cipher_Dir::ENCRYPTION)};
+    std::unique_ptr<Botan::AEAD_Mode> aesDec{Botan::AEAD_Mode::create("AES-128/GCM", Botan::Cipher_Dir::DECRYPTION)};
+    std::unique_ptr<Botan::AEAD_Mode> chachaEnc{Botan::AEAD_Mode::create("ChaCha20Poly1305", Botan::Cipher_Dir::ENCRYPTION)};
+    std::unique_ptr<Botan::AEAD_Mode> chachaDec{Botan::AEAD_Mode::create("ChaCha20Poly1305", Botan::Cipher_Dir::DECRYPTION)};
+    std::unique_ptr<Botan::MessageAuthenticationCode> hmac{Botan::MessageAuthenticationCode::create("HMAC(SHA-256)")};
+    std::unique_ptr<Botan::MessageAuthenticationCode> siphash{Botan::MessageAuthenticationCode::create("SipHash(2,4)")};
+    std::unique_ptr<Botan::HashFunction> sha256{Botan::HashFunction::create("SHA-256")};
+    Botan::secure_vector<uint8_t> buffer;
+};
+
+TokenContext &context()
+{
+    thread_local TokenContext ctx;
+    return ctx;
+}
+
+QByteArray deriveKey(Botan::MessageAuthenticationCode &hmac, const QByteArray &key, std::string_view label)
+{
+    std::array<uint8_t, 32> derived{};
+    hmac.set_key(reinterpret_cast<const uint8_t *>(key.constData()), key.size());
+    hmac.update(reinterpret_cast<const uint8_t *>(label.data()), label.size());
+    hmac.final(derived.data());
+    return {reinterpret_cast<const char *>(derived.data()), static_cast<qsizetype>(derived.size())};
+}
+
+bool sealAead(Botan::AEAD_Mode &enc, TokenContext &ctx, const QByteArray &key, uint8_t *token, qint64 msecs)
+{
+    uint8_t *nonce = token + 1;
+
+    ctx.buffer.resize(timeLength);
+    qToBigEndian<qint64>(msecs, ctx.buffer.data());
+
+    try {
+        enc.set_key(reinterpret_cast<const uint8_t *>(key.constData()), key.size());
+        // the version is authenticated too
+        enc.set_associated_data(token, 1);
+        ctx.rng.randomize(nonce, nonceLength);
+        enc.start(nonce, nonceLength);
+        enc.finish(ctx.buffer);
+    } catch (const std::exception &ex) {
+        qCCritical(HBNBOTA_CORE) << "Failed to encrypt token:" << ex.what();
+        return false;
+    }
+
+    std::copy(ctx.buffer.cbegin(), ctx.buffer.cend(), nonce + nonceLength);
+
+    return true;
+}
+
+QDateTime openAead(Botan::AEAD_Mode &dec, TokenContext &ctx, const QByteArray &key, const uint8_t *token)
+{
+    const uint8_t *nonce = token + 1;
+    ctx.buffer.assign(nonce + nonceLength, token + 1 + aeadBodyLength);
+
+    try {
+        dec.set_key(reinterpret_cast<const uint8_t *>(key.constData()), key.size());
+        dec.set_associated_data(token, 1);
+        dec.start(nonce, nonceLength);
+        dec.finish(ctx.buffer);
+    } catch (const std::exception &ex) {
+        qCWarning(HBNBOTA_CORE) << "Failed to decrypt token:" << ex.what();
+        return {};
+    }
+
+    if (Q_UNLIKELY(ctx.buffer.size() != static_cast<size_t>(timeLength))) {
+        qCWarning(HBNBOTA_CORE) << "Failed to decrypt token, invalid input data";
+        return {};
+    }
+
+    return QDateTime::fromMSecsSinceEpoch(qFromBigEndian<qint64>(ctx.buffer.data()), QTimeZone::utc());
+}
+
+// the MAC covers version, nonce and time
+void mac(Botan::MessageAuthenticationCode &hmac, const QByteArray &key, const uint8_t *token, qsizetype size, uint8_t *out)
+{
+    std::array<uint8_t, 32> full{};
+    hmac.set_key(reinterpret_cast<const uint8_t *>(key.constData()), key.size());
+    hmac.update(token, size);
+    hmac.final(full.data());
+    std::copy_n(full.cbegin(), tagLength, out);
+}
+
+// wrapped tokens contain a nonce, so that tokens created in the same millisecond differ
+bool sealMac(TokenContext &ctx, const QByteArray &key, uint8_t *token, qint64 msecs)
+{
+    constexpr qsizetype size = 1 + nonceLength + timeLength;
+
+    try {
+        ctx.rng.randomize(token + 1, nonceLength);
+        qToBigEndian<qint64>(msecs, token + 1 + nonceLength);
+        mac(*ctx.hmac, key, token, size, token + size);
+    } catch (const std::exception &ex) {
+        qCCritical(HBNBOTA_CORE) << "Failed to authenticate token:" << ex.what();
+        return false;
+    }
+
+    return true;
+}
+
+QDateTime openMac(TokenContext &ctx, const QByteArray &key, const uint8_t *token, bool wrapped)
+{
+    const qsizetype timePos = 1 + (wrapped ? nonceLength : 0);
+    const qsizetype size    = timePos + timeLength;
+
+    std::array<uint8_t, tagLength> expected{};
+    try {
+        mac(*ctx.hmac, key, token, size, expected.data());
+    } catch (const std::exception &ex) {
+        qCWarning(HBNBOTA_CORE) << "Failed to authenticate token:" << ex.what();
+        return {};
+    }
+
+    if (!Botan::same_mem(expected.data(), token + size, tagLength)) {
+        qCWarning(HBNBOTA_CORE) << "Failed to authenticate token, invalid MAC";
+        return {};
+    }
+
+    return QDateTime::fromMSecsSinceEpoch(qFromBigEndian<qint64>(token + timePos), QTimeZone::utc());
+}
+
+/*!
+ * \internal
+ * \brief Writes the outer MAC of \a size bytes of \a data for the form \a uuid to \a out.
+ */
+bool outerMac(TokenContext &ctx, QStringView uuid, const uint8_t *data, qsizetype size, uint8_t *out)
+{
+    std::array<uint8_t, 64> id{};
+    if (uuid.size() > static_cast<qsizetype>(id.size())) {
+        return false;
+    }
+    // UUIDs are case-insensitive
+    for (qsizetype i = 0; i < uuid.size(); ++i) {
+        id[i] = static_cast<uint8_t>(uuid.at(i).toLower().toLatin1());
+    }
+
+    ctx.siphash->set_key(appKey->key.data(), appKey->key.size());
+    ctx.siphash->update(id.data(), uuid.size());
+    ctx.siphash->update(data, size);
+    ctx.siphash->final(out);
+
+    return true;
+}
+
+bool checkOuterMac(TokenContext &ctx, QStringView uuid, const uint8_t *token, qsizetype length)
+{
+    if (!appKey->isSet) {
+        return true;
+    }
+
+    std::array<uint8_t, outerMacLength> expected{};
+    return ctx.siphash && outerMac(ctx, uuid, token, length - outerMacLength, expected.data())
+           && Botan::same_mem(expected.data(), token + length - outerMacLength, outerMacLength);
+}
+
+/*!
+ * \internal
+ * \brief Decodes \a token into \a raw and returns the algorithm it has been created with.
+ *
+ * Returns Algorithm::Default if \a token is malformed. \a wrapped is set to \c true if the
+ * token contains key ID and outer MAC.
+ */
+Algorithm decode(QByteArrayView token, std::array<uint8_t, maxTokenLength> &raw, bool &wrapped)
+{
+    if (token.size() > encodedLength(maxTokenLength) || !decodeBase64Url(token, raw.data())) {
+        return Algorithm::Default;
+    }
+
+    wrapped              = (raw[0] & wrappedFlag) != 0;
+    const auto algorithm = static_cast<Algorithm>(raw[0] & ~wrappedFlag);
+    if (algorithm != Algorithm::Aes128Gcm && algorithm != Algorithm::ChaCha20Poly1305
+        && algorithm != Algorithm::HmacSha256) {
+        return Algorithm::Default;
+    }
+
+    return token.size() == encodedLength(rawLength(algorithm, wrapped)) ? algorithm : Algorithm::Default;
+}
+
+// base64url of the first 12 bytes of the challenge signature
+constexpr qsizetype challengeSignatureLength{16};
+// longer nonces are not needed to find a solution for maxDifficulty
+constexpr qsizetype maxWorkNonceLength{64};
+
+void challengeSignature(Botan::MessageAuthenticationCode &hmac,
+                        const QByteArray &key,
+                        QByteArrayView token,
+                        int difficulty,
+                        char *out)
+{
+    std::array<uint8_t, 32> full{};
+    const auto bits = static_cast<uint8_t>(difficulty);
+    hmac.set_key(reinterpret_cast<const uint8_t *>(key.constData()), key.size());
+    hmac.update(reinterpret_cast<const uint8_t *>("pow"), 3);
+    hmac.update(reinterpret_cast<const uint8_t *>(token.data()), token.size());
+    hmac.update(bits);
+    hmac.final(full.data());
+
+    for (qsizetype i = 0, j = 0; i < 12; i += 3, j += 4) {
+        const quint32 triple = (full[i] << 16) | (full[i + 1] << 8) | full[i + 2];
+        for (qsizetype k = 0; k < 4; ++k) {
+            out[j + k] = base64UrlAlphabet[(triple >> (18 - k * 6)) & 0x3F];
+        }
+    }
+}
+
+bool hasLeadingZeroBits(const uint8_t *digest, int bits)
+{
+    for (; bits >= 8; bits -= 8, ++digest) {
+        if (*digest != 0) {
+            return false;
+        }
+    }
+    return bits == 0 || (*digest >> (8 - bits)) == 0;
+}
+
+// hex(iv) ":" hex(ciphertext + tag) with the time as decimal string, used before the binary tokens
+QDateTime verifyLegacy(TokenContext &ctx,
+                       const QByteArray &key,
+                       QByteArrayView ba,
+                       qsizetype colonPos,
+                       FormToken::Nonce *nonce)
+{
+    Botan::secure_vector<uint8_t> t;
+
+    try {
+        ctx.aesDec->set_key(reinterpret_cast<const uint8_t *>(key.constData()), key.size());
+        ctx.aesDec->set_associated_data(nullptr, 0);
+
+        const QByteArrayView ivBa   = ba.first(colonPos);
+        const QByteArrayView dataBa = ba.sliced(colonPos + 1);
+
+        const Botan::secure_vector<uint8_t> iv = Botan::hex_decode_locked(ivBa.data(), ivBa.size());
+        t                                      = Botan::hex_decode_locked(dataBa.data(), dataBa.size());
+
+        if (nonce) {
+            nonce->fill(0);
+            std::copy_n(iv.cbegin(), std::min(iv.size(), nonce->size()), nonce->begin());
+        }
+
+        ctx.aesDec->start(iv);
+        ctx.aesDec->finish(t);
+    } catch (const std::exception &ex) {
+        qCWarning(HBNBOTA_CORE) << "Failed to decrypt token:" << ex.what();
+        return {};
+    }
+
+    const QByteArray outBa{reinterpret_cast<const char *>(t.data()), static_cast<qsizetype>(t.size())};
+
+    return QDateTime::fromMSecsSinceEpoch(outBa.toLongLong(), QTimeZone::utc());
+}
+} // namespace
+
+FormToken::Keys FormToken::Keys::fromSecret(const QString &secret)
+{
+    if (secret.isEmpty()) {
+        return {};
+    }
+
+    TokenContext &ctx = context();
+    if (Q_UNLIKELY(!ctx.hmac)) {
+        qCCritical(HBNBOTA_CORE) << "Failed to derive token keys, can not create Botan::MessageAuthenticationCode object";
+        return {};
+    }
+
+    const QByteArray sec = secret.toLatin1();
+
+    Keys keys;
+    try {
+        const std::vector<uint8_t> key = Botan::hex_decode(sec.constData(), sec.size());
+        keys.aes    = QByteArray{reinterpret_cast<const char *>(key.data()), static_cast<qsizetype>(key.size())};
+        keys.chacha = deriveKey(*ctx.hmac, keys.aes, "chacha20-poly1305");
+        keys.mac    = deriveKey(*ctx.hmac, keys.aes, "hmac-sha256");
+        keys.id     = qFromBigEndian<quint32>(deriveKey(*ctx.hmac, keys.aes, "key-id").constData());
+    } catch (const std::exception &ex) {
+        qCCritical(HBNBOTA_CORE) << "Failed to decode form secret:" << ex.what();
+        return {};
+    }
+
+    return keys;
+}
+
+QByteArray FormToken::create(Algorithm algorithm, const Keys &keys, QStringView uuid, const QDateTime &time)
+{
+    if (Q_UNLIKELY(!keys.isValid())) {
+        qCCritical(HBNBOTA_CORE) << "Failed to create token, invalid form secret";
+        return {};
+    }
+
+    if (algorithm == Algorithm::Default) {
+        algorithm = defaultAlgorithm();
+    }
+
+    TokenContext &ctx = context();
+
+    std::array<uint8_t, maxTokenLength> token{};
+    token[0]           = wrappedFlag | static_cast<uint8_t>(algorithm);
+    const qint64 msecs = time.toMSecsSinceEpoch();
+
+    bool sealed = false;
+    switch (algorithm) {
+    case Algorithm::Aes128Gcm:
+        sealed = ctx.aesEnc && sealAead(*ctx.aesEnc, ctx, keys.aes, token.data(), msecs);
+        break;
+    case Algorithm::ChaCha20Poly1305:
+        sealed = ctx.chachaEnc && sealAead(*ctx.chachaEnc, ctx, keys.chacha, token.data(), msecs);
+        break;
+    case Algorithm::HmacSha256:
+        sealed = ctx.hmac && sealMac(ctx, keys.mac, token.data(), msecs);
+        break;
+    case Algorithm::Default:
+        break;
+    }
+
+    const qsizetype length = rawLength(algorithm, true);
+    uint8_t *keyId         = token.data() + length - outerMacLength - keyIdLength;
+    qToBigEndian<quint32>(keys.id, keyId);
+
+    const bool wrapped =
+        sealed && ctx.siphash && outerMac(ctx, uuid, token.data(), length - outerMacLength, keyId + keyIdLength);
+    if (Q_UNLIKELY(!wrapped)) {
+        qCCritical(HBNBOTA_CORE) << "Failed to create token with algorithm" << name(algorithm);
+        return {};
+    }
+
+    return encodeBase64Url(token.data(), length);
+}
+
+bool FormToken::precheck(QStringView uuid, QByteArrayView token)
+{
+    // old hex format
+    if (const qsizetype colonPos = token.indexOf(':'); colonPos >= 0) {
+        return acceptUnwrapped() && isLegacyToken(token, colonPos);
+    }
+
+    std::array<uint8_t, maxTokenLength> raw{};
+    bool wrapped         = false;
+    const auto algorithm = decode(token, raw, wrapped);
+    if (algorithm == Algorithm::Default) {
+        return false;
+    }
+
+    if (!wrapped) {
+        return acceptUnwrapped();
+    }
+
+    return checkOuterMac(context(), uuid, raw.data(), rawLength(algorithm, true));
+}
+
+QDateTime FormToken::verify(const Keys &keys, QStringView uuid, QByteArrayView token, Nonce *nonce)
+{
+    if (Q_UNLIKELY(!keys.isValid())) {
+        qCCritical(HBNBOTA_CORE) << "Failed to verify token, invalid form secret";
+        return {};
+    }
+
+    TokenContext &ctx = context();
+
+    // tokens in the old hex format contain a colon
+    if (const qsizetype colonPos = token.indexOf(':'); colonPos >= 0) {
+        return acceptUnwrapped() && isLegacyToken(token, colonPos) && ctx.aesDec
+                   ? verifyLegacy(ctx, keys.aes, token, colonPos, nonce)
+                   : QDateTime();
+    }
+
+    std::array<uint8_t, maxTokenLength> raw{};
+    bool wrapped         = false;
+    const auto algorithm = decode(token, raw, wrapped);
+    if (algorithm == Algorithm::Default || (!wrapped && !acceptUnwrapped())) {
+        qCWarning(HBNBOTA_CORE) << "Failed to verify token, invalid input data";
+        return {};
+    }
+
+    if (wrapped) {
+        const qsizetype length = rawLength(algorithm, true);
+        if (!checkOuterMac(ctx, uuid, raw.data(), length)) {
+            qCWarning(HBNBOTA_CORE) << "Failed to verify token, invalid outer MAC";
+            return {};
+        }
+        if (qFromBigEndian<quint32>(raw.data() + length - outerMacLength - keyIdLength) != keys.id) {
+            qCWarning(HBNBOTA_CORE) << "Failed to verify token, it has been created with another form secret";
+            return {};
+        }
+    }
+
+    if (nonce) {
+        // unwrapped MAC tokens do not have a nonce, the tag is unique enough to identify them
+        const bool hasNonce = wrapped || algorithm != Algorithm::HmacSha256;
+        std::copy_n(raw.cbegin() + 1 + (hasNonce ? 0 : timeLength), nonce->size(), nonce->begin());
+    }
+
+    switch (algorithm) {
+    case Algorithm::Aes128Gcm:
+        if (ctx.aesDec) {
+            return openAead(*ctx.aesDec, ctx, keys.aes, raw.data());
+        }
+        break;
+    case Algorithm::ChaCha20Poly1305:
+        if (ctx.chachaDec) {
+            return openAead(*ctx.chachaDec, ctx, keys.chacha, raw.data());
+        }
+        break;
+    case Algorithm::HmacSha256:
+        if (ctx.hmac) {
+            return openMac(ctx, keys.mac, raw.data(), wrapped);
+        }
+        break;
+    case Algorithm::Default:
+        break;
+    }
+
+    qCWarning(HBNBOTA_CORE) << "Failed to verify token, algorithm" << name(algorithm) << "is not available";
+    return {};
+}
+
+void FormToken::setAppSecret(QByteArrayView secret)
+{
+    TokenContext &ctx = context();
+    if (Q_UNLIKELY(!ctx.hmac || secret.isEmpty())) {
+        return;
+    }
+
+    const QByteArray key = deriveKey(*ctx.hmac, secret.toByteArray(), "outer-mac");
+    std::copy_n(key.cbegin(), appKey->key.size(), appKey->key.begin());
+    appKey->isSet = true;
+}
+
+void FormToken::setLegacyDeadline(const QDateTime &deadline)
+{
+    legacyDeadline = deadline.isValid() ? deadline.toMSecsSinceEpoch() : 0;
+}
+
+QByteArray FormToken::challenge(const Keys &keys, QByteArrayView token, int difficulty)
+{
+    if (Q_UNLIKELY(!keys.isValid() || difficulty < 1 || difficulty > maxWorkDifficulty)) {
+        qCCritical(HBNBOTA_CORE) << "Failed to create challenge, invalid form secret or difficulty";
+        return {};
+    }
+
+    TokenContext &ctx = context();
+    if (Q_UNLIKELY(!ctx.hmac)) {
+        qCCritical(HBNBOTA_CORE) << "Failed to create challenge, can not create Botan::MessageAuthenticationCode object";
+        return {};
+    }
+
+    std::array<char, challengeSignatureLength> signature{};
+    try {
+        challengeSignature(*ctx.hmac, keys.mac, token, difficulty, signature.data());
+    } catch (const std::exception &ex) {
+        qCCritical(HBNBOTA_CORE) << "Failed to create challenge:" << ex.what();
+        return {};
+    }
+
+    QByteArray ba = QByteArray::number(difficulty);
+    ba.reserve(ba.size() + 1 + challengeSignatureLength);
+    ba.append('.');
+    ba.append(signature.data(), challengeSignatureLength);
+
+    return ba;
+}
+
+bool FormToken::verifyWork(const Keys &keys, QByteArrayView token, QByteArrayView work)
+{
+    // difficulty "." signature ":" nonce
+    const qsizetype dotPos   = work.indexOf('.');
+    const qsizetype colonPos = work.indexOf(':');
+    if (!keys.isValid() || dotPos < 1 || dotPos > 2 || colonPos != dotPos + 1 + challengeSignatureLength
+        || work.size() - colonPos - 1 > maxWorkNonceLength) {
+        return false;
+    }
+
+    int difficulty = 0;
+    for (const char ch : work.first(dotPos)) {
+        if (ch < '0' || ch > '9') {
+            return false;
+        }
+        difficulty = difficulty * 10 + (ch - '0');
+    }
+    if (difficulty < 1 || difficulty > maxWorkDifficulty) {
+        return false;
+    }
+
+    TokenContext &ctx = context();
+    if (Q_UNLIKELY(!ctx.hmac || !ctx.sha256)) {
+        return false;
+    }
+
+    std::array<char, challengeSignatureLength> expected{};
+    std::array<uint8_t, 32> digest{};
+    try {
+        challengeSignature(*ctx.hmac, keys.mac, token, difficulty, expected.data());
+        ctx.sha256->update(reinterpret_cast<const uint8_t *>(token.data()), token.size());
+        ctx.sha256->update(static_cast<uint8_t>(':'));
+        ctx.sha256->update(reinterpret_cast<const uint8_t *>(work.data()), work.size());
+        ctx.sha256->final(digest.data());
+    } catch (const std::exception &ex) {
+        qCWarning(HBNBOTA_CORE) << "Failed to verify proof of work:" << ex.what();
+        return false;
+    }
+
+    return Botan::same_mem(reinterpret_cast<const uint8_t *>(expected.data()),
+                           reinterpret_cast<const uint8_t *>(work.data() + dotPos + 1),
+                           challengeSignatureLength)
+           && hasLeadingZeroBits(digest.data(), difficulty);
+}
+
+QList<Algorithm> FormToken::algorithms()
+{
+    return {Algorithm::Aes128Gcm, Algorithm::ChaCha20Poly1305, Algorithm::HmacSha256};
+}
+
+QString FormToken::name(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case Algorithm::Aes128Gcm:
+        return u"aes-128-gcm"_s;
+    case Algorithm::ChaCha20Poly1305:
+        return u"chacha20-poly1305"_s;
+    case Algorithm::HmacSha256:
+        return u"hmac-sha256"_s;
+    case Algorithm::Default:
+        break;
+    }
+    return u"auto"_s;
+}
+
+Algorithm FormToken::fromName(QStringView name, bool *ok)
+{
+    if (ok) {
+        *ok = true;
+    }
+
+    if (name.isEmpty() || name == "auto"_L1) {
+        return Algorithm::Default;
+    }
+
+    const auto algos = algorithms();
+    const auto it    = std::ranges::find_if(algos, [name](Algorithm a) { return FormToken::name(a) == name; });
+    if (it != algos.cend()) {
+        return *it;
+    }
+
+    if (ok) {
+        *ok = false;
+    }
+    return Algorithm::Default;
+}
+
+Algorithm FormToken::defaultAlgorithm() noexcept
+{
+    return defAlgorithm.load(std::memory_order_relaxed);
+}
+
+void FormToken::setDefaultAlgorithm(Algorithm algorithm) noexcept
+{
+    if (algorithm != Algorithm::Default) {
+        defAlgorithm.store(algorithm, std::memory_order_relaxed);
+    }
+}
+
+double FormToken::benchmark(Algorithm algorithm, std::chrono::milliseconds duration)
+{
+    using clock_type = std::chrono::steady_clock;
+
+    Botan::AutoSeeded_RNG rng;
+    const Keys keys     = Keys::fromSecret(QString::fromStdString(Botan::hex_encode(rng.random_vec(16))));
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    const QString uuid = u"00000000000000000000000000000000"_s;
+
+    // creates the thread local objects before the measurement starts
+    if (!verify(keys, uuid, create(algorithm, keys, uuid, now)).isValid()) {
+        return 0.0;
+    }
+
+    qint64 count     = 0;
+    const auto start = clock_type::now();
+    auto elapsed     = clock_type::duration::zero();
+    do {
+        for (int i = 0; i < 64; ++i) {
+            if (Q_UNLIKELY(!verify(keys, uuid, create(algorithm, keys, uuid, now)).isValid())) {
+                return 0.0;
+            }
+        }
+        count += 64;
+        elapsed = clock_type::now() - start;
+    } while (elapsed < duration);
+
+    return static_cast<double>(count) / std::chrono::duration<double>(elapsed).count();
+}
+
+Algorithm FormToken::fastest(std::chrono::milliseconds duration)
+{
+    const double aes    = benchmark(Algorithm::Aes128Gcm, duration);
+    const double chacha = benchmark(Algorithm::ChaCha20Poly1305, duration);
+    qCDebug(HBNBOTA_CORE) << "Tokens per second:" << name(Algorithm::Aes128Gcm) << aes
+                          << name(Algorithm::ChaCha20Poly1305) << chacha;
+    return chacha > aes ? Algorithm::ChaCha20Poly1305 : Algorithm::Aes128Gcm;
+}
@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_FORMTOKEN_H
+#define HBNBOTA_FORMTOKEN_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+#include <array>
+#include <chrono>
+
+/*!
+ * \brief Creates and checks the time tokens of contact forms.
+ *
+ * A token is the unpadded base64url encoding of a version byte that identifies the
+ * Algorithm, followed by the algorithm specific data. The AEAD algorithms encrypt the
+ * big-endian milliseconds since epoch and store nonce, ciphertext and tag. The MAC-only
+ * algorithm stores nonce, plain time and a truncated HMAC, it is faster but the time is
+ * visible to the client. Tokens of every algorithm are accepted regardless of the
+ * algorithm currently used for new tokens, so changing the algorithm does not invalidate
+ * tokens that have already been sent out.
+ *
+ * New tokens set the highest bit of the version byte and are followed by the 32 bit ID
+ * of the form key and a 64 bit SipHash over the form UUID and the token, keyed by an
+ * app-wide secret. This outer MAC can be checked by precheck() before the form has been
+ * loaded, so that forged tokens are rejected without any cache or database access.
+ * Tokens without outer MAC, including the old hex format, are only accepted until the
+ * time set by setLegacyDeadline().
+ *
+ * Cipher, MAC and RNG objects are created once per thread.
+ */
+namespace FormToken {
+
+/*!
+ * \brief Minimum age of a token, submissions that are faster are likely sent by bots.
+ */
+constexpr std::chrono::milliseconds minAge{2'000};
+
+/*!
+ * \brief Maximum age of a token.
+ */
+constexpr std::chrono::milliseconds maxAge{std::chrono::hours{6}};
+
+enum class Algorithm : quint8 {
+    Default          = 0, /**< Use the algorithm returned by defaultAlgorithm(). */
+    Aes128Gcm        = 1,
+    ChaCha20Poly1305 = 2,
+    HmacSha256       = 3, /**< Authenticates the time without encrypting it. */
+};
+
+/*!
+ * \brief Random value that identifies a single token, used to detect replayed tokens.
+ */
+using Nonce = std::array<quint8, 12>;
+
+/*!
+ * \brief Keys of a form for all algorithms.
+ */
+struct Keys {
+    // the decoded form secret, also used for tokens in the old hex format
+    QByteArray aes;
+    QByteArray chacha;
+    QByteArray mac;
+    // identifies the form secret in the token
+    quint32 id{0};
+
+    /*!
+     * \brief Returns the keys derived from the hex encoded form \a secret.
+     */
+    [[nodiscard]] static Keys fromSecret(const QString &secret);
+
+    [[nodiscard]] bool isValid() const noexcept { return !aes.isEmpty(); }
+};
+
+/*!
+ * \brief Returns a token for \a time created with \a algorithm and \a keys for the form \a uuid.
+ *
+ * Returns an empty byte array on failure.
+ */
+[[nodiscard]] QByteArray create(Algorithm algorithm, const Keys &keys, QStringView uuid, const QDateTime &time);
+
+/*!
+ * \brief Returns \c true if the outer MAC of \a token is valid for the form \a uuid.
+ *
+ * Does not need the keys of the form and does not decrypt the token. A valid outer MAC
+ * does not mean that the token is valid, it still has to be checked with verify(). If
+ * setAppSecret() has not been called, only the format of \a token is checked.
+ */
+[[nodiscard]] bool precheck(QStringView uuid, QByteArrayView token);
+
+/*!
+ * \brief Returns the time in \a token if it has been created with \a keys for the form \a uuid.
+ *
+ * \a token is parsed in place. Returns an invalid QDateTime if the token is not valid.
+ * If \a nonce is not \c nullptr, it is set to the nonce of a valid token.
+ */
+[[nodiscard]] QDateTime verify(const Keys &keys, QStringView uuid, QByteArrayView token, Nonce *nonce = nullptr);
+
+/*!
+ * \brief Sets the app-wide \a secret the outer MAC key is derived from.
+ *
+ * Has to be the same for all processes of the application and should be called only once
+ * per process, before any token is created. Until it has been called, the outer MAC is not
+ * checked.
+ */
+void setAppSecret(QByteArrayView secret);
+
+/*!
+ * \brief Sets the time until that tokens without outer MAC and in the old hex format are accepted.
+ *
+ * Such tokens have been created by older versions. Until this has been called with a valid
+ * \a deadline, they are rejected.
+ */
+void setLegacyDeadline(const QDateTime &deadline);
+
+/*!
+ * \brief Maximum difficulty of a proof-of-work challenge in bits.
+ */
+constexpr int maxWorkDifficulty{32};
+
+/*!
+ * \brief Returns a proof-of-work challenge with \a difficulty for \a token.
+ *
+ * The challenge has the form difficulty "." signature, the signature prevents clients from
+ * lowering the difficulty. A client has to find a nonce, so that the SHA-256 hash of
+ * token ":" challenge ":" nonce starts with \a difficulty zero bits. Returns an empty byte
+ * array on failure.
+ */
+[[nodiscard]] QByteArray challenge(const Keys &keys, QByteArrayView token, int difficulty);
+
+/*!
+ * \brief Returns \c true if \a work solves a challenge created with \a keys for \a token.
+ *
+ * \a work has the form challenge ":" nonce. Verification needs one HMAC for the challenge
+ * signature and a single hash of the solution.
+ */
+[[nodiscard]] bool verifyWork(const Keys &keys, QByteArrayView token, QByteArrayView work);
+
+/*!
+ * \brief Returns all algorithms except Algorithm::Default.
+ */
+[[nodiscard]] QList<Algorithm> algorithms();
+
+/*!
+ * \brief Returns the configuration name of \a algorithm.
+ */
+[[nodiscard]] QString name(Algorithm algorithm);
+
+/*!
+ * \brief Returns the Algorithm for \a name.
+ *
+ * If \a ok is not \c nullptr, failure is reported by setting \a *ok to \c false,
+ * and success by setting \a *ok to \c true.
+ */
+[[nodiscard]] Algorithm fromName(QStringView name, bool *ok = nullptr);
+
+/*!
+ * \brief Returns the algorithm used for forms that use Algorithm::Default.
+ */
+[[nodiscard]] Algorithm defaultAlgorithm() noexcept;
+
+/*!
+ * \brief Sets the algorithm used for forms that use Algorithm::Default.
+ */
+void setDefaultAlgorithm(Algorithm algorithm) noexcept;
+
+/*!
+ * \brief Returns the number of tokens per second that can be created and verified with \a algorithm.
+ *
+ * Runs for about \a duration in the current thread.
+ */
+[[nodiscard]] double benchmark(Algorithm algorithm, std::chrono::milliseconds duration);
+
+/*!
+ * \brief Returns the faster of the encrypting algorithms on this host.
+ *
+ * The MAC-only algorithm is not taken into account, because it does not hide the time.
+ */
+[[nodiscard]] Algorithm fastest(std::chrono::milliseconds duration);
+
+} // namespace FormToken
+
+#endif // HBNBOTA_FORMTOKEN_H
@@ -0,0 +1,179 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_LOCALCACHE_H
+#define HBNBOTA_LOCALCACHE_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <chrono>
+#include <list>
+
+/*!
+ * \brief In-memory least recently used cache with a time to live, shared by all threads of a process.
+ *
+ * The cache is bounded by the number of entries and by the sum of the costs given to insert(),
+ * the least recently used entries are removed first if one of the limits is reached. Entries
+ * are dropped by object() after \a ttl has been passed. A cache constructed with a limit or
+ * \a ttl of \c 0 stores nothing.
+ *
+ * \a T has to be an implicitly shared type, object() returns a copy of the stored value.
+ */
+template <typename Key, typename T>
+class LocalCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LocalCache(qsizetype maxEntries, qint64 maxCost, std::chrono::milliseconds ttl)
+        : m_maxEntries{maxEntries}
+        , m_maxCost{maxCost}
+        , m_ttl{ttl}
+    {
+    }
+
+    /*!
+     * \brief Returns \c true if the cache can store entries.
+     */
+    [[nodiscard]] bool isEnabled() const noexcept { return m_maxEntries > 0 && m_maxCost > 0 && m_ttl.count() > 0; }
+
+    /*!
+     * \brief Returns the value for \a key, or a default constructed \a T if there is no valid entry.
+     */
+    [[nodiscard]] T object(const Key &key, Clock::time_point now = Clock::now())
+    {
+        if (!isEnabled()) {
+            return {};
+        }
+
+        QMutexLocker locker(&m_mutex);
+
+        const auto it = m_index.constFind(key);
+        if (it == m_index.cend()) {
+            return {};
+        }
+
+        const auto entry = it.value();
+        if (entry->expires <= now) {
+            m_cost -= entry->cost;
+            m_entries.erase(entry);
+            m_index.erase(it);
+            return {};
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, entry);
+        return entry->value;
+    }
+
+    /*!
+     * \brief Inserts \a value with \a cost for \a key, replacing an existing entry.
+     *
+     * If \a cost is larger than the maximum cost of the cache, an existing entry for \a key
+     * is removed and \a value is not stored.
+     */
+    void insert(const Key &key, const T &value, qint64 cost, Clock::time_point now = Clock::now())
+    {
+        if (!isEnabled()) {
+            return;
+        }
+
+        QMutexLocker locker(&m_mutex);
+
+        removeEntry(key);
+
+        if (cost > m_maxCost) {
+            return;
+        }
+
+        m_entries.push_front(Entry{key, value, cost, now + m_ttl});
+        m_index.insert(key, m_entries.begin());
+        m_cost += cost;
+
+        while (m_index.size() > m_maxEntries || m_cost > m_maxCost) {
+            const Entry &last = m_entries.back();
+            m_cost -= last.cost;
+            m_index.remove(last.key);
+            m_entries.pop_back();
+        }
+    }
+
+    /*!
+     * \brief Removes the entry for \a key.
+     */
+    void remove(const Key &key)
+    {
+        if (!isEnabled()) {
+            return;
+        }
+
+        QMutexLocker locker(&m_mutex);
+        removeEntry(key);
+    }
+
+    /*!
+     * \brief Returns the number of entries, including expired ones that have not been dropped yet.
+     */
+    [[nodiscard]] qsizetype size() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_index.size();
+    }
+
+    /*!
+     * \brief Returns the sum of the costs of all entries.
+     */
+    [[nodiscard]] qint64 cost() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_cost;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        T value;
+        qint64 cost{0};
+        Clock::time_point expires;
+    };
+
+    // has to be called with locked mutex
+    void removeEntry(const Key &key)
+    {
+        const auto it = m_index.constFind(key);
+        if (it != m_index.cend()) {
+            m_cost -= it.value()->cost;
+            m_entries.erase(it.value());
+            m_index.erase(it);
+        }
+    }
+
+    mutable QMutex m_mutex;
+    // most recently used entries first
+    std::list<Entry> m_entries;
+    QHash<Key, typename std::list<Entry>::iterator> m_index;
+    const qsizetype m_maxEntries{0};
+    const qint64 m_maxCost{0};
+    const std::chrono::milliseconds m_ttl{0};
+    qint64 m_cost{0};
+};
+
+/*!
+ * \related LocalCache
+ * \brief Returns the size of \a value serialized to a QDataStream, used as cost for LocalCache::insert().
+ */
+template <typename T>
+[[nodiscard]] qint64 localCacheCost(const T &value)
+{
+    QByteArray ba;
+    QDataStream out(&ba, QIODevice::WriteOnly);
+    out << value;
+    return ba.size();
+}
+
+#endif // HBNBOTA_LOCALCACHE_H
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "messagetemplate.h"
+
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr std::array<QLatin1StringView, MessageTemplate::PlaceholderCount> placeholderNames{"sender-name"_L1,
+                                                                                           "sender-email"_L1,
+                                                                                           "sender-phone"_L1,
+                                                                                           "sender-url"_L1,
+                                                                                           "subject"_L1,
+                                                                                           "content"_L1,
+                                                                                           "form-name"_L1,
+                                                                                           "form-domain"_L1,
+                                                                                           "date"_L1};
+} // namespace
+
+int MessageTemplate::placeholderFromName(QStringView name)
+{
+    const auto it = std::find(placeholderNames.cbegin(), placeholderNames.cend(), name);
+    return it != placeholderNames.cend() ? static_cast<int>(std::distance(placeholderNames.cbegin(), it)) : -1;
+}
+
+MessageTemplate::MessageTemplate(const QString &source)
+    : m_source{source}
+{
+    qsizetype literalStart = 0;
+    qsizetype pos          = 0;
+
+    while ((pos = m_source.indexOf("{{"_L1, pos)) >= 0) {
+        const qsizetype end = m_source.indexOf("}}"_L1, pos + 2);
+        if (end < 0) {
+            break;
+        }
+
+        const int placeholder = placeholderFromName(QStringView{m_source}.sliced(pos + 2, end - pos - 2));
+        if (placeholder < 0) {
+            ++pos;
+            continue;
+        }
+
+        if (pos > literalStart) {
+            m_segments.append({literalStart, pos - literalStart, -1});
+            m_literalLength += pos - literalStart;
+        }
+        m_segments.append({0, 0, placeholder});
+
+        pos          = end + 2;
+        literalStart = pos;
+    }
+
+    if (m_segments.empty()) {
+        // no placeholders, render() returns the source
+        m_literalLength = m_source.size();
+        return;
+    }
+
+    if (literalStart < m_source.size()) {
+        m_segments.append({literalStart, m_source.size() - literalStart, -1});
+        m_literalLength += m_source.size() - literalStart;
+    }
+}
+
+QString MessageTemplate::render(const Values &values, RenderOption option) const
+{
+    if (!hasPlaceholders()) {
+        return m_source;
+    }
+
+    if (option == HtmlEscape) {
+        // only the values that are used by the template are escaped
+        Values escaped;
+        for (const Segment &segment : m_segments) {
+            if (segment.placeholder >= 0 && escaped[segment.placeholder].isNull()) {
+                escaped[segment.placeholder] =
+                    values[segment.placeholder].toHtmlEscaped().replace(u'\'', "&#39;"_L1);
+            }
+        }
+        return render(escaped);
+    }
+
+    qsizetype size = m_literalLength;
+    for (const Segment &segment : m_segments) {
+        if (segment.placeholder >= 0) {
+            size += values[segment.placeholder].size();
+        }
+    }
+
+    QString out{size, Qt::Uninitialized};
+    QChar *dst = out.data();
+
+    for (const Segment &segment : m_segments) {
+        if (segment.placeholder < 0) {
+            dst = std::copy_n(m_source.constData() + segment.pos, segment.length, dst);
+        } else {
+            const QString &value = values[segment.placeholder];
+            dst                  = std::copy_n(value.constData(), value.size(), dst);
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_MESSAGETEMPLATE_H
+#define HBNBOTA_MESSAGETEMPLATE_H
+
+#include <QList>
+#include <QString>
+
+#include <array>
+
+/*!
+ * \brief A message template string that has been split into literal and placeholder segments.
+ *
+ * The template is parsed once on construction. render() then computes the exact size of
+ * the output and fills a single buffer, instead of scanning the whole string once per
+ * placeholder.
+ *
+ * Supported placeholders are {{sender-name}}, {{sender-email}}, {{sender-phone}},
+ * {{sender-url}}, {{subject}}, {{content}}, {{form-name}}, {{form-domain}} and {{date}}.
+ * Unknown placeholders are kept as literal text.
+ */
+class MessageTemplate
+{
+public:
+    enum Placeholder : int {
+        SenderName = 0,
+        SenderEmail,
+        SenderPhone,
+        SenderUrl,
+        Subject,
+        Content,
+        FormName,
+        FormDomain,
+        Date,
+        PlaceholderCount
+    };
+
+    /*!
+     * \brief Values for the placeholders, indexed by Placeholder.
+     */
+    using Values = std::array<QString, PlaceholderCount>;
+
+    /*!
+     * \brief Options for render().
+     */
+    enum RenderOption : int {
+        NoOption = 0,
+        HtmlEscape ///< Escapes HTML special characters in the values, the template itself is not changed.
+    };
+
+    MessageTemplate() noexcept = default;
+
+    /*!
+     * \brief Constructs a new %MessageTemplate by parsing \a source.
+     */
+    explicit MessageTemplate(const QString &source);
+
+    /*!
+     * \brief Returns the template with all placeholders replaced by \a values.
+     *
+     * Use HtmlEscape as \a option for HTML templates, the values are submitted by visitors.
+     */
+    [[nodiscard]] QString render(const Values &values, RenderOption option = NoOption) const;
+
+    [[nodiscard]] QString source() const noexcept { return m_source; }
+
+    [[nodiscard]] bool isEmpty() const noexcept { return m_source.isEmpty(); }
+
+    [[nodiscard]] bool hasPlaceholders() const noexcept { return m_literalLength != m_source.size(); }
+
+    /*!
+     * \brief Returns the Placeholder for \a name without braces, or \c -1 if it is unknown.
+     */
+    [[nodiscard]] static int placeholderFromName(QStringView name);
+
+private:
+    struct Segment {
+        qsizetype pos{0};
+        qsizetype length{0};
+        // -1 for literal segments referring to a part of the source
+        int placeholder{-1};
+    };
+
+    QString m_source;
+    QList<Segment> m_segments;
+    qsizetype m_literalLength{0};
+};
+
+#endif // HBNBOTA_MESSAGETEMPLATE_H
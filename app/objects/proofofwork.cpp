@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "proofofwork.h"
+
+#include "formtoken.h"
+
+#include <QDateTime>
+#include <QGlobalStatic>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+
+static_assert(ProofOfWork::maxDifficulty <= FormToken::maxWorkDifficulty);
+
+namespace {
+constexpr qint64 minuteMSecs{60'000};
+
+struct Counter {
+    qint64 minute{0};
+    int current{0};
+    int previous{0};
+};
+
+struct RateVals {
+    QMutex mutex;
+    QHash<QString, Counter> forms;
+};
+
+Q_GLOBAL_STATIC(RateVals, rates) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+} // namespace
+
+void ProofOfWork::recordSubmission(const QString &uuid)
+{
+    const qint64 minute = QDateTime::currentMSecsSinceEpoch() / minuteMSecs;
+
+    QMutexLocker locker(&rates->mutex);
+
+    Counter &counter = rates->forms[uuid];
+    if (counter.minute != minute) {
+        counter.previous = counter.minute == minute - 1 ? counter.current : 0;
+        counter.current  = 0;
+        counter.minute   = minute;
+    }
+    ++counter.current;
+}
+
+double ProofOfWork::rate(const QString &uuid)
+{
+    const qint64 now    = QDateTime::currentMSecsSinceEpoch();
+    const qint64 minute = now / minuteMSecs;
+
+    // part of the previous minute that lies within the last 60 seconds
+    const double previousWeight = 1.0 - static_cast<double>(now % minuteMSecs) / minuteMSecs;
+
+    QMutexLocker locker(&rates->mutex);
+
+    const auto it = rates->forms.constFind(uuid);
+    if (it == rates->forms.cend()) {
+        return 0.0;
+    }
+
+    if (it->minute == minute) {
+        return it->current + it->previous * previousWeight;
+    }
+    if (it->minute == minute - 1) {
+        return it->current * previousWeight;
+    }
+    return 0.0;
+}
+
+int ProofOfWork::difficulty(double rate)
+{
+    if (rate <= baseRate) {
+        return minDifficulty;
+    }
+
+    const int extra = static_cast<int>(std::floor(std::log2(rate / baseRate))) + 1;
+    return std::min(minDifficulty + extra, maxDifficulty);
+}
+
+int ProofOfWork::difficulty(const QString &uuid)
+{
+    return difficulty(rate(uuid));
+}
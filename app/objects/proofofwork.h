@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_PROOFOFWORK_H
+#define HBNBOTA_PROOFOFWORK_H
+
+#include <QString>
+
+/*!
+ * \brief Chooses the difficulty of proof-of-work challenges by the submission rate of a form.
+ *
+ * Every process counts the accepted submissions per form and minute. As long as a form
+ * gets no more than baseRate submissions per minute, challenges have minDifficulty bits,
+ * that a browser solves in a few milliseconds. Every doubling of the rate above that adds
+ * one bit, and with it doubles the work for every submission, up to maxDifficulty.
+ */
+namespace ProofOfWork {
+
+constexpr int minDifficulty{12};
+constexpr int maxDifficulty{24};
+// submissions per minute that are handled with minDifficulty
+constexpr double baseRate{10.0};
+
+/*!
+ * \brief Counts an accepted submission for the form with \a uuid.
+ */
+void recordSubmission(const QString &uuid);
+
+/*!
+ * \brief Returns the submissions per minute for the form with \a uuid.
+ *
+ * The count of the previous minute is weighted by the part of it that lies within the
+ * last 60 seconds.
+ */
+[[nodiscard]] double rate(const QString &uuid);
+
+/*!
+ * \brief Returns the difficulty for \a rate submissions per minute.
+ */
+[[nodiscard]] int difficulty(double rate);
+
+/*!
+ * \brief Returns the difficulty for the current submission rate of the form with \a uuid.
+ */
+[[nodiscard]] int difficulty(const QString &uuid);
+
+} // namespace ProofOfWork
+
+#endif // HBNBOTA_PROOFOFWORK_H
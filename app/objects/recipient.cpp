@@ -14,6 +14,7 @@
 #include <Cutelyst/Plugins/Utils/sql.h>
 
 #include <QJsonDocument>
+#include <QSqlDatabase>
 #include <QSqlDriver>
 #include <QSqlError>
 #include <QSqlQuery>
@@ -60,6 +61,7 @@ Recipient::Data::Data(Recipient::dbid_t _id,
     if (lockedAt.isValid()) {
         lockedAt.setTimeSpec(Qt::UTC);
     }
+    compileTemplates();
 }
 
 void Recipient::Data::setUrls(Cutelyst::Context *c)
@@ -67,6 +69,20 @@ void Recipient::Data::setUrls(Cutelyst::Context *c)
     Q_UNUSED(c)
 }
 
+void Recipient::Data::compileTemplates()
+{
+    const auto replyTo = settings.value(u"replyTo"_s).toMap();
+
+    templates.fromName     = MessageTemplate{fromName};
+    templates.toName       = MessageTemplate{toName};
+    templates.toEmail      = MessageTemplate{toEmail};
+    templates.replyToName  = MessageTemplate{replyTo.value(u"name"_s).toString()};
+    templates.replyToEmail = MessageTemplate{replyTo.value(u"email"_s).toString()};
+    templates.subject      = MessageTemplate{subject};
+    templates.text         = MessageTemplate{text};
+    templates.html         = MessageTemplate{html};
+}
+
 Recipient::Recipient(Recipient::dbid_t id,
                      const Form &form,
                      const QString &fromName,
@@ -168,6 +184,11 @@ User Recipient::lockedBy() const noexcept
     return data ? data->lockedBy : User();
 }
 
+Recipient::Templates Recipient::templates() const noexcept
+{
+    return data ? data->templates : Recipient::Templates();
+}
+
 bool Recipient::isValid() const noexcept
 {
     return data && data->id > 0;
@@ -233,7 +254,7 @@ Recipient Recipient::create(Cutelyst::Context *c, const Form &form, Error &e, co
     const auto fromEmail = values.value(u"fromEmail"_s).toString();
     const auto toName    = values.value(u"toName"_s).toString();
     const auto toEmail   = values.value(u"toEmail"_s).toString();
-    const auto subject   = values.value(u"fromName"_s).toString();
+    const auto subject   = values.value(u"subject"_s).toString();
     const auto text      = values.value(u"text"_s).toString();
     const auto html      = values.value(u"html"_s).toString();
     const auto now       = QDateTime::currentDateTimeUtc();
@@ -244,14 +265,24 @@ Recipient Recipient::create(Cutelyst::Context *c, const Form &form, Error &e, co
     settings.insert(u"replyTo"_s, replyTo);
     const QByteArray jsonSettings = QJsonDocument(QJsonObject::fromVariantMap(settings)).toJson(QJsonDocument::Compact);
 
+    // the recipient and its routing rule are stored together, a recipient without its rule would get all submissions
+    QSqlDatabase db = Cutelyst::Sql::databaseThread();
+    if (Q_UNLIKELY(!db.transaction())) {
+        //: Error message
+        //% "Failed to insert new recipient into database."
+        e = Error::create(c, db.lastError(), c->qtTrId("hbnbota_error_recipient_failed_create_db"));
+        qCCritical(HBNBOTA_CORE) << "Failed to start database transaction to insert new recipient:"
+                                 << db.lastError().text();
+        return {};
+    }
+
     QSqlQuery q = CPreparedSqlQueryThread(
         u"INSERT INTO recipients (formId, fromName, fromEmail, toName, toEmail, subject, text, html, settings, created) "
         "VALUES (:formId, :fromName, :fromEmail, :toName, :toEmail, :subject, :text, :html, :settings, :created)"_s);
     if (Q_UNLIKELY(q.lastError().isValid())) {
-        //: Error message
-        //% "Failed to insert new recipient into database."
         e = Error::create(c, q, c->qtTrId("hbnbota_error_recipient_failed_create_db"));
         qCCritical(HBNBOTA_CORE) << "Failed to insert new recipient into database:" << q.lastError().text();
+        db.rollback();
         return {};
     }
 
@@ -269,6 +300,7 @@ Recipient Recipient::create(Cutelyst::Context *c, const Form &form, Error &e, co
     if (Q_UNLIKELY(!q.exec())) {
         e = Error::create(c, q, c->qtTrId("hbnbota_error_recipient_failed_create_db"));
         qCCritical(HBNBOTA_CORE) << "Failed to insert new recipient into database:" << q.lastError().text();
+        db.rollback();
         return {};
     }
 
@@ -284,7 +316,34 @@ Recipient Recipient::create(Cutelyst::Context *c, const Form &form, Error &e, co
         id = Recipient::toDbId(q.value(0));
     }
 
-    Recipient r{id, form, fromName, fromEmail, toName, toEmail, subject, text, html, settings, now, {}, {}, {}};
+    Form f                = form;
+    const bool routeAdded = !values.value(u"routeField"_s).toString().isEmpty();
+    if (routeAdded) {
+        if (!f.addRoutingRule(c,
+                              e,
+                              {{u"recipient"_s, id},
+                               {u"field"_s, values.value(u"routeField"_s)},
+                               {u"operator"_s, values.value(u"routeOperator"_s)},
+                               {u"value"_s, values.value(u"routeValue"_s)}})) {
+            db.rollback();
+            return {};
+        }
+    }
+
+    if (Q_UNLIKELY(!db.commit())) {
+        e = Error::create(c, db.lastError(), c->qtTrId("hbnbota_error_recipient_failed_create_db"));
+        qCCritical(HBNBOTA_CORE) << "Failed to commit database transaction to insert new recipient:"
+                                 << db.lastError().text();
+        db.rollback();
+        return {};
+    }
+
+    // the cached form must not get a routing rule that has not been committed
+    if (routeAdded) {
+        f.toCache();
+    }
+
+    Recipient r{id, f, fromName, fromEmail, toName, toEmail, subject, text, html, settings, now, {}, {}, {}};
     r.data->setUrls(c);
     r.toCache();
 
@@ -347,6 +406,57 @@ QList<Recipient> Recipient::list(Cutelyst::Context *c, const Form &form, Error &
     return lst;
 }
 
+QList<Recipient> Recipient::list(const Form &form, bool *ok)
+{
+    QSqlQuery q = CPreparedSqlQueryThreadFO(
+        u"SELECT id, fromName, fromEmail, toName, toEmail, subject, text, html, settings, created, updated, lockedAt FROM recipients WHERE formId = :formId"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        qCCritical(HBNBOTA_CORE) << "Failed to query recipients for" << form << "from database:" << q.lastError().text();
+        if (ok) {
+            *ok = false;
+        }
+        return {};
+    }
+
+    q.bindValue(u":formId"_s, form.id());
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_CORE) << "Failed to query recipients for" << form << "from database:" << q.lastError().text();
+        if (ok) {
+            *ok = false;
+        }
+        return {};
+    }
+
+    QList<Recipient> lst;
+    if (q.size() > 0) {
+        lst.reserve(q.size());
+    }
+
+    while (q.next()) {
+        lst.emplace_back(Recipient::toDbId(q.value(0)),
+                         form,
+                         q.value(1).toString(),
+                         q.value(2).toString(),
+                         q.value(3).toString(),
+                         q.value(4).toString(),
+                         q.value(5).toString(),
+                         q.value(6).toString(),
+                         q.value(7).toString(),
+                         QJsonDocument::fromJson(q.value(8).toByteArray()).object().toVariantMap(),
+                         q.value(9).toDateTime(),
+                         q.value(10).toDateTime(),
+                         q.value(11).toDateTime(),
+                         User());
+    }
+
+    if (ok) {
+        *ok = true;
+    }
+
+    return lst;
+}
+
 Recipient Recipient::fromCache(Recipient::dbid_t id)
 {
     if (Settings::cache() == Settings::Cache::Memcached) {
@@ -439,6 +549,7 @@ QDataStream &operator>>(QDataStream &in, Recipient &recipient)
         in >> recipient.data->updated;
         in >> recipient.data->lockedAt;
         in >> recipient.data->lockedBy;
+        recipient.data->compileTemplates();
     }
 
     return in;
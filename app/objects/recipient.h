@@ -7,6 +7,7 @@
 #define HBNBOTA_RECIPIENT_H
 
 #include "form.h"
+#include "messagetemplate.h"
 #include "user.h"
 
 #include <QDateTime>
@@ -40,6 +41,20 @@ class Recipient
 public:
     using dbid_t = quint32;
 
+    /*!
+     * \brief The message templates of a recipient, parsed once when the recipient is loaded.
+     */
+    struct Templates {
+        MessageTemplate fromName;
+        MessageTemplate toName;
+        MessageTemplate toEmail;
+        MessageTemplate replyToName;
+        MessageTemplate replyToEmail;
+        MessageTemplate subject;
+        MessageTemplate text;
+        MessageTemplate html;
+    };
+
     Recipient() noexcept = default;
 
     Recipient(Recipient::dbid_t id,
@@ -93,6 +108,8 @@ public:
 
     [[nodiscard]] User lockedBy() const noexcept;
 
+    [[nodiscard]] Templates templates() const noexcept;
+
     [[nodiscard]] bool isValid() const noexcept;
 
     [[nodiscard]] bool isNull() const noexcept { return !data; }
@@ -126,10 +143,26 @@ public:
 
     static QMap<QString, QString> labels(Cutelyst::Context *c);
 
+    /*!
+     * \brief Creates a new recipient for \a form from \a values and stores it in the database.
+     *
+     * If \a values contain a \c routeField, a routing rule with \c routeOperator and \c routeValue
+     * is added to \a form in the same database transaction. Returns an invalid %Recipient on
+     * failure and sets \a e.
+     */
     static Recipient create(Cutelyst::Context *c, const Form &form, Error &e, const QVariantHash &values);
 
     static QList<Recipient> list(Cutelyst::Context *c, const Form &form, Error &e);
 
+    /*!
+     * \brief Returns the list of recipients for \a form without a request context.
+     *
+     * This is used by background threads that deliver messages. The lockedBy user
+     * will not be resolved. If \a ok is not \c nullptr, failure is reported by setting
+     * \a *ok to \c false, and success by setting \a *ok to \c true.
+     */
+    static QList<Recipient> list(const Form &form, bool *ok = nullptr);
+
 private:
     class Data : public QSharedData // NOLINT(cppcoreguidelines-special-member-functions)
     {
@@ -155,6 +188,7 @@ private:
         ~Data() noexcept              = default;
 
         void setUrls(Cutelyst::Context *c);
+        void compileTemplates();
 
         Form form;
         User lockedBy;
@@ -169,6 +203,7 @@ private:
         QDateTime created;
         QDateTime updated;
         QDateTime lockedAt;
+        Recipient::Templates templates;
         Recipient::dbid_t id{0};
     };
 
@@ -0,0 +1,182 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "replaycache.h"
+
+#include "logging.h"
+#include "settings.h"
+
+#include <Cutelyst/Plugins/Memcached/memcached.h>
+
+#include <QGlobalStatic>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Qt::Literals::StringLiterals;
+
+#define HBNBOTA_REPLAY_MEMC_GROUP_KEY "replay"_ba
+
+namespace {
+// tokens are valid for six buckets, the remaining buckets are the ones that are cleared next
+constexpr qint64 bucketWidth{FormToken::maxAge.count() / 6};
+// open addressing needs free entries, a bucket is full at three quarters
+constexpr qsizetype maxLoadNumerator{3};
+constexpr qsizetype maxLoadDenominator{4};
+
+struct ReplaySetHolder {
+    ReplaySet set{Settings::replayCacheSize()};
+};
+
+Q_GLOBAL_STATIC(ReplaySetHolder, holder) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+QByteArray memcKey(const FormToken::Nonce &nonce)
+{
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(nonce.data()), static_cast<qsizetype>(nonce.size()))
+        .toHex();
+}
+} // namespace
+
+ReplaySet::ReplaySet(qsizetype capacity)
+{
+    if (capacity <= 0) {
+        return;
+    }
+
+    // capacity is per maxAge, six buckets share it
+    const qsizetype perBucket = capacity / 6 / shardCount * maxLoadDenominator / maxLoadNumerator + 1;
+    m_bucketCapacity          = 16;
+    while (m_bucketCapacity < perBucket) {
+        m_bucketCapacity *= 2;
+    }
+
+    for (Shard &shard : m_shards) {
+        for (Bucket &bucket : shard.buckets) {
+            bucket.entries.resize(static_cast<size_t>(m_bucketCapacity));
+        }
+    }
+}
+
+bool ReplaySet::insert(const FormToken::Nonce &nonce, qint64 msecs)
+{
+    if (m_bucketCapacity == 0) {
+        return true;
+    }
+
+    if (Q_UNLIKELY(msecs < 0)) {
+        return false;
+    }
+
+    quint64 high = 0;
+    quint32 low  = 0;
+    std::memcpy(&high, nonce.data(), sizeof(high));
+    std::memcpy(&low, nonce.data() + sizeof(high), sizeof(low));
+
+    const qint64 epoch = msecs / bucketWidth;
+    Shard &shard       = m_shards[high % shardCount];
+
+    QMutexLocker locker(&shard.mutex);
+
+    Bucket &bucket = shard.buckets[epoch % bucketCount];
+    if (bucket.epoch < epoch) {
+        // all tokens in this bucket have been expired
+        std::fill(bucket.entries.begin(), bucket.entries.end(), Entry{});
+        bucket.epoch = epoch;
+        bucket.size  = 0;
+    } else if (bucket.epoch > epoch) {
+        return false;
+    }
+
+    // nonces are random, so their bits are used as hash
+    const quint64 mask = static_cast<quint64>(m_bucketCapacity - 1);
+    for (quint64 i = (high / shardCount) & mask;; i = (i + 1) & mask) {
+        Entry &entry = bucket.entries[i];
+        if (entry.used == Free) {
+            if (Q_UNLIKELY(bucket.size * maxLoadDenominator >= m_bucketCapacity * maxLoadNumerator)) {
+                qCWarning(HBNBOTA_CORE) << "Replay cache is full, can not check tokens for replay";
+                return true;
+            }
+            entry = Entry{high, low, Used};
+            ++bucket.size;
+            return true;
+        }
+
+        if (entry.high == high && entry.low == low) {
+            if (entry.used == Released) {
+                entry.used = Used;
+                return true;
+            }
+            return false;
+        }
+    }
+}
+
+void ReplaySet::remove(const FormToken::Nonce &nonce, qint64 msecs)
+{
+    if (m_bucketCapacity == 0 || msecs < 0) {
+        return;
+    }
+
+    quint64 high = 0;
+    quint32 low  = 0;
+    std::memcpy(&high, nonce.data(), sizeof(high));
+    std::memcpy(&low, nonce.data() + sizeof(high), sizeof(low));
+
+    const qint64 epoch = msecs / bucketWidth;
+    Shard &shard       = m_shards[high % shardCount];
+
+    QMutexLocker locker(&shard.mutex);
+
+    Bucket &bucket = shard.buckets[epoch % bucketCount];
+    if (bucket.epoch != epoch) {
+        return;
+    }
+
+    const quint64 mask = static_cast<quint64>(m_bucketCapacity - 1);
+    for (quint64 i = (high / shardCount) & mask;; i = (i + 1) & mask) {
+        Entry &entry = bucket.entries[i];
+        if (entry.used == Free) {
+            return;
+        }
+
+        if (entry.high == high && entry.low == low) {
+            entry.used = Released;
+            return;
+        }
+    }
+}
+
+bool ReplayCache::consume(const FormToken::Nonce &nonce, const QDateTime &time)
+{
+    if (!holder->set.insert(nonce, time.toMSecsSinceEpoch())) {
+        return false;
+    }
+
+    if (Settings::cache() == Settings::Cache::Memcached) {
+        const auto age = std::chrono::milliseconds{time.msecsTo(QDateTime::currentDateTimeUtc())};
+        const auto expiration =
+            std::max(std::chrono::duration_cast<std::chrono::seconds>(FormToken::maxAge - age), std::chrono::seconds{1});
+        const QByteArray key = memcKey(nonce);
+
+        // add fails if another process has already used the token
+        Cutelyst::Memcached::ReturnType rt{Cutelyst::Memcached::ReturnType::Failure};
+        Cutelyst::Memcached::addByKey(HBNBOTA_REPLAY_MEMC_GROUP_KEY, key, "1"_ba, expiration, &rt);
+        if (rt == Cutelyst::Memcached::ReturnType::NotStored) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ReplayCache::release(const FormToken::Nonce &nonce, const QDateTime &time)
+{
+    holder->set.remove(nonce, time.toMSecsSinceEpoch());
+
+    if (Settings::cache() == Settings::Cache::Memcached) {
+        Cutelyst::Memcached::removeByKey(HBNBOTA_REPLAY_MEMC_GROUP_KEY, memcKey(nonce));
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_REPLAYCACHE_H
+#define HBNBOTA_REPLAYCACHE_H
+
+#include "formtoken.h"
+
+#include <QDateTime>
+#include <QMutex>
+
+#include <array>
+#include <vector>
+
+/*!
+ * \brief Set of the nonces of consumed tokens, grouped by the time of the tokens.
+ *
+ * The set is split into shards with their own lock, and every shard into time buckets
+ * that each cover a sixth of FormToken::maxAge. A bucket is cleared as a whole when it is
+ * reused for newer tokens, at that time all of its tokens have been expired. Every bucket
+ * is a fixed-size open addressing hash table that is allocated once by the constructor,
+ * so insert() neither allocates nor depends on the number of stored nonces.
+ */
+class ReplaySet
+{
+public:
+    /*!
+     * \brief Constructs a new %ReplaySet that can store about \a capacity nonces per FormToken::maxAge.
+     */
+    explicit ReplaySet(qsizetype capacity);
+
+    /*!
+     * \brief Adds the \a nonce of a token created at \a msecs since epoch.
+     *
+     * Returns \c false if \a nonce has already been added, or if the bucket for \a msecs has
+     * already been reused for newer tokens. If the bucket is full, \a nonce is not stored and
+     * \c true is returned.
+     */
+    [[nodiscard]] bool insert(const FormToken::Nonce &nonce, qint64 msecs);
+
+    /*!
+     * \brief Removes the \a nonce of a token created at \a msecs since epoch, so that it can be added again.
+     */
+    void remove(const FormToken::Nonce &nonce, qint64 msecs);
+
+private:
+    // removed entries are kept as released, so that the probing for other nonces does not stop at them
+    enum EntryState : quint32 { Free = 0, Used, Released };
+
+    struct Entry {
+        quint64 high{0};
+        quint32 low{0};
+        quint32 used{Free};
+    };
+
+    struct Bucket {
+        std::vector<Entry> entries;
+        qint64 epoch{-1};
+        qsizetype size{0};
+    };
+
+    static constexpr qsizetype shardCount{16};
+    static constexpr qsizetype bucketCount{8};
+
+    struct Shard {
+        QMutex mutex;
+        std::array<Bucket, bucketCount> buckets;
+    };
+
+    std::array<Shard, shardCount> m_shards;
+    qsizetype m_bucketCapacity{0};
+};
+
+/*!
+ * \brief Rejects submission tokens that have already been used.
+ *
+ * Every process keeps a ReplaySet with Settings::replayCacheSize() entries. If memcached
+ * is used as cache, consumed nonces are also added to memcached, so that a token can only
+ * be used once across all processes of a multi-process deployment.
+ */
+namespace ReplayCache {
+
+/*!
+ * \brief Returns \c true if the token with \a nonce and \a time has not been used before and marks it as used.
+ */
+[[nodiscard]] bool consume(const FormToken::Nonce &nonce, const QDateTime &time);
+
+/*!
+ * \brief Releases the token with \a nonce and \a time consumed by consume(), so that it can be used again.
+ *
+ * Use this if the submission could not be stored after the token has been consumed.
+ */
+void release(const FormToken::Nonce &nonce, const QDateTime &time);
+
+} // namespace ReplayCache
+
+#endif // HBNBOTA_REPLAYCACHE_H
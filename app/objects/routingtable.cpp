@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "routingtable.h"
+
+#include <QBitArray>
+#include <QVariantMap>
+
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr std::array<QLatin1StringView, 4> operatorNames{"equals"_L1, "contains"_L1, "startsWith"_L1, "endsWith"_L1};
+} // namespace
+
+RoutingTable::RoutingTable(const QVariantList &rules)
+{
+    for (const QVariant &var : rules) {
+        const auto rule = var.toMap();
+
+        bool ok             = false;
+        const quint32 id    = rule.value(u"recipient"_s).toUInt(&ok);
+        const int field     = MessageTemplate::placeholderFromName(rule.value(u"field"_s).toString());
+        const int op        = operatorFromName(rule.value(u"operator"_s).toString());
+        const QString value = rule.value(u"value"_s).toString().toCaseFolded();
+        if (!ok || id == 0 || field < 0 || field >= fieldCount || op < 0 || value.isEmpty()) {
+            continue;
+        }
+
+        qsizetype recipient = m_recipients.indexOf(id);
+        if (recipient < 0) {
+            recipient = m_recipients.size();
+            m_recipients << id;
+        }
+
+        m_fields[field].append(Rule{value, recipient, static_cast<Operator>(op)});
+        ++m_size;
+    }
+}
+
+QList<quint32> RoutingTable::excluded(const MessageTemplate::Values &values) const
+{
+    if (m_recipients.empty()) {
+        return {};
+    }
+
+    QBitArray matched{m_recipients.size()};
+
+    for (int field = 0; field < fieldCount; ++field) {
+        const QList<Rule> &rules = m_fields.at(field);
+        if (rules.empty()) {
+            continue;
+        }
+
+        const QString folded = values.at(field).toCaseFolded();
+        for (const Rule &rule : rules) {
+            if (matched.testBit(rule.recipient)) {
+                continue;
+            }
+
+            bool match = false;
+            switch (rule.op) {
+            case Operator::Equals:
+                match = folded == rule.value;
+                break;
+            case Operator::Contains:
+                match = folded.contains(rule.value);
+                break;
+            case Operator::StartsWith:
+                match = folded.startsWith(rule.value);
+                break;
+            case Operator::EndsWith:
+                match = folded.endsWith(rule.value);
+                break;
+            }
+
+            if (match) {
+                matched.setBit(rule.recipient);
+            }
+        }
+    }
+
+    QList<quint32> lst;
+    for (qsizetype i = 0; i < m_recipients.size(); ++i) {
+        if (!matched.testBit(i)) {
+            lst << m_recipients.at(i);
+        }
+    }
+
+    return lst;
+}
+
+int RoutingTable::operatorFromName(QStringView name)
+{
+    const auto it = std::find(operatorNames.cbegin(), operatorNames.cend(), name);
+    return it != operatorNames.cend() ? static_cast<int>(std::distance(operatorNames.cbegin(), it)) : -1;
+}
@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_ROUTINGTABLE_H
+#define HBNBOTA_ROUTINGTABLE_H
+
+#include "messagetemplate.h"
+
+#include <QList>
+#include <QString>
+#include <QVariantList>
+
+#include <array>
+
+/*!
+ * \brief Decides which recipients of a form get a submission, based on the submitted values.
+ *
+ * The rules are stored in the \c routing list of the form settings. Every rule is a map
+ * with the ID of the \c recipient, the submitted \c field it checks (sender-name,
+ * sender-email, sender-phone, sender-url, subject or content), the \c operator (equals,
+ * contains, startsWith or endsWith) and the \c value to compare with. Comparisons are
+ * case-insensitive. A recipient with rules gets a submission if at least one of its rules
+ * matches, recipients without rules get all submissions.
+ *
+ * The rules are compiled once when the form is loaded: values are case-folded and the
+ * rules are grouped by field. excluded() then folds every submitted field only once and
+ * checks all rules for that field against it, instead of evaluating the stored rules
+ * one after another for every submission.
+ */
+class RoutingTable
+{
+public:
+    enum class Operator : quint8 { Equals, Contains, StartsWith, EndsWith };
+
+    RoutingTable() noexcept = default;
+
+    /*!
+     * \brief Constructs a new %RoutingTable by compiling \a rules.
+     *
+     * Invalid rules are ignored.
+     */
+    explicit RoutingTable(const QVariantList &rules);
+
+    /*!
+     * \brief Returns the IDs of the recipients that should not get a submission with \a values.
+     */
+    [[nodiscard]] QList<quint32> excluded(const MessageTemplate::Values &values) const;
+
+    [[nodiscard]] bool isEmpty() const noexcept { return m_recipients.empty(); }
+
+    /*!
+     * \brief Returns the number of valid rules.
+     */
+    [[nodiscard]] qsizetype size() const noexcept { return m_size; }
+
+    /*!
+     * \brief Returns the Operator for \a name, or \c -1 if it is unknown.
+     */
+    [[nodiscard]] static int operatorFromName(QStringView name);
+
+private:
+    struct Rule {
+        QString value;
+        // index of the recipient in m_recipients
+        qsizetype recipient{0};
+        Operator op{Operator::Equals};
+    };
+
+    // only the submitted fields can be checked, not form name, domain or date
+    static constexpr int fieldCount{MessageTemplate::Content + 1};
+
+    std::array<QList<Rule>, fieldCount> m_fields;
+    QList<quint32> m_recipients;
+    qsizetype m_size{0};
+};
+
+#endif // HBNBOTA_ROUTINGTABLE_H
@@ -0,0 +1,234 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "submission.h"
+
+#include "logging.h"
+#include "objects/error.h"
+
+#include <Cutelyst/Context>
+#include <Cutelyst/Plugins/Utils/sql.h>
+
+#include <QJsonDocument>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+
+using namespace Qt::Literals::StringLiterals;
+
+Submission::Data::Data(Submission::dbid_t _id,
+                       Form _form,
+                       const QVariantMap &_data,
+                       QString _remoteAddress,
+                       QDateTime _created)
+    : QSharedData()
+    , form{std::move(_form)}
+    , senderName{_data.value(u"name"_s).toString()}
+    , senderEmail{_data.value(u"email"_s).toString()}
+    , senderPhone{_data.value(u"phone"_s).toString()}
+    , senderUrl{_data.value(u"url"_s).toString()}
+    , subject{_data.value(u"subject"_s).toString()}
+    , content{_data.value(u"content"_s).toString()}
+    , remoteAddress{std::move(_remoteAddress)}
+    , created{std::move(_created)}
+    , id{_id}
+{
+    created.setTimeSpec(Qt::UTC);
+}
+
+Submission::Submission(dbid_t id,
+                       const Form &form,
+                       const QVariantMap &data,
+                       const QString &remoteAddress,
+                       const QDateTime &created)
+    : data{new Submission::Data{id, form, data, remoteAddress, created}}
+{
+}
+
+Submission::dbid_t Submission::id() const noexcept
+{
+    return data ? data->id : 0;
+}
+
+Form Submission::form() const noexcept
+{
+    return data ? data->form : Form();
+}
+
+QString Submission::senderName() const noexcept
+{
+    return data ? data->senderName : QString();
+}
+
+QString Submission::senderEmail() const noexcept
+{
+    return data ? data->senderEmail : QString();
+}
+
+QString Submission::senderPhone() const noexcept
+{
+    return data ? data->senderPhone : QString();
+}
+
+QString Submission::senderUrl() const noexcept
+{
+    return data ? data->senderUrl : QString();
+}
+
+QString Submission::subject() const noexcept
+{
+    return data ? data->subject : QString();
+}
+
+QString Submission::content() const noexcept
+{
+    return data ? data->content : QString();
+}
+
+QString Submission::remoteAddress() const noexcept
+{
+    return data ? data->remoteAddress : QString();
+}
+
+QDateTime Submission::created() const noexcept
+{
+    return data ? data->created : QDateTime();
+}
+
+bool Submission::isValid() const noexcept
+{
+    return data && data->id > 0;
+}
+
+QJsonObject Submission::toJson() const
+{
+    if (isNull()) {
+        return {};
+    }
+
+    return {{u"name"_s, data->senderName},
+            {u"email"_s, data->senderEmail},
+            {u"phone"_s, data->senderPhone},
+            {u"url"_s, data->senderUrl},
+            {u"subject"_s, data->subject},
+            {u"content"_s, data->content}};
+}
+
+MessageTemplate::Values Submission::placeholderValues() const
+{
+    if (isNull()) {
+        return {};
+    }
+
+    MessageTemplate::Values values;
+    values[MessageTemplate::SenderName]  = data->senderName;
+    values[MessageTemplate::SenderEmail] = data->senderEmail;
+    values[MessageTemplate::SenderPhone] = data->senderPhone;
+    values[MessageTemplate::SenderUrl]   = data->senderUrl;
+    values[MessageTemplate::Subject]     = data->subject;
+    values[MessageTemplate::Content]     = data->content;
+    values[MessageTemplate::FormName]    = data->form.name();
+    values[MessageTemplate::FormDomain]  = data->form.domain();
+    values[MessageTemplate::Date]        = data->created.toString(Qt::RFC2822Date);
+    return values;
+}
+
+Submission::dbid_t Submission::toDbId(qulonglong id, bool *ok)
+{
+    if (id > static_cast<qulonglong>(std::numeric_limits<Submission::dbid_t>::max())) {
+        if (ok) {
+            *ok = false;
+        }
+        return 0;
+    }
+
+    if (ok) {
+        *ok = true;
+    }
+
+    return static_cast<Submission::dbid_t>(id);
+}
+
+Submission::dbid_t Submission::toDbId(const QVariant &var, bool *ok)
+{
+    bool _ok      = false;
+    const auto id = var.toULongLong(&_ok);
+    if (_ok) {
+        return toDbId(id, ok);
+    }
+
+    if (ok) {
+        *ok = false;
+    }
+
+    return 0;
+}
+
+Submission Submission::create(Cutelyst::Context *c, const Form &form, Error &e, const QVariantHash &values)
+{
+    const QVariantMap data{{u"name"_s, values.value(u"name"_s).toString()},
+                           {u"email"_s, values.value(u"email"_s).toString()},
+                           {u"phone"_s, values.value(u"phone"_s).toString()},
+                           {u"url"_s, values.value(u"url"_s).toString()},
+                           {u"subject"_s, values.value(u"subject"_s).toString()},
+                           {u"content"_s, values.value(u"content"_s).toString()}};
+    const QString remoteAddress = c->req()->addressString();
+    const QDateTime now         = QDateTime::currentDateTimeUtc();
+    const QByteArray jsonData   = QJsonDocument(QJsonObject::fromVariantMap(data)).toJson(QJsonDocument::Compact);
+
+    // submissions for digests are held back until the digest is due
+    const QDateTime digest = form.nextDigest(now);
+
+    QSqlQuery q = CPreparedSqlQueryThread(u"INSERT INTO outbox (formId, data, remoteAddress, created, nextAttempt) "
+                                          "VALUES (:formId, :data, :remoteAddress, :created, :nextAttempt)"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        //: Error message
+        //% "Failed to save the submitted data."
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_submission_failed_create_db"));
+        qCCritical(HBNBOTA_CORE) << "Failed to insert new submission for" << form
+                                 << "into database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":formId"_s, form.id());
+    q.bindValue(u":data"_s, jsonData);
+    q.bindValue(u":remoteAddress"_s, remoteAddress);
+    q.bindValue(u":created"_s, now);
+    q.bindValue(u":nextAttempt"_s, digest.isValid() ? QVariant{digest} : QVariant{QMetaType::fromType<QDateTime>()});
+
+    if (Q_UNLIKELY(!q.exec())) {
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_submission_failed_create_db"));
+        qCCritical(HBNBOTA_CORE) << "Failed to insert new submission for" << form
+                                 << "into database:" << q.lastError().text();
+        return {};
+    }
+
+    const auto id = Submission::toDbId(q.lastInsertId());
+
+    Submission s{id, form, data, remoteAddress, now};
+
+    qCDebug(HBNBOTA_CORE) << "Created new" << s;
+
+    return s;
+}
+
+QDebug operator<<(QDebug dbg, const Submission &submission)
+{
+    QDebugStateSaver saver(dbg);
+    dbg.nospace() << "Submission(";
+    if (!submission.isNull()) {
+        if (submission.isValid()) {
+            dbg << "ID: " << submission.id();
+            dbg << ", Form ID: " << submission.form().id();
+            dbg << ", Created: " << submission.created();
+        } else {
+            dbg << "INVALID";
+        }
+    }
+    dbg << ')';
+    return dbg;
+}
+
+#include "moc_submission.cpp"
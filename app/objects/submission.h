@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_SUBMISSION_H
+#define HBNBOTA_SUBMISSION_H
+
+#include "form.h"
+#include "messagetemplate.h"
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QObject>
+#include <QSharedDataPointer>
+
+class Error;
+
+namespace Cutelyst {
+class Context;
+}
+
+/*!
+ * \brief Contains the data sent by a visitor through a contact form.
+ */
+class Submission
+{
+    Q_GADGET
+    Q_PROPERTY(Submission::dbid_t id READ id CONSTANT)
+    Q_PROPERTY(Form form READ form CONSTANT)
+    Q_PROPERTY(QString senderName READ senderName CONSTANT)
+    Q_PROPERTY(QString senderEmail READ senderEmail CONSTANT)
+    Q_PROPERTY(QString senderPhone READ senderPhone CONSTANT)
+    Q_PROPERTY(QString senderUrl READ senderUrl CONSTANT)
+    Q_PROPERTY(QString subject READ subject CONSTANT)
+    Q_PROPERTY(QString content READ content CONSTANT)
+    Q_PROPERTY(QString remoteAddress READ remoteAddress CONSTANT)
+    Q_PROPERTY(QDateTime created READ created CONSTANT)
+public:
+    using dbid_t = quint32;
+
+    Submission() noexcept = default;
+
+    /*!
+     * \brief Constructs a new %Submission for \a form.
+     *
+     * \a data contains the submitted values identified by the same keys that are
+     * used for the fields in the form settings: name, email, phone, url, subject
+     * and content.
+     */
+    Submission(dbid_t id, const Form &form, const QVariantMap &data, const QString &remoteAddress, const QDateTime &created);
+
+    Submission(const Submission &other) noexcept            = default;
+    Submission(Submission &&other) noexcept                 = default;
+    Submission &operator=(const Submission &other) noexcept = default;
+    Submission &operator=(Submission &&other) noexcept      = default;
+    ~Submission() noexcept                                  = default;
+
+    void swap(Submission &other) noexcept { data.swap(other.data); }
+
+    [[nodiscard]] dbid_t id() const noexcept;
+
+    [[nodiscard]] Form form() const noexcept;
+
+    [[nodiscard]] QString senderName() const noexcept;
+
+    [[nodiscard]] QString senderEmail() const noexcept;
+
+    [[nodiscard]] QString senderPhone() const noexcept;
+
+    [[nodiscard]] QString senderUrl() const noexcept;
+
+    [[nodiscard]] QString subject() const noexcept;
+
+    [[nodiscard]] QString content() const noexcept;
+
+    [[nodiscard]] QString remoteAddress() const noexcept;
+
+    [[nodiscard]] QDateTime created() const noexcept;
+
+    [[nodiscard]] bool isValid() const noexcept;
+
+    [[nodiscard]] bool isNull() const noexcept { return !data; }
+
+    void clear()
+    {
+        if (!isNull()) {
+            *this = Submission();
+        }
+    }
+
+    /*!
+     * \brief Returns the submitted values as JSON object.
+     */
+    [[nodiscard]] QJsonObject toJson() const;
+
+    /*!
+     * \brief Returns the values of this submission for the placeholders in a MessageTemplate.
+     */
+    [[nodiscard]] MessageTemplate::Values placeholderValues() const;
+
+    /*!
+     * \brief Returns \a id casted into dbid_t.
+     *
+     * Returns \c 0 if the value would overflow the dbid_t.
+     *
+     * If \a ok is not \c nullptr, failure is reported by setting \a *ok to \c false,
+     * and success by setting \a *ok to \c true.
+     */
+    static dbid_t toDbId(qulonglong id, bool *ok = nullptr);
+
+    /*!
+     * \brief Returns \a var converted to dbid_t.
+     *
+     * Returns \c 0 if the conversion fails.
+     *
+     * If \a ok is not \c nullptr, failure is reported by setting \a *ok to \c false,
+     * and success by setting \a *ok to \c true.
+     */
+    static dbid_t toDbId(const QVariant &var, bool *ok = nullptr);
+
+    /*!
+     * \brief Stores a new submission for \a form with the given \a values in the outbox.
+     *
+     * This is the only database write on the request path. The delivery threads
+     * will pick up the new entry from the outbox and move it into the submissions
+     * table after the messages have been sent. If the \a form uses digests, the entry
+     * will not be delivered before Form::nextDigest(). On failure, a null submission
+     * will be returned and \a e will contain the error.
+     */
+    static Submission create(Cutelyst::Context *c, const Form &form, Error &e, const QVariantHash &values);
+
+private:
+    class Data : public QSharedData // NOLINT(cppcoreguidelines-special-member-functions)
+    {
+    public:
+        Data() noexcept = default;
+        Data(Submission::dbid_t _id, Form _form, const QVariantMap &_data, QString _remoteAddress, QDateTime _created);
+
+        Data(const Data &) noexcept   = default;
+        Data &operator=(const Data &) = delete;
+        ~Data() noexcept              = default;
+
+        Form form;
+        QString senderName;
+        QString senderEmail;
+        QString senderPhone;
+        QString senderUrl;
+        QString subject;
+        QString content;
+        QString remoteAddress;
+        QDateTime created;
+        Submission::dbid_t id{0};
+    };
+
+    QSharedDataPointer<Data> data;
+};
+
+Q_DECLARE_SHARED(Submission) // NOLINT(modernize-type-traits)
+Q_DECLARE_METATYPE(Submission)
+
+/*!
+ * \related Submission
+ * \brief Writes the \a submission to the debug stream \a dbg and returns a refererence to the stream.
+ */
+QDebug operator<<(QDebug dbg, const Submission &submission);
+
+#endif // HBNBOTA_SUBMISSION_H
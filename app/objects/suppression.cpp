@@ -0,0 +1,307 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "suppression.h"
+
+#include "delivery/suppressionlist.h"
+#include "logging.h"
+#include "objects/error.h"
+
+#include <Cutelyst/Context>
+#include <Cutelyst/Plugins/Utils/sql.h>
+
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+
+using namespace Qt::Literals::StringLiterals;
+
+Suppression::Data::Data(Suppression::dbid_t _id,
+                        Form::dbid_t _formId,
+                        QString _email,
+                        QString _reason,
+                        QDateTime _created)
+    : QSharedData()
+    , email{std::move(_email)}
+    , reason{std::move(_reason)}
+    , created{std::move(_created)}
+    , id{_id}
+    , formId{_formId}
+{
+    created.setTimeSpec(Qt::UTC);
+}
+
+Suppression::Suppression(Suppression::dbid_t id,
+                         Form::dbid_t formId,
+                         const QString &email,
+                         const QString &reason,
+                         const QDateTime &created)
+    : data(new Suppression::Data(id, formId, email, reason, created))
+{
+}
+
+Suppression::dbid_t Suppression::id() const noexcept
+{
+    return data ? data->id : 0;
+}
+
+Form::dbid_t Suppression::formId() const noexcept
+{
+    return data ? data->formId : 0;
+}
+
+QString Suppression::email() const noexcept
+{
+    return data ? data->email : QString();
+}
+
+QString Suppression::reason() const noexcept
+{
+    return data ? data->reason : QString();
+}
+
+QDateTime Suppression::created() const noexcept
+{
+    return data ? data->created : QDateTime();
+}
+
+bool Suppression::isValid() const noexcept
+{
+    return data && data->id > 0;
+}
+
+Suppression::dbid_t Suppression::toDbId(const QVariant &var, bool *ok)
+{
+    bool _ok      = false;
+    const auto id = var.toULongLong(&_ok);
+    if (_ok && id <= static_cast<qulonglong>(std::numeric_limits<Suppression::dbid_t>::max())) {
+        if (ok) {
+            *ok = true;
+        }
+        return static_cast<Suppression::dbid_t>(id);
+    }
+
+    if (ok) {
+        *ok = false;
+    }
+
+    return 0;
+}
+
+QString Suppression::normalize(const QString &email)
+{
+    return email.trimmed().toCaseFolded();
+}
+
+QMap<QString, QString> Suppression::labels(Cutelyst::Context *c)
+{
+    return {//: Suppression data label, used eg. in table headers
+            //% "id"
+            {u"id"_s, c->qtTrId("hbnbota_suppression_label_id")},
+            //: Suppression data label, used eg. in table headers
+            //% "email"
+            {u"email"_s, c->qtTrId("hbnbota_suppression_label_email")},
+            //: Suppression data label, used eg. in table headers
+            //% "reason"
+            {u"reason"_s, c->qtTrId("hbnbota_suppression_label_reason")},
+            //: General data label, used eg. in table headers, means the creation date and time
+            //% "created"
+            {u"created"_s, c->qtTrId("hbnbota_general_label_created")}};
+}
+
+Suppression Suppression::create(Cutelyst::Context *c, const Form &form, Error &e, const QVariantHash &values)
+{
+    const auto email  = Suppression::normalize(values.value(u"email"_s).toString());
+    const auto reason = values.value(u"reason"_s).toString();
+    const auto now    = QDateTime::currentDateTimeUtc();
+
+    if (SuppressionList::instance()->contains(form.id(), email)) {
+        //: Error message, %1 will be replaced by the email address
+        //% "The address “%1” is already suppressed for this contact form."
+        e = Error::create(
+            c, Cutelyst::Response::BadRequest, c->qtTrId("hbnbota_error_suppression_create_exists").arg(email));
+        return {};
+    }
+
+    QSqlQuery q = CPreparedSqlQueryThread(
+        u"INSERT INTO suppressions (formId, email, reason, created) VALUES (:formId, :email, :reason, :created)"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        //: Error message
+        //% "Failed to insert new suppressed address into database."
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_suppression_failed_create_db"));
+        qCCritical(HBNBOTA_CORE) << "Failed to insert new suppression into database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":formId"_s, form.id());
+    q.bindValue(u":email"_s, email);
+    q.bindValue(u":reason"_s, reason);
+    q.bindValue(u":created"_s, now);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_suppression_failed_create_db"));
+        qCCritical(HBNBOTA_CORE) << "Failed to insert new suppression into database:" << q.lastError().text();
+        return {};
+    }
+
+    Suppression::dbid_t id = 0;
+    if (q.driver()->hasFeature(QSqlDriver::LastInsertId)) {
+        id = Suppression::toDbId(q.lastInsertId());
+    } else {
+        q = CPreparedSqlQueryThreadFO(u"SELECT id FROM suppressions WHERE formId = :formId AND email = :email"_s);
+        q.bindValue(u":formId"_s, form.id());
+        q.bindValue(u":email"_s, email);
+        q.exec();
+        q.next();
+        id = Suppression::toDbId(q.value(0));
+    }
+
+    // effective at once in this process, others pick it up on their next refresh
+    SuppressionList::instance()->insert(form.id(), email);
+
+    Suppression s{id, form.id(), email, reason, now};
+
+    qCInfo(HBNBOTA_CORE) << User::fromStash(c) << "created new" << s;
+
+    return s;
+}
+
+QList<Suppression> Suppression::list(Cutelyst::Context *c, const Form &form, Error &e)
+{
+    QSqlQuery q = CPreparedSqlQueryThreadFO(
+        u"SELECT id, email, reason, created FROM suppressions WHERE formId = :formId ORDER BY email"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        //: Error message, %1 will be replaced by the form name, %2 by the form db id
+        //% "Failed to query suppressed addresses for form “%1” (ID: %2) from the database."
+        e = Error::create(
+            c, q, c->qtTrId("hbnbota_error_suppression_failed_list_db").arg(form.name(), QString::number(form.id())));
+        qCCritical(HBNBOTA_CORE) << "Failed to query suppressions for" << form << "from database:" << q.lastError().text();
+        return {};
+    }
+
+    q.bindValue(u":formId"_s, form.id());
+
+    if (Q_UNLIKELY(!q.exec())) {
+        e = Error::create(
+            c, q, c->qtTrId("hbnbota_error_suppression_failed_list_db").arg(form.name(), QString::number(form.id())));
+        qCCritical(HBNBOTA_CORE) << "Failed to query suppressions for" << form << "from database:" << q.lastError().text();
+        return {};
+    }
+
+    QList<Suppression> lst;
+    if (q.size() > 0) {
+        lst.reserve(q.size());
+    }
+
+    while (q.next()) {
+        lst.emplace_back(Suppression::toDbId(q.value(0)),
+                         form.id(),
+                         q.value(1).toString(),
+                         q.value(2).toString(),
+                         q.value(3).toDateTime());
+    }
+
+    return lst;
+}
+
+bool Suppression::remove(Cutelyst::Context *c, const Form &form, Error &e, Suppression::dbid_t id)
+{
+    QSqlQuery q = CPreparedSqlQueryThreadFO(u"SELECT email FROM suppressions WHERE id = :id AND formId = :formId"_s);
+    if (Q_UNLIKELY(q.lastError().isValid())) {
+        //: Error message, %1 will be replaced by the suppression db id
+        //% "Failed to remove suppressed address with ID %1 from the database."
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_suppression_failed_remove_db").arg(id));
+        qCCritical(HBNBOTA_CORE) << "Failed to query suppression" << id << "from database:" << q.lastError().text();
+        return false;
+    }
+
+    q.bindValue(u":id"_s, id);
+    q.bindValue(u":formId"_s, form.id());
+
+    if (Q_UNLIKELY(!q.exec())) {
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_suppression_failed_remove_db").arg(id));
+        qCCritical(HBNBOTA_CORE) << "Failed to query suppression" << id << "from database:" << q.lastError().text();
+        return false;
+    }
+
+    if (Q_UNLIKELY(!q.next())) {
+        //: Error message, %1 will be replaced by the suppression db id
+        //% "Can not find suppressed address with ID %1 in the database."
+        e = Error::create(
+            c, Cutelyst::Response::NotFound, c->qtTrId("hbnbota_error_suppression_remove_not_found").arg(id));
+        return false;
+    }
+
+    const QString email = q.value(0).toString();
+
+    q = CPreparedSqlQueryThreadFO(u"DELETE FROM suppressions WHERE id = :id"_s);
+    q.bindValue(u":id"_s, id);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        e = Error::create(c, q, c->qtTrId("hbnbota_error_suppression_failed_remove_db").arg(id));
+        qCCritical(HBNBOTA_CORE) << "Failed to delete suppression" << id << "from database:" << q.lastError().text();
+        return false;
+    }
+
+    SuppressionList::instance()->remove(form.id(), email);
+
+    qCInfo(HBNBOTA_CORE) << User::fromStash(c) << "removed suppression of" << email << "for" << form;
+
+    return true;
+}
+
+bool Suppression::add(Form::dbid_t formId, const QString &email, const QString &reason)
+{
+    const auto normalized = Suppression::normalize(email);
+
+    // there is no portable insert-or-ignore, so check first
+    QSqlQuery q = CPreparedSqlQueryThreadFO(u"SELECT id FROM suppressions WHERE formId = :formId AND email = :email"_s);
+    q.bindValue(u":formId"_s, formId);
+    q.bindValue(u":email"_s, normalized);
+
+    if (Q_UNLIKELY(!q.exec())) {
+        qCCritical(HBNBOTA_DELIVERY) << "Failed to query suppression of" << normalized << "from database:"
+                                     << q.lastError().text();
+        return false;
+    }
+
+    if (!q.next()) {
+        q = CPreparedSqlQueryThreadFO(
+            u"INSERT INTO suppressions (formId, email, reason, created) VALUES (:formId, :email, :reason, :created)"_s);
+        q.bindValue(u":formId"_s, formId);
+        q.bindValue(u":email"_s, normalized);
+        q.bindValue(u":reason"_s, reason);
+        q.bindValue(u":created"_s, QDateTime::currentDateTimeUtc());
+
+        if (Q_UNLIKELY(!q.exec())) {
+            qCCritical(HBNBOTA_DELIVERY) << "Failed to insert suppression of" << normalized << "into database:"
+                                         << q.lastError().text();
+            return false;
+        }
+    }
+
+    SuppressionList::instance()->insert(formId, normalized);
+
+    return true;
+}
+
+QDebug operator<<(QDebug dbg, const Suppression &suppression)
+{
+    QDebugStateSaver saver(dbg);
+    dbg.nospace() << "Suppression(";
+    if (!suppression.isNull()) {
+        if (suppression.isValid()) {
+            dbg << "ID: " << suppression.id();
+            dbg << ", Form ID: " << suppression.formId();
+            dbg << ", Email: " << suppression.email();
+        } else {
+            dbg << "INVALID";
+        }
+    }
+    dbg << ')';
+    return dbg;
+}
+
+#include "moc_suppression.cpp"
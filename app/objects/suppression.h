@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_SUPPRESSION_H
+#define HBNBOTA_SUPPRESSION_H
+
+#include "form.h"
+
+#include <QDateTime>
+#include <QObject>
+#include <QSharedDataPointer>
+
+namespace Cutelyst {
+class Context;
+}
+
+/*!
+ * \brief Contains data about a suppressed receiver address of a contact form.
+ *
+ * No messages of the form are sent to suppressed addresses. Addresses are added
+ * manually or automatically when the mail server permanently rejects them. The
+ * delivery threads look them up in the SuppressionList.
+ */
+class Suppression
+{
+    Q_GADGET
+    Q_PROPERTY(Suppression::dbid_t id READ id CONSTANT)
+    Q_PROPERTY(Form::dbid_t formId READ formId CONSTANT)
+    Q_PROPERTY(QString email READ email CONSTANT)
+    Q_PROPERTY(QString reason READ reason CONSTANT)
+    Q_PROPERTY(QDateTime created READ created CONSTANT)
+public:
+    using dbid_t = quint32;
+
+    Suppression() noexcept = default;
+
+    Suppression(Suppression::dbid_t id,
+                Form::dbid_t formId,
+                const QString &email,
+                const QString &reason,
+                const QDateTime &created);
+
+    Suppression(const Suppression &other) noexcept            = default;
+    Suppression(Suppression &&other) noexcept                 = default;
+    Suppression &operator=(const Suppression &other) noexcept = default;
+    Suppression &operator=(Suppression &&other) noexcept      = default;
+    ~Suppression() noexcept                                   = default;
+
+    void swap(Suppression &other) noexcept { data.swap(other.data); }
+
+    [[nodiscard]] dbid_t id() const noexcept;
+
+    [[nodiscard]] Form::dbid_t formId() const noexcept;
+
+    [[nodiscard]] QString email() const noexcept;
+
+    [[nodiscard]] QString reason() const noexcept;
+
+    [[nodiscard]] QDateTime created() const noexcept;
+
+    [[nodiscard]] bool isValid() const noexcept;
+
+    [[nodiscard]] bool isNull() const noexcept { return !data; }
+
+    /*!
+     * \brief Returns \a var converted to dbid_t.
+     *
+     * Returns \c 0 if the conversion fails.
+     *
+     * If \a ok is not \c nullptr, failure is reported by setting \a *ok to \c false,
+     * and success by setting \a *ok to \c true.
+     */
+    static dbid_t toDbId(const QVariant &var, bool *ok = nullptr);
+
+    /*!
+     * \brief Returns \a email in the form used for storing and comparing addresses.
+     */
+    [[nodiscard]] static QString normalize(const QString &email);
+
+    static QMap<QString, QString> labels(Cutelyst::Context *c);
+
+    static Suppression create(Cutelyst::Context *c, const Form &form, Error &e, const QVariantHash &values);
+
+    static QList<Suppression> list(Cutelyst::Context *c, const Form &form, Error &e);
+
+    /*!
+     * \brief Removes the suppression with \a id from \a form and returns \c true on success.
+     */
+    static bool remove(Cutelyst::Context *c, const Form &form, Error &e, Suppression::dbid_t id);
+
+    /*!
+     * \brief Suppresses \a email for the form with \a formId without a request context.
+     *
+     * This is used by background threads that deliver messages. Returns \c true if the
+     * address has been added or if it is already suppressed.
+     */
+    static bool add(Form::dbid_t formId, const QString &email, const QString &reason);
+
+private:
+    class Data : public QSharedData // NOLINT(cppcoreguidelines-special-member-functions)
+    {
+    public:
+        Data() noexcept = default;
+        Data(Suppression::dbid_t _id, Form::dbid_t _formId, QString _email, QString _reason, QDateTime _created);
+
+        Data(const Data &) noexcept   = default;
+        Data &operator=(const Data &) = delete;
+        ~Data() noexcept              = default;
+
+        QString email;
+        QString reason;
+        QDateTime created;
+        Suppression::dbid_t id{0};
+        Form::dbid_t formId{0};
+    };
+
+    QSharedDataPointer<Data> data;
+};
+
+Q_DECLARE_SHARED(Suppression) // NOLINT(modernize-type-traits)
+Q_DECLARE_METATYPE(Suppression)
+
+/*!
+ * \related Suppression
+ * \brief Writes the \a suppression to the debug stream \a dbg and returns a refererence to the stream.
+ */
+QDebug operator<<(QDebug dbg, const Suppression &suppression);
+
+#endif // HBNBOTA_SUPPRESSION_H
@@ -0,0 +1,303 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "tokenpool.h"
+
+#include "form.h"
+#include "logging.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QGlobalStatic>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimeZone>
+#include <QWaitCondition>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// added to the time of pooled tokens, they are dropped after it has been passed
+constexpr qint64 lifetimeMSecs{1'000};
+// rings that have not been used for this time are removed
+constexpr qint64 idleMSecs{60'000};
+// the background thread is woken up by take() if a ring runs low, this is only the fallback
+constexpr std::chrono::milliseconds refillInterval{500};
+
+/*!
+ * \internal
+ * \brief Ring of pre-created tokens for one form, filled by the background thread and emptied by one worker thread.
+ *
+ * Only the worker thread can drop tokens from a queue, so a queue full of expired tokens would block the
+ * background thread while the worker thread is idle. The ring therefore has two queues. The background
+ * thread fills the active one, and before its tokens expire, it refills the other one and makes that
+ * active. A queue is only refilled if the worker thread does not use it, the worker thread announces
+ * the queue it pops from in m_inUse.
+ */
+class Ring
+{
+public:
+    Ring(const Form &f, qsizetype capacity, qint64 now)
+        : form{f}
+        , lastTake{now}
+        , m_queues{Queue{static_cast<size_t>(capacity)}, Queue{static_cast<size_t>(capacity)}}
+    {
+    }
+
+    // background thread only, tops up the active queue or replaces it if its tokens expire soon
+    void refill(qint64 now)
+    {
+        const int active = m_active.load(std::memory_order_relaxed);
+        Queue &q         = m_queues[active];
+
+        if (q.validUntil - now < lifetimeMSecs / 2) {
+            const int other = 1 - active;
+            if (m_inUse.load(std::memory_order_seq_cst) != other) {
+                Queue &o = m_queues[other];
+                o.head.store(0, std::memory_order_relaxed);
+                o.tail.store(0, std::memory_order_relaxed);
+                if (fill(o, now)) {
+                    m_active.store(other, std::memory_order_seq_cst);
+                }
+                return;
+            }
+        }
+
+        fill(q, now);
+    }
+
+    // owning worker thread only
+    [[nodiscard]] bool isLow() const noexcept
+    {
+        const Queue &q = m_queues[m_active.load(std::memory_order_acquire)];
+        return (q.tail.load(std::memory_order_acquire) - q.head.load(std::memory_order_relaxed)) * 2 < q.slots.size();
+    }
+
+    // owning worker thread only, drops expired tokens
+    [[nodiscard]] QByteArray pop(qint64 now)
+    {
+        int active = m_active.load(std::memory_order_seq_cst);
+        for (;;) {
+            m_inUse.store(active, std::memory_order_seq_cst);
+            const int current = m_active.load(std::memory_order_seq_cst);
+            if (current == active) {
+                break;
+            }
+            active = current;
+        }
+
+        Queue &q          = m_queues[active];
+        size_t head       = q.head.load(std::memory_order_relaxed);
+        const size_t tail = q.tail.load(std::memory_order_acquire);
+
+        QByteArray token;
+        while (head != tail) {
+            Slot &slot = q.slots[head % q.slots.size()];
+            ++head;
+            if (slot.validUntil > now) {
+                token = std::move(slot.token);
+                break;
+            }
+        }
+
+        q.head.store(head, std::memory_order_release);
+        m_inUse.store(-1, std::memory_order_seq_cst);
+
+        return token;
+    }
+
+    const Form form;
+    std::atomic<qint64> lastTake;
+    std::atomic<bool> retired{false};
+
+private:
+    struct Slot {
+        QByteArray token;
+        qint64 validUntil{0};
+    };
+
+    struct Queue {
+        explicit Queue(size_t capacity)
+            : slots(capacity)
+        {
+        }
+
+        std::vector<Slot> slots;
+        // next slot to pop, written by the worker thread, or by the background thread while the queue is not in use
+        std::atomic<size_t> head{0};
+        // next slot to push, written by the background thread
+        std::atomic<size_t> tail{0};
+        // expiration of the newest token, background thread only
+        qint64 validUntil{0};
+    };
+
+    // background thread only, returns false if a token could not be created
+    bool fill(Queue &q, qint64 now)
+    {
+        // all tokens of one pass share the same time
+        const qint64 validUntil = now + lifetimeMSecs;
+        const QDateTime time    = QDateTime::fromMSecsSinceEpoch(validUntil, QTimeZone::utc());
+
+        size_t tail = q.tail.load(std::memory_order_relaxed);
+        while (!retired && tail - q.head.load(std::memory_order_acquire) < q.slots.size()) {
+            QByteArray token = form.encrypt(time);
+            if (Q_UNLIKELY(token.isEmpty())) {
+                retired = true;
+                return false;
+            }
+            Slot &slot      = q.slots[tail % q.slots.size()];
+            slot.token      = std::move(token);
+            slot.validUntil = validUntil;
+            q.validUntil    = validUntil;
+            q.tail.store(++tail, std::memory_order_release);
+        }
+
+        return !retired;
+    }
+
+    std::array<Queue, 2> m_queues;
+    // queue the background thread fills and the worker thread pops from
+    std::atomic<int> m_active{0};
+    // queue the worker thread currently pops from, -1 if none
+    std::atomic<int> m_inUse{-1};
+};
+
+struct PoolVals {
+    QMutex mutex;
+    QWaitCondition wakeup;
+    QThread *thread{nullptr};
+    QList<std::shared_ptr<Ring>> rings;
+    std::atomic<int> size{0};
+    bool stopping{false};
+};
+
+Q_GLOBAL_STATIC(PoolVals, pool) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// rings of the current worker thread by form UUID
+thread_local QHash<QString, std::shared_ptr<Ring>> localRings;
+
+void refill()
+{
+    QMutexLocker locker(&pool->mutex);
+
+    while (!pool->stopping) {
+        const QList<std::shared_ptr<Ring>> rings = pool->rings;
+        locker.unlock();
+
+        for (const auto &ring : rings) {
+            const qint64 now = QDateTime::currentMSecsSinceEpoch();
+            if (now - ring->lastTake.load(std::memory_order_relaxed) > idleMSecs) {
+                ring->retired = true;
+                continue;
+            }
+
+            ring->refill(now);
+        }
+
+        locker.relock();
+
+        pool->rings.removeIf([](const std::shared_ptr<Ring> &ring) { return ring->retired.load(); });
+
+        if (!pool->stopping) {
+            pool->wakeup.wait(&pool->mutex, QDeadlineTimer{refillInterval});
+        }
+    }
+}
+} // namespace
+
+void TokenPool::start(int size)
+{
+    QMutexLocker locker(&pool->mutex);
+
+    if (pool->thread || size <= 0) {
+        return;
+    }
+
+    qCDebug(HBNBOTA_CORE) << "Starting token pool with" << size << "tokens per form and thread";
+
+    pool->size     = size;
+    pool->stopping = false;
+    pool->thread   = QThread::create(refill);
+    pool->thread->setObjectName(u"tokenpool"_s);
+
+    if (auto app = QCoreApplication::instance(); app) {
+        QObject::connect(app, &QCoreApplication::aboutToQuit, app, &TokenPool::stop, Qt::DirectConnection);
+    }
+
+    pool->thread->start(QThread::LowPriority);
+}
+
+void TokenPool::stop()
+{
+    QThread *thread = nullptr;
+
+    {
+        QMutexLocker locker(&pool->mutex);
+
+        if (!pool->thread) {
+            return;
+        }
+
+        qCDebug(HBNBOTA_CORE) << "Stopping token pool";
+
+        pool->size     = 0;
+        pool->stopping = true;
+        for (const auto &ring : std::as_const(pool->rings)) {
+            ring->retired = true;
+        }
+        pool->rings.clear();
+        pool->wakeup.wakeAll();
+        thread = std::exchange(pool->thread, nullptr);
+    }
+
+    thread->wait();
+    delete thread; // NOLINT(cppcoreguidelines-owning-memory)
+}
+
+QByteArray TokenPool::take(const Form &form)
+{
+    const int size = pool->size.load(std::memory_order_relaxed);
+    if (size == 0 || form.isNull()) {
+        return {};
+    }
+
+    const qint64 now            = QDateTime::currentMSecsSinceEpoch();
+    std::shared_ptr<Ring> &ring = localRings[form.uuid()];
+
+    if (!ring || ring->retired.load() || ring->form.updated() != form.updated()) {
+        if (ring) {
+            ring->retired = true;
+        }
+        ring = std::make_shared<Ring>(form, size, now);
+
+        QMutexLocker locker(&pool->mutex);
+        if (Q_LIKELY(!pool->stopping)) {
+            pool->rings << ring;
+            pool->wakeup.wakeOne();
+        }
+        return {};
+    }
+
+    ring->lastTake.store(now, std::memory_order_relaxed);
+
+    QByteArray token = ring->pop(now);
+    if (ring->isLow()) {
+        // a lost wake up only delays the refill until the next interval
+        pool->wakeup.wakeOne();
+    }
+
+    return token;
+}
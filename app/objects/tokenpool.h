@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_TOKENPOOL_H
+#define HBNBOTA_TOKENPOOL_H
+
+#include <QByteArray>
+
+class Form;
+
+/*!
+ * \brief Keeps pre-created contact form tokens per form and worker thread.
+ *
+ * When a popular page is loaded, many visitors request a token at nearly the same time.
+ * A background thread with low priority fills a fixed-size ring for every form that has
+ * recently been requested by a worker thread. Every ring has exactly one producer, the
+ * background thread, and one consumer, the worker thread, so take() pops a token
+ * without locking and without any crypto. Every token is handed out at most once.
+ *
+ * Pooled tokens carry a time that is up to one second in the future and are dropped
+ * once that time has been passed. The time in a token from the pool is therefore never
+ * earlier than the time it has been handed out, so FormToken::minAge is not weakened.
+ * Tokens are replaced by fresh ones before they expire, so that a ring still has valid
+ * tokens after the worker thread has been idle. Rings that have not been used for a
+ * minute are removed.
+ */
+namespace TokenPool {
+
+/*!
+ * \brief Starts the background thread that fills the pools with \a size tokens per form and worker thread.
+ *
+ * A \a size of \c 0 disables the pool. Calling this more than once per process has no effect.
+ */
+void start(int size);
+
+/*!
+ * \brief Stops the background thread and waits for it to finish.
+ */
+void stop();
+
+/*!
+ * \brief Returns a pre-created token for \a form, or an empty byte array if there is none.
+ *
+ * The first call for a form in a worker thread, and the first call after the form has
+ * been updated, registers the form with the background thread and returns an empty
+ * byte array. The caller has to create the token on its own then.
+ */
+[[nodiscard]] QByteArray take(const Form &form);
+
+} // namespace TokenPool
+
+#endif // HBNBOTA_TOKENPOOL_H
@@ -6,6 +6,7 @@
 #include "user.h"
 
 #include "error.h"
+#include "localcache.h"
 #include "logging.h"
 #include "settings.h"
 
@@ -15,6 +16,7 @@
 #include <CutelystBotan/credentialbotan.h>
 
 #include <QDebug>
+#include <QGlobalStatic>
 #include <QJsonDocument>
 #include <QMetaEnum>
 #include <QMetaObject>
@@ -86,6 +88,15 @@ public:
     User::Type type{User::Invalid};
 };
 
+namespace {
+struct LocalUsers {
+    LocalCache<User::dbid_t, User> cache{
+        Settings::localCacheEntries(), Settings::localCacheMemory(), Settings::localCacheTtl()};
+};
+
+Q_GLOBAL_STATIC(LocalUsers, localUsers) // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+} // namespace
+
 void UserData::setUrls(Cutelyst::Context *c)
 {
     User current = User::fromStash(c);
@@ -676,13 +687,17 @@ void User::updateLastSeen(Cutelyst::Context *c)
 
 User User::fromCache(User::dbid_t id)
 {
-    User u;
+    User u = localUsers->cache.object(id);
+    if (!u.isNull()) {
+        return u;
+    }
 
     if (Settings::cache() == Settings::Cache::Memcached) {
         Cutelyst::Memcached::ReturnType rt{Cutelyst::Memcached::ReturnType::Failure};
         u = Cutelyst::Memcached::getByKey<User>(HBNBOTA_USER_MEMC_GROUP_KEY, QByteArray::number(id), nullptr, &rt);
         if (rt == Cutelyst::Memcached::ReturnType::Success) {
             qCDebug(HBNBOTA_CORE) << "Found user with ID" << id << "in memcached";
+            localUsers->cache.insert(id, u, localCacheCost(u));
         }
     }
 
@@ -691,6 +706,10 @@ User User::fromCache(User::dbid_t id)
 
 void User::toCache() const
 {
+    if (localUsers->cache.isEnabled()) {
+        localUsers->cache.insert(id(), *this, localCacheCost(*this));
+    }
+
     if (Settings::cache() == Settings::Cache::Memcached) {
         Cutelyst::Memcached::setByKey<User>(
             HBNBOTA_USER_MEMC_GROUP_KEY, QByteArray::number(id()), *this, std::chrono::days{7});
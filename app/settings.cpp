@@ -10,6 +10,8 @@
 
 #include <Cutelyst/Context>
 
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QGlobalStatic>
@@ -48,6 +50,24 @@ struct SettingVals {
     Settings::Cache cache{Settings::Cache::None};
     Settings::SessionStore sessionStore{Settings::SessionStore::File};
 
+    int deliveryWorkers{HBNBOTA_CONF_CORE_DELIVERYWORKERS_DEFVAL};
+    int smtpPoolSize{HBNBOTA_CONF_CORE_SMTPPOOLSIZE_DEFVAL};
+    std::chrono::seconds smtpIdleTimeout{HBNBOTA_CONF_CORE_SMTPIDLETIMEOUT_DEFVAL};
+    int deliveryQueueSize{HBNBOTA_CONF_CORE_DELIVERYQUEUESIZE_DEFVAL};
+    int deliveryHighWaterMark{HBNBOTA_CONF_CORE_DELIVERYHIGHWATERMARK_DEFVAL};
+    std::chrono::milliseconds submitMaxLatency{HBNBOTA_CONF_CORE_SUBMITMAXLATENCY_DEFVAL};
+    std::chrono::seconds submitRetryAfter{HBNBOTA_CONF_CORE_SUBMITRETRYAFTER_DEFVAL};
+    QString sendmailPath{QStringLiteral(HBNBOTA_CONF_CORE_SENDMAILPATH_DEFVAL)};
+    QString maildirPath{QStringLiteral(HBNBOTA_CONF_CORE_MAILDIRPATH_DEFVAL)};
+    FormToken::Algorithm tokenAlgorithm{FormToken::Algorithm::Default};
+    QByteArray tokenSecret{HBNBOTA_CONF_CORE_TOKENSECRET_DEFVAL};
+    QDateTime legacyTokensUntil;
+    int tokenPoolSize{HBNBOTA_CONF_CORE_TOKENPOOLSIZE_DEFVAL};
+    int replayCacheSize{HBNBOTA_CONF_CORE_REPLAYCACHESIZE_DEFVAL};
+    int localCacheEntries{HBNBOTA_CONF_CORE_LOCALCACHEENTRIES_DEFVAL};
+    qint64 localCacheMemory{qint64{HBNBOTA_CONF_CORE_LOCALCACHEMEMORY_DEFVAL} * 1024};
+    std::chrono::seconds localCacheTtl{HBNBOTA_CONF_CORE_LOCALCACHETTL_DEFVAL};
+
     bool loaded{false};
     bool localesLoaded{false};
 };
@@ -147,6 +167,187 @@ bool loadCore(const QVariantMap &core)
                                     << HBNBOTA_CONF_CORE << ", using default:" << HBNBOTA_CONF_CORE_SESSIONSTORE_DEFVAL;
     }
 
+    bool ok                    = false;
+    const int _deliveryWorkers = core.value(QStringLiteral(HBNBOTA_CONF_CORE_DELIVERYWORKERS),
+                                            HBNBOTA_CONF_CORE_DELIVERYWORKERS_DEFVAL)
+                                     .toInt(&ok);
+    if (ok && _deliveryWorkers > 0) {
+        cfg->deliveryWorkers = _deliveryWorkers;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_DELIVERYWORKERS << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_DELIVERYWORKERS_DEFVAL;
+    }
+
+    const int _smtpPoolSize =
+        core.value(QStringLiteral(HBNBOTA_CONF_CORE_SMTPPOOLSIZE), HBNBOTA_CONF_CORE_SMTPPOOLSIZE_DEFVAL).toInt(&ok);
+    if (ok && _smtpPoolSize >= 0) {
+        cfg->smtpPoolSize = _smtpPoolSize;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_SMTPPOOLSIZE << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_SMTPPOOLSIZE_DEFVAL;
+    }
+
+    const int _smtpIdleTimeout =
+        core.value(QStringLiteral(HBNBOTA_CONF_CORE_SMTPIDLETIMEOUT), HBNBOTA_CONF_CORE_SMTPIDLETIMEOUT_DEFVAL).toInt(&ok);
+    if (ok && _smtpIdleTimeout > 0) {
+        cfg->smtpIdleTimeout = std::chrono::seconds{_smtpIdleTimeout};
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_SMTPIDLETIMEOUT << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_SMTPIDLETIMEOUT_DEFVAL;
+    }
+
+    const int _deliveryQueueSize = core.value(QStringLiteral(HBNBOTA_CONF_CORE_DELIVERYQUEUESIZE),
+                                              HBNBOTA_CONF_CORE_DELIVERYQUEUESIZE_DEFVAL)
+                                        .toInt(&ok);
+    if (ok && _deliveryQueueSize > 0) {
+        cfg->deliveryQueueSize = _deliveryQueueSize;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_DELIVERYQUEUESIZE << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_DELIVERYQUEUESIZE_DEFVAL;
+    }
+
+    const int _deliveryHighWaterMark = core.value(QStringLiteral(HBNBOTA_CONF_CORE_DELIVERYHIGHWATERMARK),
+                                                  HBNBOTA_CONF_CORE_DELIVERYHIGHWATERMARK_DEFVAL)
+                                            .toInt(&ok);
+    if (ok && _deliveryHighWaterMark > 0) {
+        cfg->deliveryHighWaterMark = _deliveryHighWaterMark;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_DELIVERYHIGHWATERMARK << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_DELIVERYHIGHWATERMARK_DEFVAL;
+    }
+
+    const int _submitMaxLatency =
+        core.value(QStringLiteral(HBNBOTA_CONF_CORE_SUBMITMAXLATENCY), HBNBOTA_CONF_CORE_SUBMITMAXLATENCY_DEFVAL).toInt(&ok);
+    if (ok && _submitMaxLatency > 0) {
+        cfg->submitMaxLatency = std::chrono::milliseconds{_submitMaxLatency};
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_SUBMITMAXLATENCY << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_SUBMITMAXLATENCY_DEFVAL;
+    }
+
+    const int _submitRetryAfter =
+        core.value(QStringLiteral(HBNBOTA_CONF_CORE_SUBMITRETRYAFTER), HBNBOTA_CONF_CORE_SUBMITRETRYAFTER_DEFVAL).toInt(&ok);
+    if (ok && _submitRetryAfter > 0) {
+        cfg->submitRetryAfter = std::chrono::seconds{_submitRetryAfter};
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_SUBMITRETRYAFTER << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_SUBMITRETRYAFTER_DEFVAL;
+    }
+
+    const QString _sendmailPath = core.value(QStringLiteral(HBNBOTA_CONF_CORE_SENDMAILPATH),
+                                             QStringLiteral(HBNBOTA_CONF_CORE_SENDMAILPATH_DEFVAL))
+                                      .toString()
+                                      .trimmed();
+    if (_sendmailPath.isEmpty() || (QDir::isAbsolutePath(_sendmailPath) && QFileInfo{_sendmailPath}.isExecutable())) {
+        cfg->sendmailPath = _sendmailPath;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_SENDMAILPATH << "in section"
+                                    << HBNBOTA_CONF_CORE << ", has to be the absolute path to an executable file";
+    }
+
+    const QString _maildirPath = core.value(QStringLiteral(HBNBOTA_CONF_CORE_MAILDIRPATH),
+                                            QStringLiteral(HBNBOTA_CONF_CORE_MAILDIRPATH_DEFVAL))
+                                     .toString()
+                                     .trimmed();
+    if (_maildirPath.isEmpty() || QDir::isAbsolutePath(_maildirPath)) {
+        cfg->maildirPath = _maildirPath;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_MAILDIRPATH << "in section"
+                                    << HBNBOTA_CONF_CORE << ", has to be an absolute path";
+    }
+
+    const auto _tokenAlgorithm = FormToken::fromName(core.value(QStringLiteral(HBNBOTA_CONF_CORE_TOKENALGORITHM),
+                                                                QStringLiteral(HBNBOTA_CONF_CORE_TOKENALGORITHM_DEFVAL))
+                                                         .toString()
+                                                         .trimmed(),
+                                                     &ok);
+    if (ok) {
+        cfg->tokenAlgorithm = _tokenAlgorithm;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_TOKENALGORITHM << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_TOKENALGORITHM_DEFVAL;
+    }
+
+    cfg->tokenSecret = core.value(QStringLiteral(HBNBOTA_CONF_CORE_TOKENSECRET),
+                                  QStringLiteral(HBNBOTA_CONF_CORE_TOKENSECRET_DEFVAL))
+                           .toString()
+                           .trimmed()
+                           .toUtf8();
+
+    const QString _legacyTokensUntil = core.value(QStringLiteral(HBNBOTA_CONF_CORE_LEGACYTOKENSUNTIL),
+                                                  QStringLiteral(HBNBOTA_CONF_CORE_LEGACYTOKENSUNTIL_DEFVAL))
+                                           .toString()
+                                           .trimmed();
+    if (!_legacyTokensUntil.isEmpty()) {
+        const QDateTime legacyTokensUntil = QDateTime::fromString(_legacyTokensUntil, Qt::ISODate);
+        if (legacyTokensUntil.isValid()) {
+            cfg->legacyTokensUntil = legacyTokensUntil.toUTC();
+        } else {
+            qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_LEGACYTOKENSUNTIL << "in section"
+                                        << HBNBOTA_CONF_CORE << ", legacy contact form tokens will be rejected";
+        }
+    }
+
+    const int _tokenPoolSize =
+        core.value(QStringLiteral(HBNBOTA_CONF_CORE_TOKENPOOLSIZE), HBNBOTA_CONF_CORE_TOKENPOOLSIZE_DEFVAL).toInt(&ok);
+    if (ok && _tokenPoolSize >= 0) {
+        cfg->tokenPoolSize = _tokenPoolSize;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_TOKENPOOLSIZE << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_TOKENPOOLSIZE_DEFVAL;
+    }
+
+    const int _replayCacheSize =
+        core.value(QStringLiteral(HBNBOTA_CONF_CORE_REPLAYCACHESIZE), HBNBOTA_CONF_CORE_REPLAYCACHESIZE_DEFVAL).toInt(&ok);
+    if (ok && _replayCacheSize >= 0) {
+        cfg->replayCacheSize = _replayCacheSize;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_REPLAYCACHESIZE << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_REPLAYCACHESIZE_DEFVAL;
+    }
+
+    const int _localCacheEntries = core.value(QStringLiteral(HBNBOTA_CONF_CORE_LOCALCACHEENTRIES),
+                                              HBNBOTA_CONF_CORE_LOCALCACHEENTRIES_DEFVAL)
+                                       .toInt(&ok);
+    if (ok && _localCacheEntries >= 0) {
+        cfg->localCacheEntries = _localCacheEntries;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_LOCALCACHEENTRIES << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_LOCALCACHEENTRIES_DEFVAL;
+    }
+
+    const int _localCacheMemory = core.value(QStringLiteral(HBNBOTA_CONF_CORE_LOCALCACHEMEMORY),
+                                             HBNBOTA_CONF_CORE_LOCALCACHEMEMORY_DEFVAL)
+                                      .toInt(&ok);
+    if (ok && _localCacheMemory >= 0) {
+        cfg->localCacheMemory = qint64{_localCacheMemory} * 1024;
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_LOCALCACHEMEMORY << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_LOCALCACHEMEMORY_DEFVAL;
+    }
+
+    const int _localCacheTtl =
+        core.value(QStringLiteral(HBNBOTA_CONF_CORE_LOCALCACHETTL), HBNBOTA_CONF_CORE_LOCALCACHETTL_DEFVAL).toInt(&ok);
+    if (ok && _localCacheTtl >= 0) {
+        cfg->localCacheTtl = std::chrono::seconds{_localCacheTtl};
+    } else {
+        qCWarning(HBNBOTA_SETTINGS) << "Invalid value for" << HBNBOTA_CONF_CORE_LOCALCACHETTL << "in section"
+                                    << HBNBOTA_CONF_CORE
+                                    << ", using default value:" << HBNBOTA_CONF_CORE_LOCALCACHETTL_DEFVAL;
+    }
+
     return true;
 }
 
@@ -287,6 +488,108 @@ Settings::SessionStore Settings::sessionStore()
     return cfg->sessionStore;
 }
 
+int Settings::deliveryWorkers()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->deliveryWorkers;
+}
+
+int Settings::smtpPoolSize()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->smtpPoolSize;
+}
+
+std::chrono::seconds Settings::smtpIdleTimeout()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->smtpIdleTimeout;
+}
+
+int Settings::deliveryQueueSize()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->deliveryQueueSize;
+}
+
+int Settings::deliveryHighWaterMark()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->deliveryHighWaterMark;
+}
+
+std::chrono::milliseconds Settings::submitMaxLatency()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->submitMaxLatency;
+}
+
+std::chrono::seconds Settings::submitRetryAfter()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->submitRetryAfter;
+}
+
+QString Settings::sendmailPath()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->sendmailPath;
+}
+
+QString Settings::maildirPath()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->maildirPath;
+}
+
+FormToken::Algorithm Settings::tokenAlgorithm()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->tokenAlgorithm;
+}
+
+QByteArray Settings::tokenSecret()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->tokenSecret;
+}
+
+QDateTime Settings::legacyTokensUntil()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->legacyTokensUntil;
+}
+
+int Settings::tokenPoolSize()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->tokenPoolSize;
+}
+
+int Settings::replayCacheSize()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->replayCacheSize;
+}
+
+int Settings::localCacheEntries()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->localCacheEntries;
+}
+
+qint64 Settings::localCacheMemory()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->localCacheMemory;
+}
+
+std::chrono::seconds Settings::localCacheTtl()
+{
+    QReadLocker locker(&cfg->lock);
+    return cfg->localCacheTtl;
+}
+
 QLocale Settings::defLocale()
 {
     QReadLocker locker(&cfg->lock);
@@ -400,9 +703,10 @@ QStringList Settings::allowedSmtpEncryption()
 QList<CutelystForms::Option *> Settings::supportedSenderTypes(Cutelyst::Context *c, const QString &selected)
 {
     QList<CutelystForms::Option *> lst;
-    lst.reserve(1);
     Q_UNUSED(c)
-    for (const QString &t : {u"SMTP"_s}) {
+    const QStringList types = Settings::allowedSenderTypes();
+    lst.reserve(types.size());
+    for (const QString &t : types) {
         lst << new CutelystForms::Option(t, t == selected);
     }
     return lst;
@@ -410,5 +714,100 @@ QList<CutelystForms::Option *> Settings::supportedSenderTypes(Cutelyst::Context
 
 QStringList Settings::allowedSenderTypes()
 {
-    return {u"SMTP"_s};
+    QStringList types{u"SMTP"_s, u"Webhook"_s};
+    if (!Settings::sendmailPath().isEmpty()) {
+        types << u"Sendmail"_s;
+    }
+    if (!Settings::maildirPath().isEmpty()) {
+        types << u"Maildir"_s;
+    }
+    return types;
+}
+
+QList<CutelystForms::Option *> Settings::supportedRoutingFields(Cutelyst::Context *c, const QString &selected)
+{
+    QList<CutelystForms::Option *> lst;
+    lst.reserve(7);
+    //: Recipient routing field option name, the recipient gets all submissions
+    //% "All submissions"
+    lst << new CutelystForms::Option(c->qtTrId("hbnbota_routing_field_none"), QString(), selected.isEmpty());
+    //: Recipient routing field option name
+    //% "Sender name"
+    lst << new CutelystForms::Option(
+        c->qtTrId("hbnbota_routing_field_sendername"), u"sender-name"_s, selected == "sender-name"_L1);
+    //: Recipient routing field option name
+    //% "Sender email"
+    lst << new CutelystForms::Option(
+        c->qtTrId("hbnbota_routing_field_senderemail"), u"sender-email"_s, selected == "sender-email"_L1);
+    //: Recipient routing field option name
+    //% "Sender phone"
+    lst << new CutelystForms::Option(
+        c->qtTrId("hbnbota_routing_field_senderphone"), u"sender-phone"_s, selected == "sender-phone"_L1);
+    //: Recipient routing field option name
+    //% "Sender website"
+    lst << new CutelystForms::Option(
+        c->qtTrId("hbnbota_routing_field_senderurl"), u"sender-url"_s, selected == "sender-url"_L1);
+    //: Recipient routing field option name
+    //% "Subject"
+    lst << new CutelystForms::Option(c->qtTrId("hbnbota_routing_field_subject"), u"subject"_s, selected == "subject"_L1);
+    //: Recipient routing field option name
+    //% "Message"
+    lst << new CutelystForms::Option(c->qtTrId("hbnbota_routing_field_content"), u"content"_s, selected == "content"_L1);
+    return lst;
+}
+
+QStringList Settings::allowedRoutingFields()
+{
+    return {u"sender-name"_s, u"sender-email"_s, u"sender-phone"_s, u"sender-url"_s, u"subject"_s, u"content"_s};
+}
+
+QList<CutelystForms::Option *> Settings::supportedRoutingOperators(Cutelyst::Context *c, const QString &selected)
+{
+    QList<CutelystForms::Option *> lst;
+    lst.reserve(4);
+    //: Recipient routing operator option name
+    //% "contains"
+    lst << new CutelystForms::Option(c->qtTrId("hbnbota_routing_op_contains"), u"contains"_s, selected == "contains"_L1);
+    //: Recipient routing operator option name
+    //% "equals"
+    lst << new CutelystForms::Option(c->qtTrId("hbnbota_routing_op_equals"), u"equals"_s, selected == "equals"_L1);
+    //: Recipient routing operator option name
+    //% "starts with"
+    lst << new CutelystForms::Option(
+        c->qtTrId("hbnbota_routing_op_startswith"), u"startsWith"_s, selected == "startsWith"_L1);
+    //: Recipient routing operator option name
+    //% "ends with"
+    lst << new CutelystForms::Option(c->qtTrId("hbnbota_routing_op_endswith"), u"endsWith"_s, selected == "endsWith"_L1);
+    return lst;
+}
+
+QStringList Settings::allowedRoutingOperators()
+{
+    return {u"contains"_s, u"equals"_s, u"startsWith"_s, u"endsWith"_s};
+}
+
+QList<CutelystForms::Option *> Settings::supportedTokenAlgorithms(Cutelyst::Context *c, const QString &selected)
+{
+    QList<CutelystForms::Option *> lst;
+    lst.reserve(4);
+    //: Token algorithm option name, the algorithm configured for the application is used
+    //% "Default"
+    lst << new CutelystForms::Option(c->qtTrId("hbnbota_token_algorithm_default"), u"auto"_s, selected == "auto"_L1);
+    lst << new CutelystForms::Option(u"AES-128/GCM"_s, u"aes-128-gcm"_s, selected == "aes-128-gcm"_L1);
+    lst << new CutelystForms::Option(u"ChaCha20-Poly1305"_s, u"chacha20-poly1305"_s, selected == "chacha20-poly1305"_L1);
+    //: Token algorithm option name, the token time is only authenticated, not encrypted
+    //% "HMAC-SHA256 (time not encrypted)"
+    lst << new CutelystForms::Option(
+        c->qtTrId("hbnbota_token_algorithm_hmac"), u"hmac-sha256"_s, selected == "hmac-sha256"_L1);
+    return lst;
+}
+
+QStringList Settings::allowedTokenAlgorithms()
+{
+    QStringList lst{u"auto"_s};
+    const auto algorithms = FormToken::algorithms();
+    for (const auto a : algorithms) {
+        lst << FormToken::name(a);
+    }
+    return lst;
 }
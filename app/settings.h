@@ -6,12 +6,18 @@
 #ifndef HBNBOTA_SETTINGS_H
 #define HBNBOTA_SETTINGS_H
 
+#include "objects/formtoken.h"
+
 #include <CutelystForms/option.h>
 
+#include <QByteArray>
+#include <QDateTime>
 #include <QLocale>
 #include <QString>
 #include <QTimeZone>
 
+#include <chrono>
+
 namespace Cutelyst {
 class Context;
 }
@@ -86,6 +92,219 @@ Cache cache();
  */
 SessionStore sessionStore();
 
+/*!
+ * \brief The number of delivery threads per process.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * deliveryworkers
+ */
+int deliveryWorkers();
+
+/*!
+ * \brief The maximum number of idle SMTP sessions kept open per delivery thread.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * smtppoolsize
+ */
+int smtpPoolSize();
+
+/*!
+ * \brief Time after which idle SMTP sessions will be closed.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * smtpidletimeout
+ */
+std::chrono::seconds smtpIdleTimeout();
+
+/*!
+ * \brief The maximum number of submissions waiting in memory per delivery thread.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * deliveryqueuesize
+ */
+int deliveryQueueSize();
+
+/*!
+ * \brief Average number of waiting submissions per delivery thread above which new submissions will be rejected.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * deliveryhighwatermark
+ */
+int deliveryHighWaterMark();
+
+/*!
+ * \brief Average database write latency in milliseconds above which new submissions will be rejected.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * submitmaxlatency
+ */
+std::chrono::milliseconds submitMaxLatency();
+
+/*!
+ * \brief Seconds clients should wait before they send a rejected submission again.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * submitretryafter
+ */
+std::chrono::seconds submitRetryAfter();
+
+/*!
+ * \brief Absolute path to the sendmail compatible binary of the local MTA.
+ *
+ * The \c Sendmail sender type is only available if this is set.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * sendmailpath
+ */
+QString sendmailPath();
+
+/*!
+ * \brief Absolute path to the directory below which forms can store their messages in Maildirs.
+ *
+ * The \c Maildir sender type is only available if this is set. Every form using it
+ * has its own Maildir in a sub directory of this path.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * maildirpath
+ */
+QString maildirPath();
+
+/*!
+ * \brief The algorithm used for contact form tokens if a form does not set its own.
+ *
+ * One of \c aes-128-gcm, \c chacha20-poly1305, \c hmac-sha256 or \c auto. For \c auto,
+ * the faster of the two encrypting algorithms is measured at startup.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * tokenalgorithm
+ */
+FormToken::Algorithm tokenAlgorithm();
+
+/*!
+ * \brief The app-wide secret used to authenticate contact form tokens before the form is loaded.
+ *
+ * Has to be the same for all instances of the application. If empty, forged tokens are
+ * only rejected after the form has been loaded.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * tokensecret
+ */
+QByteArray tokenSecret();
+
+/*!
+ * \brief The time until that contact form tokens without outer MAC and in the old hex format are accepted.
+ *
+ * Set it to the time of the update plus six hours when updating from a version that created
+ * such tokens. Configured as ISO 8601 date and time. If empty or invalid, these tokens are
+ * rejected.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * legacytokensuntil
+ */
+QDateTime legacyTokensUntil();
+
+/*!
+ * \brief The number of pre-created contact form tokens kept per form and worker thread.
+ *
+ * Set to \c 0 to create every token on request.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * tokenpoolsize
+ */
+int tokenPoolSize();
+
+/*!
+ * \brief The number of used contact form tokens per process that are remembered to reject replayed submissions.
+ *
+ * Set to \c 0 to only use memcached, if it is configured as cache.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * replaycachesize
+ */
+int replayCacheSize();
+
+/*!
+ * \brief The number of forms and users per process that are kept in memory in front of the cache.
+ *
+ * Set to \c 0 to disable the in-memory cache.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * localcacheentries
+ */
+int localCacheEntries();
+
+/*!
+ * \brief The memory in bytes that the in-memory cache for forms and users may use per process.
+ *
+ * The value is configured in KiB.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * localcachememory
+ */
+qint64 localCacheMemory();
+
+/*!
+ * \brief The time after that forms and users are reloaded from the cache or the database.
+ *
+ * Changes made by other processes are visible after this time. Set to \c 0 to disable the
+ * in-memory cache.
+ *
+ * \par Section
+ * core
+ *
+ * \par Key
+ * localcachettl
+ */
+std::chrono::seconds localCacheTtl();
+
 QLocale defLocale();
 
 QTimeZone defTimeZone();
@@ -110,6 +329,18 @@ QStringList allowedSmtpEncryption();
 QList<CutelystForms::Option *> supportedSenderTypes(Cutelyst::Context *c, const QString &selected);
 
 QStringList allowedSenderTypes();
+
+QList<CutelystForms::Option *> supportedRoutingFields(Cutelyst::Context *c, const QString &selected);
+
+QStringList allowedRoutingFields();
+
+QList<CutelystForms::Option *> supportedRoutingOperators(Cutelyst::Context *c, const QString &selected);
+
+QStringList allowedRoutingOperators();
+
+QList<CutelystForms::Option *> supportedTokenAlgorithms(Cutelyst::Context *c, const QString &selected);
+
+QStringList allowedTokenAlgorithms();
 } // namespace Settings
 
 #endif // HBNBOTA_SETTINGS
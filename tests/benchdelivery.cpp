@@ -0,0 +1,260 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/deliveryworker.h"
+#include "delivery/mimeassembler.h"
+#include "delivery/smtppool.h"
+#include "objects/form.h"
+#include "objects/recipient.h"
+#include "objects/submission.h"
+#include "smtpsink.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+#include <QUuid>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <thread>
+
+using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+struct Job {
+    Submission submission;
+    clock_type::time_point enqueued;
+};
+
+// hands the submissions from the producer to the delivery thread, like the queue of a DeliveryWorker
+class JobQueue
+{
+public:
+    void push(const Job &job)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_jobs.push_back(job);
+        m_cond.wakeOne();
+    }
+
+    void finish()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_finished = true;
+        m_cond.wakeAll();
+    }
+
+    bool pop(Job &job)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_jobs.empty() && !m_finished) {
+            m_cond.wait(&m_mutex);
+        }
+        if (m_jobs.empty()) {
+            return false;
+        }
+        job = m_jobs.front();
+        m_jobs.pop_front();
+        return true;
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    std::deque<Job> m_jobs;
+    bool m_finished{false};
+};
+
+double toMSecs(clock_type::duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+double percentile(const std::vector<clock_type::duration> &sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size()))) - 1;
+    return toMSecs(sorted.at(std::min(index, sorted.size() - 1)));
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app{argc, argv};
+    app.setApplicationName(u"benchdelivery"_s);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Sends submissions through message rendering, encoding and pooled SMTP sessions to a local SMTP sink."_s);
+    parser.addHelpOption();
+
+    const QCommandLineOption submissionsOpt({u"n"_s, u"submissions"_s}, u"Number of submissions."_s, u"count"_s, u"1000"_s);
+    const QCommandLineOption recipientsOpt(
+        {u"r"_s, u"recipients"_s}, u"Number of recipients per submission."_s, u"count"_s, u"1"_s);
+    const QCommandLineOption latencyOpt(
+        {u"l"_s, u"latency"_s}, u"Latency of the SMTP sink per response batch."_s, u"msecs"_s, u"0"_s);
+    const QCommandLineOption rateOpt(
+        u"rate"_s, u"Submissions per second, 0 enqueues all at once."_s, u"count"_s, u"0"_s);
+    const QCommandLineOption noPipeliningOpt(u"no-pipelining"_s, u"Disable PIPELINING in the SMTP sink."_s);
+    const QCommandLineOption noPoolOpt(u"no-pool"_s, u"Open a new SMTP session for every submission."_s);
+    parser.addOptions({submissionsOpt, recipientsOpt, latencyOpt, rateOpt, noPipeliningOpt, noPoolOpt});
+    parser.process(app);
+
+    const int submissionCount = std::max(parser.value(submissionsOpt).toInt(), 1);
+    const int recipientCount  = std::max(parser.value(recipientsOpt).toInt(), 1);
+    const double rate         = std::max(parser.value(rateOpt).toDouble(), 0.0);
+
+    QTextStream out{stdout};
+
+    SmtpSink sink;
+    sink.setPipelining(!parser.isSet(noPipeliningOpt));
+    sink.setLatency(std::chrono::milliseconds{parser.value(latencyOpt).toInt()});
+    if (!sink.start()) {
+        out << "Failed to start SMTP sink\n";
+        return 1;
+    }
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const Form form{1,
+                    u"Benchmark"_s,
+                    u"example.com"_s,
+                    {},
+                    QUuid::createUuid().toString(QUuid::Id128),
+                    QUuid::createUuid().toString(QUuid::Id128).toUpper(),
+                    {},
+                    now,
+                    {},
+                    {},
+                    {},
+                    {},
+                    recipientCount};
+
+    QList<Recipient> recipients;
+    for (int i = 0; i < recipientCount; ++i) {
+        recipients << Recipient{static_cast<Recipient::dbid_t>(i + 1),
+                                form,
+                                u"{{form-name}}"_s,
+                                u"form@example.com"_s,
+                                u"Recipient %1"_s.arg(i),
+                                u"rcpt%1@example.net"_s.arg(i),
+                                u"[{{form-domain}}] {{subject}}"_s,
+                                u"From: {{sender-name}} <{{sender-email}}>\nDate: {{date}}\n\n{{content}}"_s,
+                                {},
+                                {},
+                                now,
+                                {},
+                                {},
+                                {}};
+    }
+
+    SmtpClient::Config config;
+    config.host = u"127.0.0.1"_s;
+    config.port = sink.port();
+
+    JobQueue queue;
+    std::vector<clock_type::time_point> enqueued(static_cast<size_t>(submissionCount));
+    int failed = 0;
+
+    QThread *delivery = QThread::create([&] {
+        SmtpPool pool{parser.isSet(noPoolOpt) ? 0 : 8, 60s};
+        MimeAssembler mime;
+        Job job;
+        while (queue.pop(job)) {
+            const auto values = job.submission.placeholderValues();
+
+            QList<SmtpClient::Message> messages;
+            messages.reserve(recipients.size());
+            for (const Recipient &r : std::as_const(recipients)) {
+                SmtpClient::Message message;
+                if (DeliveryWorker::buildMessage(job.submission, values, r, mime, message)) {
+                    messages << message;
+                }
+            }
+            mime.clearBodies();
+
+            QString error;
+            auto client = pool.acquire(config, error);
+            if (!client) {
+                failed += static_cast<int>(messages.size());
+                continue;
+            }
+
+            client->sendMails(messages);
+            failed += static_cast<int>(std::ranges::count_if(messages, [](const auto &m) { return !m.sent; }));
+
+            pool.release(std::move(client));
+        }
+    });
+    delivery->start();
+
+    const auto start = clock_type::now();
+    for (int i = 0; i < submissionCount; ++i) {
+        if (rate > 0.0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<clock_type::duration>(
+                                                      std::chrono::duration<double>(i / rate)));
+        }
+
+        const QVariantMap data{{u"name"_s, u"Sender %1"_s.arg(i)},
+                               {u"email"_s, u"sender%1@example.org"_s.arg(i)},
+                               {u"subject"_s, u"Submission %1"_s.arg(i)},
+                               {u"content"_s, u"Lorem ipsum dolor sit amet.\n"_s.repeated(20)}};
+        const auto t = clock_type::now();
+        enqueued[static_cast<size_t>(i)] = t;
+        queue.push(Job{Submission{static_cast<Submission::dbid_t>(i + 1), form, data, u"127.0.0.1"_s, now}, t});
+    }
+    queue.finish();
+
+    delivery->wait();
+    delete delivery;
+
+    // the sink records a message right after it has sent its response
+    const qsizetype expected = static_cast<qsizetype>(submissionCount) * recipientCount - failed;
+    const auto deadline      = clock_type::now() + 5s;
+    while (sink.messageCount() < expected && clock_type::now() < deadline) {
+        QThread::msleep(10);
+    }
+
+    const auto received = sink.messages();
+    sink.stop();
+
+    if (failed > 0 || received.size() != static_cast<qsizetype>(submissionCount) * recipientCount) {
+        out << "Failed to deliver " << failed << " of " << submissionCount * recipientCount << " messages, "
+            << "latencies are not reported\n";
+        return 1;
+    }
+
+    // there is only one delivery thread, so the sink receives the messages in the order of the submissions
+    std::vector<clock_type::duration> latencies;
+    latencies.reserve(static_cast<size_t>(submissionCount));
+    for (int i = 0; i < submissionCount; ++i) {
+        const auto accepted = received.at(static_cast<qsizetype>(i) * recipientCount + recipientCount - 1).accepted;
+        latencies.push_back(accepted - enqueued[static_cast<size_t>(i)]);
+    }
+    std::ranges::sort(latencies);
+
+    const double seconds = std::chrono::duration<double>(received.last().accepted - start).count();
+
+    out << "Submissions:      " << submissionCount << '\n';
+    out << "Messages:         " << received.size() << '\n';
+    out << "SMTP connections: " << sink.connections() << '\n';
+    out << "Duration:         " << QString::number(seconds, 'f', 3) << " s\n";
+    out << "Throughput:       " << QString::number(static_cast<double>(received.size()) / seconds, 'f', 1)
+        << " messages/s\n";
+    out << "Latency p50:      " << QString::number(percentile(latencies, 0.50), 'f', 2) << " ms\n";
+    out << "Latency p99:      " << QString::number(percentile(latencies, 0.99), 'f', 2) << " ms\n";
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/dkimsigner.h"
+#include "delivery/mimeassembler.h"
+
+#include <botan/auto_rng.h>
+#include <botan/ed25519.h>
+#include <botan/pkcs8.h>
+#include <botan/rsa.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+// returns the signatures per second for count messages
+double run(const QByteArray &pem, const SmtpClient::Message &message, int count, bool cached)
+{
+    const DkimSigner::Config config{u"example.com"_s, u"bench"_s, pem};
+
+    DkimSigner signer;
+    if (cached) {
+        // load the key before the measurement starts
+        SmtpClient::Message warmUp = message;
+        if (!signer.sign(config, warmUp)) {
+            return 0.0;
+        }
+    }
+
+    const auto start = clock_type::now();
+    for (int i = 0; i < count; ++i) {
+        SmtpClient::Message m = message;
+        if (cached) {
+            if (!signer.sign(config, m)) {
+                return 0.0;
+            }
+        } else {
+            // a new signer has to parse the key for every message
+            DkimSigner uncached;
+            if (!uncached.sign(config, m)) {
+                return 0.0;
+            }
+        }
+    }
+    const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    return static_cast<double>(count) / seconds;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app{argc, argv};
+    app.setApplicationName(u"benchdkim"_s);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Measures DKIM signatures per second and delivery thread for RSA-2048 and Ed25519 keys."_s);
+    parser.addHelpOption();
+
+    const QCommandLineOption messagesOpt(
+        {u"n"_s, u"messages"_s}, u"Number of messages to sign per key type."_s, u"count"_s, u"2000"_s);
+    const QCommandLineOption sizeOpt(
+        {u"s"_s, u"size"_s}, u"Size of the message body in KiB."_s, u"kib"_s, u"4"_s);
+    parser.addOptions({messagesOpt, sizeOpt});
+    parser.process(app);
+
+    const int count = std::max(parser.value(messagesOpt).toInt(), 1);
+    const int size  = std::max(parser.value(sizeOpt).toInt(), 1);
+
+    Botan::AutoSeeded_RNG rng;
+    const Botan::RSA_PrivateKey rsaKey{rng, 2048};
+    const Botan::Ed25519_PrivateKey edKey{rng};
+
+    const QList<std::pair<QString, QByteArray>> keys{
+        {u"RSA-2048"_s, QByteArray::fromStdString(Botan::PKCS8::PEM_encode(rsaKey))},
+        {u"Ed25519"_s, QByteArray::fromStdString(Botan::PKCS8::PEM_encode(edKey))}};
+
+    MimeAssembler mime;
+    SmtpClient::Message message;
+    message.from = "form@example.com"_ba;
+    message.to   = "rcpt@example.net"_ba;
+    message.data = MimeAssembler::assemble(mime.address(u"Benchmark"_s, u"form@example.com"_s),
+                                           mime.address(u"Recipient"_s, u"rcpt@example.net"_s),
+                                           {},
+                                           u"DKIM benchmark"_s,
+                                           MimeAssembler::messageId(u"form@example.com"_s),
+                                           mime.body(u"Lorem ipsum dolor sit amet, consectetur adipiscing.\n"_s.repeated(
+                                                         size * 1024 / 52),
+                                                     {}));
+
+    QTextStream out{stdout};
+    out << "Messages: " << count << ", body size: " << size << " KiB\n";
+
+    for (const auto &[name, pem] : keys) {
+        const double cached   = run(pem, message, count, true);
+        // parsing is much slower, especially for RSA, so fewer messages are enough
+        const double uncached = run(pem, message, std::max(count / 10, 1), false);
+        if (cached <= 0.0 || uncached <= 0.0) {
+            out << "Failed to sign messages with " << name << " key\n";
+            return 1;
+        }
+
+        out << name.leftJustified(10) << QString::number(cached, 'f', 1).rightJustified(10) << " signatures/s, "
+            << QString::number(uncached, 'f', 1).rightJustified(10) << " signatures/s without key cache\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/formtoken.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace Qt::Literals::StringLiterals;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app{argc, argv};
+    app.setApplicationName(u"benchtoken"_s);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        u"Measures contact form tokens per second and thread that can be created and verified per algorithm."_s);
+    parser.addHelpOption();
+
+    const QCommandLineOption durationOpt(
+        {u"d"_s, u"duration"_s}, u"Duration of the measurement per algorithm in milliseconds."_s, u"ms"_s, u"1000"_s);
+    parser.addOption(durationOpt);
+    parser.process(app);
+
+    const std::chrono::milliseconds duration{std::max(parser.value(durationOpt).toInt(), 1)};
+
+    QTextStream out{stdout};
+    out << "Duration: " << duration.count() << " ms per algorithm\n";
+
+    const auto algorithms = FormToken::algorithms();
+    for (const auto algorithm : algorithms) {
+        const double tokens = FormToken::benchmark(algorithm, duration);
+        if (tokens <= 0.0) {
+            out << "Failed to create tokens with " << FormToken::name(algorithm) << '\n';
+            return 1;
+        }
+
+        out << FormToken::name(algorithm).leftJustified(20) << QString::number(tokens, 'f', 1).rightJustified(12)
+            << " tokens/s\n";
+    }
+
+    // the same measurement is used at startup if tokenalgorithm is set to auto
+    out << "Chosen by auto: " << FormToken::name(FormToken::fastest(std::chrono::milliseconds{50})) << '\n';
+
+    return 0;
+}
@@ -0,0 +1,388 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "smtpsink.h"
+
+#include <QHostAddress>
+#include <QMutexLocker>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <memory>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+QByteArray address(const QByteArray &arg)
+{
+    const qsizetype start = arg.indexOf('<');
+    const qsizetype end   = arg.lastIndexOf('>');
+    if (start < 0 || end < start) {
+        return arg.trimmed();
+    }
+    return arg.mid(start + 1, end - start - 1);
+}
+} // namespace
+
+class SmtpSinkServer final : public QTcpServer
+{
+public:
+    explicit SmtpSinkServer(SmtpSink *sink)
+        : QTcpServer{}
+        , m_sink{sink}
+    {
+    }
+
+protected:
+    void incomingConnection(qintptr handle) override;
+
+private:
+    struct Session {
+        enum class State : quint8 { Command, Data, AuthPlain, AuthLoginUser, AuthLoginPassword };
+
+        QByteArray buffer;
+        QByteArray from;
+        QByteArrayList to;
+        QByteArray data;
+        State state{State::Command};
+        bool pipelining{true};
+    };
+
+    void handle(QTcpSocket *socket, Session &session);
+    QByteArray command(const QByteArray &line, Session &session, bool &quit);
+    void flush(QTcpSocket *socket, const QByteArray &out, const QList<SmtpSink::Message> &accepted, bool quit);
+
+    SmtpSink *m_sink{nullptr};
+};
+
+void SmtpSinkServer::incomingConnection(qintptr handle)
+{
+    auto socket = new QTcpSocket{this};
+    if (!socket->setSocketDescriptor(handle)) {
+        delete socket;
+        return;
+    }
+
+    m_sink->connectionAccepted();
+
+    auto session        = std::make_shared<Session>();
+    session->pipelining = m_sink->behavior().pipelining;
+
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket, session] { handle(socket, *session); });
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+
+    flush(socket, "220 localhost ESMTP SmtpSink\r\n"_ba, {}, false);
+}
+
+void SmtpSinkServer::handle(QTcpSocket *socket, Session &session)
+{
+    session.buffer.append(socket->readAll());
+
+    QByteArray out;
+    QList<SmtpSink::Message> accepted;
+    bool quit = false;
+
+    qsizetype end = -1;
+    while (!quit && (end = session.buffer.indexOf("\r\n")) >= 0) {
+        QByteArray line = session.buffer.left(end);
+        session.buffer.remove(0, end + 2);
+
+        if (session.state != Session::State::Data) {
+            out.append(command(line, session, quit));
+            continue;
+        }
+
+        if (line != "."_ba) {
+            // undo the transparency procedure, see RFC 5321 section 4.5.2
+            if (line.startsWith('.')) {
+                line.remove(0, 1);
+            }
+            session.data.append(line);
+            session.data.append("\r\n"_ba);
+            continue;
+        }
+
+        session.state = Session::State::Command;
+
+        const auto behavior = m_sink->behavior();
+        const int number    = m_sink->nextMessageNumber();
+        if (behavior.failEvery > 0 && number % behavior.failEvery == 0) {
+            out.append(QByteArray::number(behavior.failCode) + " Injected failure\r\n"_ba);
+        } else {
+            accepted << SmtpSink::Message{session.from, session.to, session.data, {}};
+            out.append("250 2.0.0 Ok: queued\r\n"_ba);
+        }
+
+        session.from.clear();
+        session.to.clear();
+        session.data.clear();
+    }
+
+    if (!out.isEmpty()) {
+        flush(socket, out, accepted, quit);
+    }
+}
+
+QByteArray SmtpSinkServer::command(const QByteArray &line, Session &session, bool &quit)
+{
+    switch (session.state) {
+    case Session::State::AuthPlain:
+    case Session::State::AuthLoginPassword:
+        session.state = Session::State::Command;
+        return "235 2.7.0 Authentication successful\r\n"_ba;
+    case Session::State::AuthLoginUser:
+        session.state = Session::State::AuthLoginPassword;
+        return "334 UGFzc3dvcmQ6\r\n"_ba;
+    case Session::State::Command:
+    case Session::State::Data:
+        break;
+    }
+
+    const QByteArray upper = line.toUpper();
+
+    if (upper.startsWith("EHLO"_ba) || upper.startsWith("HELO"_ba)) {
+        QByteArrayList lines{"localhost"_ba};
+        if (session.pipelining) {
+            lines << "PIPELINING"_ba;
+        }
+        lines << "AUTH PLAIN LOGIN"_ba << "8BITMIME"_ba;
+
+        QByteArray response;
+        for (qsizetype i = 0; i < lines.size(); ++i) {
+            response.append(i < lines.size() - 1 ? "250-"_ba : "250 "_ba);
+            response.append(lines.at(i));
+            response.append("\r\n"_ba);
+        }
+        return response;
+    }
+
+    if (upper.startsWith("AUTH PLAIN"_ba)) {
+        if (line.trimmed().size() > 10) {
+            return "235 2.7.0 Authentication successful\r\n"_ba;
+        }
+        session.state = Session::State::AuthPlain;
+        return "334 \r\n"_ba;
+    }
+
+    if (upper.startsWith("AUTH LOGIN"_ba)) {
+        session.state = Session::State::AuthLoginUser;
+        return "334 VXNlcm5hbWU6\r\n"_ba;
+    }
+
+    if (upper.startsWith("AUTH"_ba)) {
+        return "504 5.5.4 Unrecognized authentication type\r\n"_ba;
+    }
+
+    if (upper.startsWith("MAIL FROM:"_ba)) {
+        session.from = address(line.mid(10));
+        session.to.clear();
+        session.data.clear();
+        return "250 2.1.0 Ok\r\n"_ba;
+    }
+
+    if (upper.startsWith("RCPT TO:"_ba)) {
+        if (session.from.isEmpty()) {
+            return "503 5.5.1 Need MAIL command\r\n"_ba;
+        }
+        const QByteArray to = address(line.mid(8));
+        if (to == m_sink->behavior().rejectedRecipient) {
+            return "550 5.1.1 Recipient address rejected\r\n"_ba;
+        }
+        session.to << to;
+        return "250 2.1.5 Ok\r\n"_ba;
+    }
+
+    if (upper == "DATA"_ba) {
+        if (session.to.empty()) {
+            return "554 5.5.1 No valid recipients\r\n"_ba;
+        }
+        session.state = Session::State::Data;
+        return "354 End data with <CR><LF>.<CR><LF>\r\n"_ba;
+    }
+
+    if (upper == "RSET"_ba) {
+        session.from.clear();
+        session.to.clear();
+        session.data.clear();
+        return "250 2.0.0 Ok\r\n"_ba;
+    }
+
+    if (upper == "NOOP"_ba) {
+        return "250 2.0.0 Ok\r\n"_ba;
+    }
+
+    if (upper == "QUIT"_ba) {
+        quit = true;
+        return "221 2.0.0 Bye\r\n"_ba;
+    }
+
+    return "500 5.5.2 Error: command not recognized\r\n"_ba;
+}
+
+void SmtpSinkServer::flush(QTcpSocket *socket,
+                           const QByteArray &out,
+                           const QList<SmtpSink::Message> &accepted,
+                           bool quit)
+{
+    const auto send = [sink = m_sink, socket, out, accepted, quit] {
+        socket->write(out);
+        if (!accepted.empty()) {
+            sink->record(accepted);
+        }
+        if (quit) {
+            socket->disconnectFromHost();
+        }
+    };
+
+    // responses to one batch of commands are sent together, so they keep their order
+    const auto latency = m_sink->behavior().latency;
+    if (latency.count() > 0) {
+        QTimer::singleShot(latency, socket, send);
+    } else {
+        send();
+    }
+}
+
+SmtpSink::SmtpSink(QObject *parent)
+    : QObject{parent}
+{
+}
+
+SmtpSink::~SmtpSink()
+{
+    stop();
+}
+
+bool SmtpSink::start()
+{
+    if (m_thread) {
+        return true;
+    }
+
+    m_thread = new QThread; // NOLINT(cppcoreguidelines-owning-memory)
+    m_thread->setObjectName(u"smtpsink"_s);
+    m_server = new SmtpSinkServer{this}; // NOLINT(cppcoreguidelines-owning-memory)
+    m_server->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_server, &QObject::deleteLater);
+    m_thread->start();
+
+    bool listening = false;
+    QMetaObject::invokeMethod(
+        m_server,
+        [this, &listening] {
+            listening = m_server->listen(QHostAddress::LocalHost);
+            m_port    = m_server->serverPort();
+        },
+        Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        stop();
+    }
+
+    return listening;
+}
+
+void SmtpSink::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_server = nullptr;
+    m_port   = 0;
+}
+
+quint16 SmtpSink::port() const
+{
+    return m_port;
+}
+
+void SmtpSink::setPipelining(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_behavior.pipelining = enabled;
+}
+
+void SmtpSink::setLatency(std::chrono::milliseconds latency)
+{
+    QMutexLocker locker(&m_mutex);
+    m_behavior.latency = latency;
+}
+
+void SmtpSink::setFailEvery(int n, int code)
+{
+    QMutexLocker locker(&m_mutex);
+    m_behavior.failEvery = n;
+    m_behavior.failCode  = code;
+}
+
+void SmtpSink::setRejectedRecipient(const QByteArray &address)
+{
+    QMutexLocker locker(&m_mutex);
+    m_behavior.rejectedRecipient = address;
+}
+
+QList<SmtpSink::Message> SmtpSink::messages() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_messages;
+}
+
+qsizetype SmtpSink::messageCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_messages.size();
+}
+
+int SmtpSink::connections() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_connections;
+}
+
+void SmtpSink::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_messages.clear();
+    m_connections   = 0;
+    m_messageNumber = 0;
+}
+
+SmtpSink::Behavior SmtpSink::behavior() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_behavior;
+}
+
+int SmtpSink::nextMessageNumber()
+{
+    QMutexLocker locker(&m_mutex);
+    return ++m_messageNumber;
+}
+
+void SmtpSink::connectionAccepted()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_connections;
+}
+
+void SmtpSink::record(const QList<Message> &messages)
+{
+    const auto now = clock::now();
+
+    QMutexLocker locker(&m_mutex);
+    for (Message message : messages) {
+        message.accepted = now;
+        m_messages << message;
+    }
+}
+
+#include "moc_smtpsink.cpp"
@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HBNBOTA_SMTPSINK_H
+#define HBNBOTA_SMTPSINK_H
+
+#include <QByteArrayList>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+
+#include <chrono>
+
+class QThread;
+class SmtpSinkServer;
+
+/*!
+ * \brief Fake SMTP server that accepts and records messages.
+ *
+ * The server runs in its own thread and listens on a random port on the loopback
+ * interface, so it can be used with the blocking SmtpClient from the test thread.
+ * It supports EHLO with optional PIPELINING, AUTH PLAIN and LOGIN without checking
+ * the credentials, and the usual transaction commands.
+ *
+ * To test error handling, it can delay its responses, answer every nth message with
+ * a temporary failure and reject single recipients. All functions are thread-safe.
+ */
+class SmtpSink final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SmtpSink)
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Message {
+        QByteArray from;
+        QByteArrayList to;
+        QByteArray data;
+        clock::time_point accepted;
+    };
+
+    explicit SmtpSink(QObject *parent = nullptr);
+    ~SmtpSink() override;
+
+    /*!
+     * \brief Starts listening and returns \c false on failure.
+     */
+    bool start();
+
+    /*!
+     * \brief Closes all connections and stops the server thread.
+     */
+    void stop();
+
+    /*!
+     * \brief Returns the port the server is listening on.
+     */
+    [[nodiscard]] quint16 port() const;
+
+    /*!
+     * \brief Enables or disables the PIPELINING extension for new sessions, enabled by default.
+     */
+    void setPipelining(bool enabled);
+
+    /*!
+     * \brief Delays every batch of responses by \a latency to simulate a remote server.
+     */
+    void setLatency(std::chrono::milliseconds latency);
+
+    /*!
+     * \brief Answers every \a n th message with \a code instead of accepting it, \c 0 disables this.
+     */
+    void setFailEvery(int n, int code = 451);
+
+    /*!
+     * \brief Rejects the recipient \a address with code 550.
+     */
+    void setRejectedRecipient(const QByteArray &address);
+
+    /*!
+     * \brief Returns all accepted messages in the order of their acceptance.
+     */
+    [[nodiscard]] QList<Message> messages() const;
+
+    [[nodiscard]] qsizetype messageCount() const;
+
+    /*!
+     * \brief Returns the number of accepted connections.
+     */
+    [[nodiscard]] int connections() const;
+
+    /*!
+     * \brief Removes all recorded messages and resets the counters.
+     */
+    void clear();
+
+private:
+    friend class SmtpSinkServer;
+
+    struct Behavior {
+        QByteArray rejectedRecipient;
+        std::chrono::milliseconds latency{0};
+        int failEvery{0};
+        int failCode{451};
+        bool pipelining{true};
+    };
+
+    [[nodiscard]] Behavior behavior() const;
+    int nextMessageNumber();
+    void connectionAccepted();
+    void record(const QList<Message> &messages);
+
+    mutable QMutex m_mutex;
+    QList<Message> m_messages;
+    Behavior m_behavior;
+    QThread *m_thread{nullptr};
+    SmtpSinkServer *m_server{nullptr};
+    quint16 m_port{0};
+    int m_connections{0};
+    int m_messageNumber{0};
+};
+
+#endif // HBNBOTA_SMTPSINK_H
@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/deliveryworker.h"
+#include "delivery/suppressionlist.h"
+#include "objects/recipient.h"
+
+#include <QTest>
+#include <QUuid>
+
+using namespace Qt::Literals::StringLiterals;
+
+class DeliveryWorkerTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DeliveryWorkerTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~DeliveryWorkerTest() override = default;
+
+private slots:
+    void testDigestSingle();
+    void testDigestMultiple();
+    void testDigestStaticReplyTo();
+    void testDigestSuppressed();
+
+private:
+    [[nodiscard]] Recipient createRecipient(const QString &replyToEmail) const;
+    [[nodiscard]] QList<Submission> createSubmissions(int count) const;
+    [[nodiscard]] static QList<MessageTemplate::Values> placeholderValues(const QList<Submission> &submissions);
+
+    const QDateTime m_now{QDateTime::currentDateTimeUtc()};
+    const Form m_form{1,
+                      u"Testform"_s,
+                      u"www.example.com"_s,
+                      {},
+                      QUuid::createUuid().toString(QUuid::Id128),
+                      QUuid::createUuid().toString(QUuid::Id128),
+                      {},
+                      m_now,
+                      {},
+                      {},
+                      {},
+                      {{u"digest"_s, QVariantMap{{u"interval"_s, 60}}}},
+                      1};
+};
+
+Recipient DeliveryWorkerTest::createRecipient(const QString &replyToEmail) const
+{
+    return Recipient{1,
+                     m_form,
+                     u"{{form-name}}"_s,
+                     u"form@example.com"_s,
+                     u"Office"_s,
+                     u"office@example.net"_s,
+                     u"[{{form-domain}}] {{subject}}"_s,
+                     u"{{sender-name}}: {{content}}"_s,
+                     u"<p>{{content}}</p>"_s,
+                     {{u"replyTo"_s, QVariantMap{{u"name"_s, u"{{sender-name}}"_s}, {u"email"_s, replyToEmail}}}},
+                     m_now,
+                     {},
+                     {},
+                     {}};
+}
+
+QList<Submission> DeliveryWorkerTest::createSubmissions(int count) const
+{
+    QList<Submission> submissions;
+    for (int i = 1; i <= count; ++i) {
+        const QVariantMap data{{u"name"_s, u"Sender %1"_s.arg(i)},
+                               {u"email"_s, u"sender%1@example.org"_s.arg(i)},
+                               {u"subject"_s, u"Question %1"_s.arg(i)},
+                               {u"content"_s, u"Is %1 < %2?"_s.arg(i).arg(i + 1)}};
+        submissions << Submission{static_cast<Submission::dbid_t>(i), m_form, data, u"127.0.0.1"_s, m_now};
+    }
+    return submissions;
+}
+
+QList<MessageTemplate::Values> DeliveryWorkerTest::placeholderValues(const QList<Submission> &submissions)
+{
+    QList<MessageTemplate::Values> values;
+    for (const Submission &s : submissions) {
+        values << s.placeholderValues();
+    }
+    return values;
+}
+
+void DeliveryWorkerTest::testDigestSingle()
+{
+    const Recipient r            = createRecipient(u"{{sender-email}}"_s);
+    const QList<Submission> subs = createSubmissions(1);
+    const auto values            = placeholderValues(subs);
+
+    MimeAssembler mime;
+    SmtpClient::Message message;
+    QVERIFY(DeliveryWorker::buildDigest(subs, values, r, mime, message));
+
+    QCOMPARE(message.from, "form@example.com"_ba);
+    QCOMPARE(message.to, "office@example.net"_ba);
+    QVERIFY(message.data.contains("\r\nSubject: [www.example.com] Question 1\r\n"_ba));
+    // a single submission is answered like a normal message
+    QVERIFY(message.data.contains("\r\nReply-To: \"Sender 1\" <sender1@example.org>\r\n"_ba));
+    QVERIFY(message.data.endsWith(mime.body(u"Sender 1: Is 1 < 2?"_s, u"<p>Is 1 &lt; 2?</p>"_s)));
+}
+
+void DeliveryWorkerTest::testDigestMultiple()
+{
+    const Recipient r            = createRecipient(u"{{sender-email}}"_s);
+    const QList<Submission> subs = createSubmissions(3);
+    const auto values            = placeholderValues(subs);
+
+    MimeAssembler mime;
+    SmtpClient::Message message;
+    QVERIFY(DeliveryWorker::buildDigest(subs, values, r, mime, message));
+
+    // headers are rendered with the first submission, the subject counts the other ones
+    QVERIFY(message.data.startsWith("From: \"Testform\" <form@example.com>\r\nTo: \"Office\" <office@example.net>\r\n"_ba));
+    QVERIFY(message.data.contains("\r\nSubject: [www.example.com] Question 1 (+2)\r\n"_ba));
+
+    // replying would only reach the sender of the first submission
+    QVERIFY(!message.data.contains("Reply-To:"_ba));
+
+    const QString separator = u"\n\n----------------------------------------\n\n"_s;
+    const QString text =
+        u"Sender 1: Is 1 < 2?"_s + separator + u"Sender 2: Is 2 < 3?"_s + separator + u"Sender 3: Is 3 < 4?"_s;
+    const QString html = u"<p>Is 1 &lt; 2?</p>\n<hr>\n<p>Is 2 &lt; 3?</p>\n<hr>\n<p>Is 3 &lt; 4?</p>"_s;
+    QVERIFY(message.data.endsWith(mime.body(text, html)));
+}
+
+void DeliveryWorkerTest::testDigestStaticReplyTo()
+{
+    const Recipient r            = createRecipient(u"support@example.com"_s);
+    const QList<Submission> subs = createSubmissions(2);
+    const auto values            = placeholderValues(subs);
+
+    MimeAssembler mime;
+    SmtpClient::Message message;
+    QVERIFY(DeliveryWorker::buildDigest(subs, values, r, mime, message));
+
+    // an address without placeholders does not belong to one of the submissions
+    QVERIFY(message.data.contains("\r\nReply-To: \"Sender 1\" <support@example.com>\r\n"_ba));
+    QVERIFY(message.data.contains("\r\nSubject: [www.example.com] Question 1 (+1)\r\n"_ba));
+}
+
+void DeliveryWorkerTest::testDigestSuppressed()
+{
+    const Recipient r            = createRecipient({});
+    const QList<Submission> subs = createSubmissions(2);
+    const auto values            = placeholderValues(subs);
+
+    SuppressionList::instance()->insert(m_form.id(), u"office@example.net"_s);
+
+    MimeAssembler mime;
+    SmtpClient::Message message;
+    QVERIFY(!DeliveryWorker::buildDigest(subs, values, r, mime, message));
+    QVERIFY(message.data.isEmpty());
+
+    SuppressionList::instance()->remove(m_form.id(), u"office@example.net"_s);
+    QVERIFY(DeliveryWorker::buildDigest(subs, values, r, mime, message));
+}
+
+QTEST_MAIN(DeliveryWorkerTest)
+
+#include "testdeliveryworker.moc"
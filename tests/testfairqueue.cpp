@@ -0,0 +1,166 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/fairqueue.h"
+#include "delivery/relaylimiter.h"
+
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
+class FairQueueTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FairQueueTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~FairQueueTest() override = default;
+
+private slots:
+    void testFifoPerFlow();
+    void testFlood();
+    void testWeight();
+    void testSkipNotReady();
+    void testRateLimit();
+    void testSessionLimit();
+    void testSharedRelay();
+};
+
+void FairQueueTest::testFifoPerFlow()
+{
+    FairQueue<int, int> q;
+    for (int i = 0; i < 5; ++i) {
+        q.push(1, i);
+    }
+    QCOMPARE(q.size(), qsizetype{5});
+    QCOMPARE(q.flows(), qsizetype{1});
+
+    for (int i = 0; i < 5; ++i) {
+        QCOMPARE(q.pop(), std::optional<int>{i});
+    }
+    QVERIFY(q.isEmpty());
+    QVERIFY(!q.pop());
+}
+
+void FairQueueTest::testFlood()
+{
+    FairQueue<int, int> q;
+    for (int i = 0; i < 1'000; ++i) {
+        q.push(1, i);
+    }
+    q.push(2, 1'000);
+    q.push(3, 1'001);
+
+    // the flooding flow gets one turn, then the others are served
+    QCOMPARE(q.pop(), std::optional<int>{0});
+    QCOMPARE(q.pop(), std::optional<int>{1'000});
+    QCOMPARE(q.pop(), std::optional<int>{1'001});
+    QCOMPARE(q.pop(), std::optional<int>{1});
+    QCOMPARE(q.flows(), qsizetype{1});
+}
+
+void FairQueueTest::testWeight()
+{
+    FairQueue<int, int> q;
+    for (int i = 0; i < 6; ++i) {
+        q.push(1, 10 + i, 2);
+        q.push(2, 20 + i, 1);
+    }
+
+    const QList<int> expected{10, 11, 20, 12, 13, 21, 14, 15, 22, 23, 24, 25};
+    QList<int> result;
+    while (auto item = q.pop()) {
+        result << *item;
+    }
+    QCOMPARE(result, expected);
+}
+
+void FairQueueTest::testSkipNotReady()
+{
+    FairQueue<int, int> q;
+    q.push(1, 10);
+    q.push(1, 11);
+    q.push(2, 20);
+
+    const auto notOne = [](int item) { return item < 10 || item >= 20; };
+    QCOMPARE(q.pop(notOne), std::optional<int>{20});
+    QVERIFY(!q.pop(notOne));
+    QCOMPARE(q.size(), qsizetype{2});
+    QCOMPARE(q.pop(), std::optional<int>{10});
+}
+
+void FairQueueTest::testRateLimit()
+{
+    RelayLimiter l;
+    const RelayLimiter::Limits limits{10.0, 0};
+    const QString relay = u"smtp.example.net:465"_s;
+    const auto start    = RelayLimiter::clock::now();
+
+    // the bucket holds the tokens for one second
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(l.tryAcquire(relay, limits, 1, nullptr, start));
+        l.release(relay);
+    }
+
+    std::chrono::milliseconds wait{0};
+    QVERIFY(!l.tryAcquire(relay, limits, 1, &wait, start));
+    QCOMPARE(wait, 100ms);
+    QCOMPARE(l.delay(relay, limits, start + 50ms), 50ms);
+    QVERIFY(l.tryAcquire(relay, limits, 5, nullptr, start + 100ms));
+    l.release(relay);
+
+    // the batch has been debited completely, so the average rate is kept
+    QVERIFY(!l.tryAcquire(relay, limits, 1, &wait, start + 500ms));
+    QVERIFY(wait > 0ms && wait <= 100ms);
+
+    // other relays are not affected
+    QVERIFY(l.tryAcquire(u"mail.example.com:25"_s, limits, 1, nullptr, start + 500ms));
+}
+
+void FairQueueTest::testSessionLimit()
+{
+    RelayLimiter l;
+    const RelayLimiter::Limits limits{0.0, 2};
+    const QString relay = u"smtp.example.net:465"_s;
+
+    QVERIFY(l.tryAcquire(relay, limits, 100));
+    QVERIFY(l.tryAcquire(relay, limits, 100));
+    QVERIFY(!l.tryAcquire(relay, limits, 1));
+    QVERIFY(l.delay(relay, limits) > 0ms);
+    l.release(relay);
+    QVERIFY(l.tryAcquire(relay, limits, 1));
+}
+
+void FairQueueTest::testSharedRelay()
+{
+    RelayLimiter l;
+    const RelayLimiter::Limits limited{10.0, 1};
+    const RelayLimiter::Limits relaxed{100.0, 0};
+    const RelayLimiter::Limits unlimited{};
+    const QString relay = u"smtp.example.net:465"_s;
+    const auto start    = RelayLimiter::clock::now();
+
+    QVERIFY(l.tryAcquire(relay, limited, 1, nullptr, start));
+    l.release(relay);
+
+    // forms without own or with less restrictive limits are throttled and debited, too
+    QVERIFY(l.tryAcquire(relay, unlimited, 9, nullptr, start));
+    QVERIFY(!l.tryAcquire(relay, relaxed, 1, nullptr, start));
+    l.release(relay);
+
+    std::chrono::milliseconds wait{0};
+    QVERIFY(!l.tryAcquire(relay, unlimited, 1, &wait, start));
+    QCOMPARE(wait, 100ms);
+    QCOMPARE(l.delay(relay, relaxed, start), 100ms);
+    QVERIFY(!l.tryAcquire(relay, limited, 1, nullptr, start));
+    QVERIFY(l.tryAcquire(relay, unlimited, 1, nullptr, start + 100ms));
+}
+
+QTEST_MAIN(FairQueueTest)
+
+#include "testfairqueue.moc"
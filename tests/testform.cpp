@@ -4,8 +4,15 @@
  */
 
 #include "objects/form.h"
+#include "objects/formtoken.h"
 
+#include <botan/cipher_mode.h>
+#include <botan/hex.h>
+
+#include <QDataStream>
+#include <QRegularExpression>
 #include <QTest>
+#include <QTimeZone>
 #include <QUuid>
 
 using namespace Qt::Literals::StringLiterals;
@@ -22,6 +29,19 @@ public:
 
 private slots:
     void testEncryption();
+    void testEncryptionFromStream();
+    void testInvalidSecret();
+    void testTokenFormat();
+    void testLegacyToken();
+    void testTamperedToken_data();
+    void testTamperedToken();
+    void testDeliveryWeight_data();
+    void testDeliveryWeight();
+    void testNextDigest_data();
+    void testNextDigest();
+
+private:
+    [[nodiscard]] static Form createForm(const QString &secret);
 };
 
 void FormTest::testEncryption()
@@ -49,6 +69,222 @@ void FormTest::testEncryption()
     QCOMPARE(now, dt);
 }
 
+void FormTest::testEncryptionFromStream()
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    const Form f{1,
+                 u"Testform"_s,
+                 u"www.example.com"_s,
+                 {},
+                 QUuid::createUuid().toString(QUuid::Id128),
+                 QUuid::createUuid().toString(QUuid::Id128).toUpper(),
+                 {},
+                 now,
+                 {},
+                 {},
+                 {},
+                 {},
+                 0};
+
+    QByteArray ba;
+    {
+        QDataStream out{&ba, QIODevice::WriteOnly};
+        out << f;
+    }
+
+    Form cached;
+    {
+        QDataStream in{ba};
+        in >> cached;
+    }
+
+    // the key has to be restored for forms read from memcached
+    QCOMPARE(cached.decrypt(f.encrypt(now)), now);
+    QCOMPARE(f.decrypt(cached.encrypt(now)), now);
+}
+
+void FormTest::testInvalidSecret()
+{
+    const Form f{1,
+                 u"Testform"_s,
+                 u"www.example.com"_s,
+                 {},
+                 QUuid::createUuid().toString(QUuid::Id128),
+                 u"not a hex string"_s,
+                 {},
+                 QDateTime::currentDateTimeUtc(),
+                 {},
+                 {},
+                 {},
+                 {},
+                 0};
+
+    QVERIFY(f.encrypt(QDateTime::currentDateTimeUtc()).isEmpty());
+    QVERIFY(!f.decrypt("00:00"_ba).isValid());
+}
+
+Form FormTest::createForm(const QString &secret)
+{
+    return Form{1,
+                u"Testform"_s,
+                u"www.example.com"_s,
+                {},
+                QUuid::createUuid().toString(QUuid::Id128),
+                secret,
+                {},
+                QDateTime::currentDateTimeUtc(),
+                {},
+                {},
+                {},
+                {},
+                0};
+}
+
+void FormTest::testTokenFormat()
+{
+    const Form f = createForm(QUuid::createUuid().toString(QUuid::Id128).toUpper());
+
+    const QByteArray token = f.encrypt(QDateTime::currentDateTimeUtc());
+    // 1 byte version, 12 bytes nonce, 8 bytes time, 16 bytes tag, 4 bytes key ID and 8 bytes outer MAC
+    QCOMPARE(token.size(), qsizetype{66});
+    QVERIFY(FormToken::precheck(f.uuid(), token));
+    QVERIFY(QRegularExpression{u"^[A-Za-z0-9_-]+$"_s}.match(QString::fromLatin1(token)).hasMatch());
+
+    // every token has its own nonce
+    QVERIFY(token != f.encrypt(QDateTime::currentDateTimeUtc()));
+}
+
+void FormTest::testLegacyToken()
+{
+    const QString secret = QUuid::createUuid().toString(QUuid::Id128).toUpper();
+    const Form f         = createForm(secret);
+    const QDateTime now  = QDateTime::fromMSecsSinceEpoch(QDateTime::currentMSecsSinceEpoch(), QTimeZone::utc());
+
+    // token in the format used before the binary tokens: hex(iv) ":" hex(ciphertext + tag)
+    const auto key        = Botan::hex_decode(secret.toStdString());
+    const auto enc        = Botan::Cipher_Mode::create("AES-128/GCM", Botan::Cipher_Dir::ENCRYPTION);
+    const QByteArray time = QByteArray::number(now.toMSecsSinceEpoch());
+    Botan::secure_vector<uint8_t> iv(12, 0x42);
+    Botan::secure_vector<uint8_t> t{time.constData(), time.constData() + time.size()};
+    enc->set_key(key);
+    enc->start(iv);
+    enc->finish(t);
+    const QByteArray token =
+        QByteArray::fromStdString(Botan::hex_encode(iv)) + ":"_ba + QByteArray::fromStdString(Botan::hex_encode(t));
+
+    QVERIFY(!f.decrypt(token).isValid());
+
+    FormToken::setLegacyDeadline(QDateTime::currentDateTimeUtc().addSecs(60));
+    QCOMPARE(f.decrypt(token), now);
+
+    FormToken::setLegacyDeadline(QDateTime::currentDateTimeUtc().addSecs(-1));
+    QVERIFY(!f.decrypt(token).isValid());
+    FormToken::setLegacyDeadline({});
+}
+
+void FormTest::testTamperedToken_data()
+{
+    QTest::addColumn<qsizetype>("pos");
+
+    QTest::newRow("version") << qsizetype{0};
+    QTest::newRow("nonce") << qsizetype{5};
+    QTest::newRow("time") << qsizetype{20};
+    QTest::newRow("tag") << qsizetype{45};
+    QTest::newRow("key-id") << qsizetype{52};
+    QTest::newRow("padding-bits") << qsizetype{65};
+}
+
+void FormTest::testTamperedToken()
+{
+    QFETCH(qsizetype, pos);
+
+    const Form f = createForm(QUuid::createUuid().toString(QUuid::Id128).toUpper());
+
+    QByteArray token = f.encrypt(QDateTime::currentDateTimeUtc());
+    QVERIFY(f.decrypt(token).isValid());
+
+    token[pos] = token.at(pos) == 'A' ? 'B' : 'A';
+    QVERIFY(!f.decrypt(token).isValid());
+
+    QVERIFY(!f.decrypt(token.chopped(1)).isValid());
+    QVERIFY(!f.decrypt(QByteArray{token}.replace(pos, 1, "*")).isValid());
+}
+
+void FormTest::testDeliveryWeight_data()
+{
+    QTest::addColumn<QVariantMap>("settings");
+    QTest::addColumn<int>("weight");
+
+    QTest::newRow("unset") << QVariantMap{} << 1;
+    QTest::newRow("valid") << QVariantMap{{u"mailer"_s, QVariantMap{{u"weight"_s, 5}}}} << 5;
+    QTest::newRow("zero") << QVariantMap{{u"mailer"_s, QVariantMap{{u"weight"_s, 0}}}} << 1;
+    QTest::newRow("too-large") << QVariantMap{{u"mailer"_s, QVariantMap{{u"weight"_s, 1000}}}} << Form::maxDeliveryWeight;
+}
+
+void FormTest::testDeliveryWeight()
+{
+    QFETCH(QVariantMap, settings);
+    QFETCH(int, weight);
+
+    const Form f{1,
+                 u"Testform"_s,
+                 u"www.example.com"_s,
+                 {},
+                 QUuid::createUuid().toString(QUuid::Id128),
+                 QUuid::createUuid().toString(QUuid::Id128),
+                 {},
+                 QDateTime::currentDateTimeUtc(),
+                 {},
+                 {},
+                 {},
+                 settings,
+                 0};
+    QCOMPARE(f.deliveryWeight(), weight);
+    QCOMPARE(Form{}.deliveryWeight(), 1);
+}
+
+void FormTest::testNextDigest_data()
+{
+    QTest::addColumn<int>("interval");
+    QTest::addColumn<QDateTime>("time");
+    QTest::addColumn<QDateTime>("next");
+
+    const QDateTime time{QDate{2024, 5, 17}, QTime{12, 34, 56}, QTimeZone::utc()};
+    const QDateTime full{QDate{2024, 5, 17}, QTime{13, 0}, QTimeZone::utc()};
+
+    QTest::newRow("disabled") << 0 << time << QDateTime();
+    QTest::newRow("quarter") << 15 << time << QDateTime{QDate{2024, 5, 17}, QTime{12, 45}, QTimeZone::utc()};
+    QTest::newRow("hour") << 60 << time << full;
+    QTest::newRow("hour-boundary") << 60 << full << full.addSecs(3600);
+    QTest::newRow("day") << 1'440 << time << QDateTime{QDate{2024, 5, 18}, QTime{0, 0}, QTimeZone::utc()};
+    QTest::newRow("other-zone") << 60 << time.toTimeZone(QTimeZone{7'200}) << full;
+}
+
+void FormTest::testNextDigest()
+{
+    QFETCH(int, interval);
+    QFETCH(QDateTime, time);
+    QFETCH(QDateTime, next);
+
+    const Form f{1,
+                 u"Testform"_s,
+                 u"www.example.com"_s,
+                 {},
+                 QUuid::createUuid().toString(QUuid::Id128),
+                 QUuid::createUuid().toString(QUuid::Id128),
+                 {},
+                 QDateTime::currentDateTimeUtc(),
+                 {},
+                 {},
+                 {},
+                 {{u"digest"_s, QVariantMap{{u"interval"_s, interval}}}},
+                 0};
+
+    QCOMPARE(f.digestInterval(), std::chrono::minutes{interval});
+    QCOMPARE(f.nextDigest(time), next);
+}
+
 QTEST_MAIN(FormTest)
 
 #include "testform.moc"
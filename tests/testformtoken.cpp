@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/formtoken.h"
+
+#include <QCryptographicHash>
+#include <QTest>
+#include <QTimeZone>
+#include <QUuid>
+
+using namespace Qt::Literals::StringLiterals;
+
+class FormTokenTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FormTokenTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~FormTokenTest() override = default;
+
+private slots:
+    void initTestCase();
+
+    void testRoundTrip_data();
+    void testRoundTrip();
+
+    void testWrongKeys_data();
+    void testWrongKeys();
+
+    void testPrecheck();
+
+    void testWork();
+
+    void testDefaultAlgorithm();
+    void testNames();
+    void testBenchmark();
+
+private:
+    [[nodiscard]] static FormToken::Keys createKeys();
+    // the first byte of the token, the algorithm with the flag for key ID and outer MAC
+    [[nodiscard]] static int version(const QByteArray &token);
+
+    FormToken::Keys m_keys;
+    QString m_uuid;
+    QDateTime m_now;
+};
+
+FormToken::Keys FormTokenTest::createKeys()
+{
+    return FormToken::Keys::fromSecret(QUuid::createUuid().toString(QUuid::Id128).toUpper());
+}
+
+int FormTokenTest::version(const QByteArray &token)
+{
+    return static_cast<quint8>(QByteArray::fromBase64(token.left(4), QByteArray::Base64UrlEncoding).at(0));
+}
+
+void FormTokenTest::initTestCase()
+{
+    m_keys = createKeys();
+    QVERIFY(m_keys.isValid());
+    QCOMPARE(m_keys.aes.size(), qsizetype{16});
+    QCOMPARE(m_keys.chacha.size(), qsizetype{32});
+    QCOMPARE(m_keys.mac.size(), qsizetype{32});
+    QVERIFY(m_keys.chacha != m_keys.mac);
+    QVERIFY(m_keys.id != createKeys().id);
+
+    FormToken::setAppSecret("app-secret");
+
+    m_uuid = QUuid::createUuid().toString(QUuid::Id128);
+
+    m_now = QDateTime::fromMSecsSinceEpoch(QDateTime::currentMSecsSinceEpoch(), QTimeZone::utc());
+}
+
+void FormTokenTest::testRoundTrip_data()
+{
+    QTest::addColumn<FormToken::Algorithm>("algorithm");
+    QTest::addColumn<qsizetype>("length");
+
+    QTest::newRow("aes-128-gcm") << FormToken::Algorithm::Aes128Gcm << qsizetype{66};
+    QTest::newRow("chacha20-poly1305") << FormToken::Algorithm::ChaCha20Poly1305 << qsizetype{66};
+    QTest::newRow("hmac-sha256") << FormToken::Algorithm::HmacSha256 << qsizetype{66};
+}
+
+void FormTokenTest::testRoundTrip()
+{
+    QFETCH(FormToken::Algorithm, algorithm);
+    QFETCH(qsizetype, length);
+
+    QByteArray token = FormToken::create(algorithm, m_keys, m_uuid, m_now);
+    QCOMPARE(token.size(), length);
+    FormToken::Nonce nonce{};
+    QCOMPARE(FormToken::verify(m_keys, m_uuid, token, &nonce), m_now);
+    QVERIFY(nonce != FormToken::Nonce{});
+
+    // tokens for the same time differ by their nonce
+    FormToken::Nonce other{};
+    QVERIFY(FormToken::verify(m_keys, m_uuid, FormToken::create(algorithm, m_keys, m_uuid, m_now), &other).isValid());
+    QVERIFY(nonce != other);
+
+    // every bit of the token is protected
+    for (qsizetype i = 0; i < token.size(); ++i) {
+        QByteArray tampered = token;
+        tampered[i]         = token.at(i) == 'A' ? 'B' : 'A';
+        QVERIFY2(!FormToken::verify(m_keys, m_uuid, tampered).isValid(), qUtf8Printable(u"Position %1"_s.arg(i)));
+    }
+}
+
+void FormTokenTest::testWrongKeys_data()
+{
+    testRoundTrip_data();
+}
+
+void FormTokenTest::testWrongKeys()
+{
+    QFETCH(FormToken::Algorithm, algorithm);
+
+    const QByteArray token = FormToken::create(algorithm, m_keys, m_uuid, m_now);
+    QVERIFY(!FormToken::verify(createKeys(), m_uuid, token).isValid());
+    QVERIFY(FormToken::create(algorithm, FormToken::Keys{}, m_uuid, m_now).isEmpty());
+    QVERIFY(!FormToken::verify(FormToken::Keys{}, m_uuid, token).isValid());
+    QVERIFY(!FormToken::verify(m_keys, QUuid::createUuid().toString(QUuid::Id128), token).isValid());
+}
+
+void FormTokenTest::testPrecheck()
+{
+    const QByteArray token = FormToken::create(FormToken::Algorithm::Default, m_keys, m_uuid, m_now);
+    QVERIFY(FormToken::precheck(m_uuid, token));
+    QVERIFY(FormToken::precheck(m_uuid.toUpper(), token));
+    QVERIFY(!FormToken::precheck(QUuid::createUuid().toString(QUuid::Id128), token));
+
+    QByteArray tampered = token;
+    tampered[60]        = token.at(60) == 'A' ? 'B' : 'A';
+    QVERIFY(!FormToken::precheck(m_uuid, tampered));
+    QVERIFY(!FormToken::precheck(m_uuid, token.chopped(1)));
+    QVERIFY(!FormToken::precheck(m_uuid, "garbage"));
+    QVERIFY(!FormToken::precheck(m_uuid, {}));
+
+    // the outer MAC does not depend on the form keys, the key ID is checked by verify()
+    const QByteArray other = FormToken::create(FormToken::Algorithm::Default, createKeys(), m_uuid, m_now);
+    QVERIFY(FormToken::precheck(m_uuid, other));
+    QVERIFY(!FormToken::verify(m_keys, m_uuid, other).isValid());
+
+    // legacy tokens are only accepted until the configured deadline and only in the hex format
+    const QByteArray legacy = QByteArray(24, 'a') + ':' + QByteArray(58, 'b');
+    QVERIFY(!FormToken::precheck(m_uuid, legacy));
+    FormToken::setLegacyDeadline(QDateTime::currentDateTimeUtc().addSecs(60));
+    QVERIFY(FormToken::precheck(m_uuid, legacy));
+    QVERIFY(!FormToken::precheck(m_uuid, "Hi: test"));
+    QVERIFY(!FormToken::precheck(m_uuid, QByteArray(24, 'a') + ':' + QByteArray(58, 'x')));
+    QVERIFY(!FormToken::precheck(m_uuid, QByteArray(23, 'a') + ':' + QByteArray(58, 'b')));
+    QVERIFY(!FormToken::precheck(m_uuid, QByteArray(24, 'a') + ':' + QByteArray(57, 'b')));
+    FormToken::setLegacyDeadline({});
+    QVERIFY(!FormToken::precheck(m_uuid, legacy));
+}
+
+void FormTokenTest::testWork()
+{
+    const QByteArray token     = FormToken::create(FormToken::Algorithm::Default, m_keys, m_uuid, m_now);
+    const QByteArray challenge = FormToken::challenge(m_keys, token, 8);
+    QVERIFY(challenge.startsWith("8."_ba));
+
+    // solve it like a client would do
+    QByteArray work;
+    for (int nonce = 0; nonce < 1'000'000; ++nonce) {
+        const QByteArray candidate = challenge + ':' + QByteArray::number(nonce);
+        if (QCryptographicHash::hash(token + ':' + candidate, QCryptographicHash::Sha256).at(0) == 0) {
+            work = candidate;
+            break;
+        }
+    }
+    QVERIFY(!work.isEmpty());
+
+    QVERIFY(FormToken::verifyWork(m_keys, token, work));
+    QVERIFY(!FormToken::verifyWork(createKeys(), token, work));
+    const QByteArray other = FormToken::create(FormToken::Algorithm::Default, m_keys, m_uuid, m_now);
+    QVERIFY(!FormToken::verifyWork(m_keys, other, work));
+    QVERIFY(!FormToken::verifyWork(m_keys, token, "4"_ba + work.mid(1)));
+    QVERIFY(!FormToken::verifyWork(m_keys, token, challenge));
+    QVERIFY(!FormToken::verifyWork(m_keys, token, {}));
+
+    QVERIFY(FormToken::challenge(m_keys, token, 0).isEmpty());
+    QVERIFY(FormToken::challenge(m_keys, token, FormToken::maxWorkDifficulty + 1).isEmpty());
+}
+
+void FormTokenTest::testDefaultAlgorithm()
+{
+    FormToken::setDefaultAlgorithm(FormToken::Algorithm::HmacSha256);
+    QCOMPARE(FormToken::defaultAlgorithm(), FormToken::Algorithm::HmacSha256);
+    QCOMPARE(version(FormToken::create(FormToken::Algorithm::Default, m_keys, m_uuid, m_now)), 0x83);
+
+    // Default can not be the default
+    FormToken::setDefaultAlgorithm(FormToken::Algorithm::Default);
+    QCOMPARE(FormToken::defaultAlgorithm(), FormToken::Algorithm::HmacSha256);
+
+    FormToken::setDefaultAlgorithm(FormToken::Algorithm::Aes128Gcm);
+    QCOMPARE(version(FormToken::create(FormToken::Algorithm::Default, m_keys, m_uuid, m_now)), 0x81);
+}
+
+void FormTokenTest::testNames()
+{
+    const auto algorithms = FormToken::algorithms();
+    for (const auto algorithm : algorithms) {
+        bool ok = false;
+        QCOMPARE(FormToken::fromName(FormToken::name(algorithm), &ok), algorithm);
+        QVERIFY(ok);
+    }
+
+    bool ok = false;
+    QCOMPARE(FormToken::fromName(u"auto", &ok), FormToken::Algorithm::Default);
+    QVERIFY(ok);
+    QCOMPARE(FormToken::fromName(u"", &ok), FormToken::Algorithm::Default);
+    QVERIFY(ok);
+    QCOMPARE(FormToken::fromName(u"des", &ok), FormToken::Algorithm::Default);
+    QVERIFY(!ok);
+}
+
+void FormTokenTest::testBenchmark()
+{
+    QVERIFY(FormToken::benchmark(FormToken::Algorithm::ChaCha20Poly1305, std::chrono::milliseconds{5}) > 0.0);
+
+    const auto fastest = FormToken::fastest(std::chrono::milliseconds{5});
+    QVERIFY(fastest == FormToken::Algorithm::Aes128Gcm || fastest == FormToken::Algorithm::ChaCha20Poly1305);
+}
+
+QTEST_MAIN(FormTokenTest)
+
+#include "testformtoken.moc"
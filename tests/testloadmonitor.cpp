@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/loadmonitor.h"
+
+#include <QTest>
+
+using namespace std::chrono_literals;
+
+class LoadMonitorTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoadMonitorTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~LoadMonitorTest() override = default;
+
+private slots:
+    void testAverage();
+    void testExpiredSamples();
+    void testLatencyLimit();
+    void testHighWaterMark_data();
+    void testHighWaterMark();
+
+private:
+    const LoadMonitor::Limits m_limits{500ms, 10s, 100};
+    const LoadMonitor::clock::time_point m_start{LoadMonitor::clock::now()};
+};
+
+void LoadMonitorTest::testAverage()
+{
+    LoadMonitor m;
+    QCOMPARE(m.latency(10s, m_start), 0us);
+
+    // the first sample starts the average
+    m.reportLatency(800us, 10s, m_start);
+    QCOMPARE(m.latency(10s, m_start), 800us);
+
+    // new samples are weighted with 1/8
+    m.reportLatency(1'600us, 10s, m_start + 1s);
+    QCOMPARE(m.latency(10s, m_start + 1s), 900us);
+    m.reportLatency(100us, 10s, m_start + 2s);
+    QCOMPARE(m.latency(10s, m_start + 2s), 800us);
+}
+
+void LoadMonitorTest::testExpiredSamples()
+{
+    LoadMonitor m;
+    m.reportLatency(800us, 10s, m_start);
+
+    QCOMPARE(m.latency(10s, m_start + 9s), 800us);
+    QCOMPARE(m.latency(10s, m_start + 10s), 0us);
+
+    // a sample after a long pause starts a new average
+    m.reportLatency(80us, 10s, m_start + 20s);
+    QCOMPARE(m.latency(10s, m_start + 20s), 80us);
+}
+
+void LoadMonitorTest::testLatencyLimit()
+{
+    LoadMonitor m;
+    QVERIFY(!m.isOverloaded(0, 4, m_limits, m_start));
+
+    m.reportLatency(2s, m_limits.sampleLifetime, m_start);
+    QVERIFY(m.isOverloaded(0, 4, m_limits, m_start));
+    // also without delivery threads
+    QVERIFY(m.isOverloaded(0, 0, m_limits, m_start));
+
+    // fast writes bring the average down again
+    auto now = m_start;
+    while (m.latency(m_limits.sampleLifetime, now) > m_limits.maxLatency) {
+        now += 1s;
+        m.reportLatency(1ms, m_limits.sampleLifetime, now);
+    }
+    QVERIFY(now - m_start < 30s);
+    QVERIFY(!m.isOverloaded(0, 4, m_limits, now));
+
+    // a slow write is forgotten after the sample lifetime
+    m.reportLatency(100s, m_limits.sampleLifetime, now + 20s);
+    QVERIFY(m.isOverloaded(0, 4, m_limits, now + 20s));
+    QVERIFY(!m.isOverloaded(0, 4, m_limits, now + 30s));
+}
+
+void LoadMonitorTest::testHighWaterMark_data()
+{
+    QTest::addColumn<qsizetype>("queued");
+    QTest::addColumn<qsizetype>("workers");
+    QTest::addColumn<bool>("overloaded");
+
+    QTest::newRow("empty") << qsizetype{0} << qsizetype{4} << false;
+    QTest::newRow("at-mark") << qsizetype{400} << qsizetype{4} << false;
+    QTest::newRow("above-mark") << qsizetype{401} << qsizetype{4} << true;
+    QTest::newRow("single-thread") << qsizetype{101} << qsizetype{1} << true;
+    QTest::newRow("not-started") << qsizetype{1'000} << qsizetype{0} << false;
+}
+
+void LoadMonitorTest::testHighWaterMark()
+{
+    QFETCH(qsizetype, queued);
+    QFETCH(qsizetype, workers);
+    QFETCH(bool, overloaded);
+
+    LoadMonitor m;
+    m.reportLatency(1ms, m_limits.sampleLifetime, m_start);
+    QCOMPARE(m.isOverloaded(queued, workers, m_limits, m_start), overloaded);
+}
+
+QTEST_MAIN(LoadMonitorTest)
+
+#include "testloadmonitor.moc"
@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/localcache.h"
+
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+
+class LocalCacheTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalCacheTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~LocalCacheTest() override = default;
+
+private slots:
+    void testInsert();
+    void testEvictEntries();
+    void testEvictCost();
+    void testExpire();
+    void testDisabled();
+
+private:
+    using Cache = LocalCache<int, QString>;
+
+    const Cache::Clock::time_point m_now{Cache::Clock::now()};
+};
+
+void LocalCacheTest::testInsert()
+{
+    Cache cache{4, 100, std::chrono::seconds{10}};
+    QVERIFY(cache.isEnabled());
+    QVERIFY(cache.object(1, m_now).isNull());
+
+    cache.insert(1, u"one"_s, 10, m_now);
+    cache.insert(2, u"two"_s, 20, m_now);
+    QCOMPARE(cache.object(1, m_now), u"one"_s);
+    QCOMPARE(cache.object(2, m_now), u"two"_s);
+    QCOMPARE(cache.size(), qsizetype{2});
+    QCOMPARE(cache.cost(), qint64{30});
+
+    cache.insert(1, u"uno"_s, 5, m_now);
+    QCOMPARE(cache.object(1, m_now), u"uno"_s);
+    QCOMPARE(cache.size(), qsizetype{2});
+    QCOMPARE(cache.cost(), qint64{25});
+
+    cache.remove(2);
+    QVERIFY(cache.object(2, m_now).isNull());
+    QCOMPARE(cache.cost(), qint64{5});
+
+    // too large to be stored, replaces the existing entry
+    cache.insert(1, u"huge"_s, 101, m_now);
+    QVERIFY(cache.object(1, m_now).isNull());
+    QCOMPARE(cache.size(), qsizetype{0});
+    QCOMPARE(cache.cost(), qint64{0});
+}
+
+void LocalCacheTest::testEvictEntries()
+{
+    Cache cache{3, 100, std::chrono::seconds{10}};
+    cache.insert(1, u"one"_s, 1, m_now);
+    cache.insert(2, u"two"_s, 1, m_now);
+    cache.insert(3, u"three"_s, 1, m_now);
+
+    // makes 2 the least recently used entry
+    QVERIFY(!cache.object(1, m_now).isNull());
+
+    cache.insert(4, u"four"_s, 1, m_now);
+    QCOMPARE(cache.size(), qsizetype{3});
+    QVERIFY(cache.object(2, m_now).isNull());
+    QVERIFY(!cache.object(1, m_now).isNull());
+    QVERIFY(!cache.object(3, m_now).isNull());
+    QVERIFY(!cache.object(4, m_now).isNull());
+}
+
+void LocalCacheTest::testEvictCost()
+{
+    Cache cache{10, 100, std::chrono::seconds{10}};
+    cache.insert(1, u"one"_s, 40, m_now);
+    cache.insert(2, u"two"_s, 40, m_now);
+    cache.insert(3, u"three"_s, 40, m_now);
+
+    QCOMPARE(cache.size(), qsizetype{2});
+    QCOMPARE(cache.cost(), qint64{80});
+    QVERIFY(cache.object(1, m_now).isNull());
+
+    cache.insert(4, u"four"_s, 100, m_now);
+    QCOMPARE(cache.size(), qsizetype{1});
+    QCOMPARE(cache.object(4, m_now), u"four"_s);
+}
+
+void LocalCacheTest::testExpire()
+{
+    Cache cache{10, 100, std::chrono::seconds{10}};
+    cache.insert(1, u"one"_s, 10, m_now);
+    cache.insert(2, u"two"_s, 10, m_now + std::chrono::seconds{5});
+
+    QVERIFY(!cache.object(1, m_now + std::chrono::seconds{9}).isNull());
+    QVERIFY(cache.object(1, m_now + std::chrono::seconds{10}).isNull());
+    QVERIFY(!cache.object(2, m_now + std::chrono::seconds{10}).isNull());
+    QCOMPARE(cache.size(), qsizetype{1});
+    QCOMPARE(cache.cost(), qint64{10});
+}
+
+void LocalCacheTest::testDisabled()
+{
+    const Cache noEntries{0, 100, std::chrono::seconds{10}};
+    QVERIFY(!noEntries.isEnabled());
+    const Cache noMemory{10, 0, std::chrono::seconds{10}};
+    QVERIFY(!noMemory.isEnabled());
+
+    Cache noTtl{10, 100, std::chrono::seconds{0}};
+    QVERIFY(!noTtl.isEnabled());
+    noTtl.insert(1, u"one"_s, 1, m_now);
+    QVERIFY(noTtl.object(1, m_now).isNull());
+    QCOMPARE(noTtl.size(), qsizetype{0});
+}
+
+QTEST_MAIN(LocalCacheTest)
+
+#include "testlocalcache.moc"
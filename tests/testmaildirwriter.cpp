@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/maildirwriter.h"
+#include "objects/form.h"
+
+#include <QByteArrayList>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QUuid>
+
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+class MaildirWriterTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MaildirWriterTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~MaildirWriterTest() override = default;
+
+private slots:
+    void testSendMails();
+    void testNoPath();
+    void testPathForForm_data();
+    void testPathForForm();
+};
+
+void MaildirWriterTest::testSendMails()
+{
+    QTemporaryDir tmp;
+    QVERIFY(tmp.isValid());
+
+    const QString path = tmp.filePath(u"inbox"_s);
+    MaildirWriter writer{path};
+
+    QList<SmtpClient::Message> messages{
+        {"sender@example.com"_ba, "one@example.net"_ba, "Subject: One\r\n\r\nFirst message\r\n"_ba, {}},
+        {"sender@example.com"_ba, "two@example.net"_ba, "Subject: Two\r\n\r\nSecond message\r\n"_ba, {}}};
+    writer.sendMails(messages);
+
+    for (const SmtpClient::Message &message : std::as_const(messages)) {
+        QVERIFY2(message.sent, qUtf8Printable(message.error));
+        QVERIFY(message.error.isEmpty());
+    }
+
+    // all files have been moved from tmp into new
+    const QDir tmpDir{path + "/tmp"_L1};
+    QVERIFY(tmpDir.exists());
+    QVERIFY(tmpDir.isEmpty(QDir::Files | QDir::Hidden | QDir::System));
+    QVERIFY(QDir{path + "/cur"_L1}.exists());
+
+    const QDir newDir{path + "/new"_L1};
+    const QStringList files = newDir.entryList(QDir::Files, QDir::Name);
+    QCOMPARE(files.size(), qsizetype{2});
+
+    QByteArrayList contents;
+    for (const QString &file : files) {
+        QFile f{newDir.filePath(file)};
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        contents << f.readAll();
+    }
+    std::sort(contents.begin(), contents.end());
+
+    QCOMPARE(contents.at(0),
+             "Return-Path: <sender@example.com>\nDelivered-To: one@example.net\nSubject: One\n\nFirst message\n"_ba);
+    QCOMPARE(contents.at(1),
+             "Return-Path: <sender@example.com>\nDelivered-To: two@example.net\nSubject: Two\n\nSecond message\n"_ba);
+}
+
+void MaildirWriterTest::testNoPath()
+{
+    MaildirWriter writer{QString{}};
+
+    QList<SmtpClient::Message> messages{{"sender@example.com"_ba, "one@example.net"_ba, "Subject: One\r\n\r\n"_ba, {}}};
+    writer.sendMails(messages);
+
+    QVERIFY(!messages.at(0).sent);
+    QVERIFY(!messages.at(0).error.isEmpty());
+}
+
+void MaildirWriterTest::testPathForForm_data()
+{
+    QTest::addColumn<QString>("base");
+    QTest::addColumn<QString>("folder");
+    QTest::addColumn<QString>("subPath");
+
+    const QString base = u"/var/mail/botaskaf"_s;
+
+    QTest::newRow("folder") << base << u"inbox"_s << u"/inbox"_s;
+    QTest::newRow("dotted") << base << u"forms.contact"_s << u"/forms.contact"_s;
+    QTest::newRow("empty") << base << QString() << QString();
+    QTest::newRow("parent") << base << u"../x"_s << QString();
+    QTest::newRow("parent-only") << base << u".."_s << QString();
+    QTest::newRow("hidden") << base << u".hidden"_s << QString();
+    QTest::newRow("nested") << base << u"a/b"_s << QString();
+    QTest::newRow("no-base") << QString() << u"inbox"_s << QString();
+}
+
+void MaildirWriterTest::testPathForForm()
+{
+    QFETCH(QString, base);
+    QFETCH(QString, folder);
+    QFETCH(QString, subPath);
+
+    const QString uuid = QUuid::createUuid().toString(QUuid::Id128);
+    const Form f{1,
+                 u"Testform"_s,
+                 u"www.example.com"_s,
+                 {},
+                 uuid,
+                 QUuid::createUuid().toString(QUuid::Id128),
+                 {},
+                 QDateTime::currentDateTimeUtc(),
+                 {},
+                 {},
+                 {},
+                 {{u"mailer"_s, QVariantMap{{u"maildir"_s, QVariantMap{{u"folder"_s, folder}}}}}},
+                 0};
+
+    const QString expected = base.isEmpty() ? QString() : base + '/'_L1 + uuid + subPath;
+    QCOMPARE(MaildirWriter::pathForForm(base, f), expected);
+}
+
+QTEST_MAIN(MaildirWriterTest)
+
+#include "testmaildirwriter.moc"
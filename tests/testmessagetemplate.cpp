@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/messagetemplate.h"
+
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+
+class MessageTemplateTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessageTemplateTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~MessageTemplateTest() override = default;
+
+private slots:
+    void initTestCase();
+
+    void testRender_data();
+    void testRender();
+
+    void testHtmlEscape();
+
+private:
+    MessageTemplate::Values m_values;
+};
+
+void MessageTemplateTest::initTestCase()
+{
+    m_values[MessageTemplate::SenderName]  = u"Jane Doe"_s;
+    m_values[MessageTemplate::SenderEmail] = u"jane@example.net"_s;
+    m_values[MessageTemplate::SenderPhone] = u"+49 123 456789"_s;
+    m_values[MessageTemplate::SenderUrl]   = u"https://example.net"_s;
+    m_values[MessageTemplate::Subject]     = u"Hello"_s;
+    m_values[MessageTemplate::Content]     = u"Lorem ipsum\ndolor sit amet"_s;
+    m_values[MessageTemplate::FormName]    = u"Contact"_s;
+    m_values[MessageTemplate::FormDomain]  = u"www.example.com"_s;
+    m_values[MessageTemplate::Date]        = u"Thu, 01 Feb 2024 12:00:00 +0000"_s;
+}
+
+void MessageTemplateTest::testRender_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<QString>("expected");
+    QTest::addColumn<bool>("hasPlaceholders");
+
+    QTest::newRow("empty") << QString() << QString() << false;
+    QTest::newRow("literal-only") << u"Just some text"_s << u"Just some text"_s << false;
+    QTest::newRow("placeholder-only") << u"{{sender-email}}"_s << u"jane@example.net"_s << true;
+    QTest::newRow("start-middle-end") << u"{{subject}} from {{sender-name}} via {{form-name}}"_s
+                                      << u"Hello from Jane Doe via Contact"_s << true;
+    QTest::newRow("adjacent") << u"{{sender-name}}{{sender-email}}"_s << u"Jane Doejane@example.net"_s << true;
+    QTest::newRow("repeated") << u"{{subject}}/{{subject}}"_s << u"Hello/Hello"_s << true;
+    QTest::newRow("all") << u"{{sender-name}}|{{sender-email}}|{{sender-phone}}|{{sender-url}}|{{subject}}|{{content}}|"
+                            "{{form-name}}|{{form-domain}}|{{date}}"_s
+                         << u"Jane Doe|jane@example.net|+49 123 456789|https://example.net|Hello|Lorem ipsum\ndolor sit "
+                            "amet|Contact|www.example.com|Thu, 01 Feb 2024 12:00:00 +0000"_s
+                         << true;
+    QTest::newRow("unknown") << u"Hi {{foo}} {{subject}}"_s << u"Hi {{foo}} Hello"_s << true;
+    QTest::newRow("unterminated") << u"{{subject}} and {{subject"_s << u"Hello and {{subject"_s << true;
+    QTest::newRow("triple-braces") << u"{{{subject}}}"_s << u"{Hello}"_s << true;
+    QTest::newRow("non-latin") << u"Grüße {{sender-name}} – 👋"_s << u"Grüße Jane Doe – 👋"_s << true;
+}
+
+void MessageTemplateTest::testRender()
+{
+    QFETCH(QString, source);
+    QFETCH(QString, expected);
+    QFETCH(bool, hasPlaceholders);
+
+    const MessageTemplate t{source};
+    QCOMPARE(t.hasPlaceholders(), hasPlaceholders);
+    QCOMPARE(t.render(m_values), expected);
+}
+
+void MessageTemplateTest::testHtmlEscape()
+{
+    MessageTemplate::Values values = m_values;
+
+    values[MessageTemplate::SenderName] = u"Jane & \"John\" O'Doe"_s;
+    values[MessageTemplate::Content]    = u"Click <a href=\"https://evil.example\">here</a>"_s;
+
+    const MessageTemplate t{u"<p title=\"{{sender-name}}\">{{content}}</p>"_s};
+    QCOMPARE(t.render(values, MessageTemplate::HtmlEscape),
+             u"<p title=\"Jane &amp; &quot;John&quot; O&#39;Doe\">Click &lt;a href=&quot;https://evil.example&quot;&gt;here"
+             "&lt;/a&gt;</p>"_s);
+
+    // plain text templates keep the values unchanged
+    QCOMPARE(t.render(values), u"<p title=\"Jane & \"John\" O'Doe\">Click <a href=\"https://evil.example\">here</a></p>"_s);
+
+    // templates without placeholders are returned as they are
+    const MessageTemplate literal{u"<b>Hello</b>"_s};
+    QCOMPARE(literal.render(values, MessageTemplate::HtmlEscape), u"<b>Hello</b>"_s);
+}
+
+QTEST_MAIN(MessageTemplateTest)
+
+#include "testmessagetemplate.moc"
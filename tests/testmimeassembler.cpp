@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/mimeassembler.h"
+
+#include <QRegularExpression>
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+
+class MimeAssemblerTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MimeAssemblerTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~MimeAssemblerTest() override = default;
+
+private slots:
+    void testQuotedPrintable_data();
+    void testQuotedPrintable();
+    void testQuotedPrintableLineLength();
+    void testEncodeWord();
+    void testEncodeWordFolding();
+    void testAddress();
+    void testSharedBodies();
+    void testAssemble();
+};
+
+void MimeAssemblerTest::testQuotedPrintable_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<QByteArray>("expected");
+
+    QTest::newRow("plain") << "Hello World"_ba << "Hello World"_ba;
+    QTest::newRow("equals") << "a=b"_ba << "a=3Db"_ba;
+    QTest::newRow("utf8") << u"Grüße"_s.toUtf8() << "Gr=C3=BC=C3=9Fe"_ba;
+    QTest::newRow("lf") << "a\nb"_ba << "a\r\nb"_ba;
+    QTest::newRow("crlf") << "a\r\nb"_ba << "a\r\nb"_ba;
+    QTest::newRow("lone-cr") << "a\rb"_ba << "a=0Db"_ba;
+    QTest::newRow("trailing-space") << "a \nb\t"_ba << "a=20\r\nb=09"_ba;
+}
+
+void MimeAssemblerTest::testQuotedPrintable()
+{
+    QFETCH(QByteArray, input);
+    QFETCH(QByteArray, expected);
+
+    QCOMPARE(MimeAssembler::quotedPrintable(input), expected);
+}
+
+void MimeAssemblerTest::testQuotedPrintableLineLength()
+{
+    const QByteArray input = QByteArray(100, 'a') + u"ä"_s.toUtf8().repeated(40);
+    const QByteArray qp    = MimeAssembler::quotedPrintable(input);
+
+    const auto lines = qp.split('\n');
+    for (const QByteArray &line : lines) {
+        QVERIFY2(line.chopped(line.endsWith('\r') ? 1 : 0).size() <= 76, line.constData());
+    }
+
+    QCOMPARE(lines.first(), QByteArray(75, 'a') + "=\r"_ba);
+
+    // removing the soft line breaks restores the encoded input
+    QByteArray joined = qp;
+    joined.replace("=\r\n"_ba, QByteArray{});
+    QCOMPARE(joined, QByteArray(100, 'a') + "=C3=A4"_ba.repeated(40));
+}
+
+void MimeAssemblerTest::testEncodeWord()
+{
+    QCOMPARE(MimeAssembler::encodeWord(u"Hello World"_s), "Hello World"_ba);
+    QCOMPARE(MimeAssembler::encodeWord(u"Grüße"_s), "=?utf-8?B?"_ba + u"Grüße"_s.toUtf8().toBase64() + "?="_ba);
+    // text that looks like an encoded word has to be encoded itself
+    QVERIFY(MimeAssembler::encodeWord(u"=?utf-8?B?abc?="_s).startsWith("=?utf-8?B?PT91"_ba));
+}
+
+void MimeAssemblerTest::testEncodeWordFolding()
+{
+    const QString text     = u"Ünïcödé "_s.repeated(20);
+    const QByteArray words = MimeAssembler::encodeWord(text);
+
+    const auto lines = words.split('\n');
+    QVERIFY(lines.size() > 1);
+
+    QByteArray decoded;
+    for (QByteArray line : lines) {
+        line = line.trimmed();
+        QVERIFY(line.size() <= 75);
+        QVERIFY(line.startsWith("=?utf-8?B?"_ba));
+        QVERIFY(line.endsWith("?="_ba));
+
+        // every encoded word has to contain complete characters
+        const QByteArray chunk = QByteArray::fromBase64(line.mid(10).chopped(2));
+        QCOMPARE(QString::fromUtf8(chunk).toUtf8(), chunk);
+        decoded += chunk;
+    }
+    QCOMPARE(QString::fromUtf8(decoded), text);
+}
+
+void MimeAssemblerTest::testAddress()
+{
+    MimeAssembler mime;
+
+    QCOMPARE(mime.address({}, u"rcpt@example.com"_s), "rcpt@example.com"_ba);
+    QCOMPARE(mime.address(u"John Doe"_s, u"rcpt@example.com"_s), "\"John Doe\" <rcpt@example.com>"_ba);
+    QCOMPARE(mime.address(u"John \"JD\" Doe"_s, u"rcpt@example.com"_s),
+             "\"John \\\"JD\\\" Doe\" <rcpt@example.com>"_ba);
+    QCOMPARE(mime.address(u"Jürgen"_s, u"rcpt@example.com"_s),
+             "=?utf-8?B?"_ba + u"Jürgen"_s.toUtf8().toBase64() + "?= <rcpt@example.com>"_ba);
+
+    // cached addresses are shared, not encoded again
+    const QByteArray first  = mime.address(u"Jürgen"_s, u"rcpt@example.com"_s);
+    const QByteArray second = mime.address(u"Jürgen"_s, u"rcpt@example.com"_s);
+    QVERIFY(second.constData() == first.constData());
+}
+
+void MimeAssemblerTest::testSharedBodies()
+{
+    MimeAssembler mime;
+
+    const QByteArray first  = mime.body(u"Text"_s, u"<p>HTML</p>"_s);
+    const QByteArray second = mime.body(u"Text"_s, u"<p>HTML</p>"_s);
+    QCOMPARE(mime.bodyCount(), qsizetype{1});
+    QVERIFY(second.constData() == first.constData());
+
+    QVERIFY(first.startsWith("Content-Type: multipart/alternative; boundary="_ba));
+    QVERIFY(first.contains("Content-Type: text/plain; charset=utf-8\r\n"_ba));
+    QVERIFY(first.contains("Content-Type: text/html; charset=utf-8\r\n"_ba));
+
+    const QByteArray textOnly = mime.body(u"Text"_s, {});
+    QCOMPARE(mime.bodyCount(), qsizetype{2});
+    QCOMPARE(textOnly,
+             "Content-Type: text/plain; charset=utf-8\r\nContent-Transfer-Encoding: quoted-printable\r\n\r\nText"_ba);
+
+    mime.clearBodies();
+    QCOMPARE(mime.bodyCount(), qsizetype{0});
+}
+
+void MimeAssemblerTest::testAssemble()
+{
+    MimeAssembler mime;
+
+    const QByteArray from = mime.address(u"Form"_s, u"form@example.com"_s);
+    const QByteArray to   = mime.address(u"Recipient"_s, u"rcpt@example.com"_s);
+    const QByteArray body = mime.body(u"Text"_s, {});
+
+    const QByteArray messageId = MimeAssembler::messageId(u"form@example.com"_s);
+    QVERIFY(QRegularExpression{u"^<[0-9a-f-]{36}@example\\.com>$"_s}.match(QString::fromLatin1(messageId)).hasMatch());
+    QVERIFY(messageId != MimeAssembler::messageId(u"form@example.com"_s));
+    QVERIFY(MimeAssembler::messageId(u"form@bücher.example"_s).endsWith("@xn--bcher-kva.example>"_ba));
+
+    const QByteArray message = MimeAssembler::assemble(from, to, {}, u"Subject"_s, messageId, body);
+    QVERIFY(message.startsWith(
+        "From: \"Form\" <form@example.com>\r\nTo: \"Recipient\" <rcpt@example.com>\r\nSubject: Subject\r\nDate: "_ba));
+    QVERIFY(message.contains("\r\nMessage-ID: "_ba + messageId + "\r\nMIME-Version: 1.0\r\n"_ba));
+    QVERIFY(message.endsWith(body));
+    QVERIFY(!message.contains("Reply-To:"_ba));
+
+    const QByteArray replyTo     = mime.address({}, u"sender@example.org"_s);
+    const QByteArray withReplyTo = MimeAssembler::assemble(from, to, replyTo, u"Subject"_s, messageId, body);
+    QVERIFY(withReplyTo.contains("\r\nReply-To: sender@example.org\r\n"_ba));
+}
+
+QTEST_MAIN(MimeAssemblerTest)
+
+#include "testmimeassembler.moc"
@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/proofofwork.h"
+
+#include <QTest>
+#include <QUuid>
+
+class ProofOfWorkTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProofOfWorkTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~ProofOfWorkTest() override = default;
+
+private slots:
+    void testDifficulty_data();
+    void testDifficulty();
+
+    void testRate();
+};
+
+void ProofOfWorkTest::testDifficulty_data()
+{
+    QTest::addColumn<double>("rate");
+    QTest::addColumn<int>("difficulty");
+
+    QTest::newRow("idle") << 0.0 << ProofOfWork::minDifficulty;
+    QTest::newRow("base") << ProofOfWork::baseRate << ProofOfWork::minDifficulty;
+    QTest::newRow("above-base") << ProofOfWork::baseRate * 1.5 << ProofOfWork::minDifficulty + 1;
+    QTest::newRow("double") << ProofOfWork::baseRate * 2 << ProofOfWork::minDifficulty + 2;
+    QTest::newRow("quadruple") << ProofOfWork::baseRate * 4 << ProofOfWork::minDifficulty + 3;
+    QTest::newRow("flood") << ProofOfWork::baseRate * 1'000'000 << ProofOfWork::maxDifficulty;
+}
+
+void ProofOfWorkTest::testDifficulty()
+{
+    QFETCH(double, rate);
+    QFETCH(int, difficulty);
+
+    QCOMPARE(ProofOfWork::difficulty(rate), difficulty);
+}
+
+void ProofOfWorkTest::testRate()
+{
+    const QString uuid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    QCOMPARE(ProofOfWork::rate(uuid), 0.0);
+    QCOMPARE(ProofOfWork::difficulty(uuid), ProofOfWork::minDifficulty);
+
+    const int count = static_cast<int>(ProofOfWork::baseRate) * 8;
+    for (int i = 0; i < count; ++i) {
+        ProofOfWork::recordSubmission(uuid);
+    }
+
+    // a minute change during the loop moves counts to the weighted previous minute
+    QVERIFY(ProofOfWork::rate(uuid) > 0.0);
+    QVERIFY(ProofOfWork::rate(uuid) <= count);
+    QVERIFY(ProofOfWork::difficulty(uuid) > ProofOfWork::minDifficulty);
+
+    const QString other = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    QCOMPARE(ProofOfWork::rate(other), 0.0);
+}
+
+QTEST_MAIN(ProofOfWorkTest)
+
+#include "testproofofwork.moc"
@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/replaycache.h"
+
+#include <QTest>
+
+#include <cstring>
+
+class ReplayCacheTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplayCacheTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~ReplayCacheTest() override = default;
+
+private slots:
+    void testInsert();
+    void testRemove();
+    void testExpiredBucket();
+    void testFullBucket();
+    void testDisabled();
+
+private:
+    // nonce with the value of \a high in the bytes that select shard and slot
+    [[nodiscard]] static FormToken::Nonce createNonce(quint64 high, quint32 low = 0);
+
+    const qint64 m_now{QDateTime::currentMSecsSinceEpoch()};
+};
+
+FormToken::Nonce ReplayCacheTest::createNonce(quint64 high, quint32 low)
+{
+    FormToken::Nonce nonce{};
+    std::memcpy(nonce.data(), &high, sizeof(high));
+    std::memcpy(nonce.data() + sizeof(high), &low, sizeof(low));
+    return nonce;
+}
+
+void ReplayCacheTest::testInsert()
+{
+    ReplaySet set{1024};
+
+    QVERIFY(set.insert(createNonce(1), m_now));
+    QVERIFY(!set.insert(createNonce(1), m_now));
+
+    // same slot, different nonce
+    QVERIFY(set.insert(createNonce(1, 1), m_now));
+    QVERIFY(!set.insert(createNonce(1, 1), m_now));
+
+    QVERIFY(set.insert(createNonce(2), m_now - 1));
+    QVERIFY(set.insert(createNonce(3), m_now - FormToken::maxAge.count()));
+}
+
+void ReplayCacheTest::testRemove()
+{
+    ReplaySet set{1024};
+
+    QVERIFY(set.insert(createNonce(1), m_now));
+    QVERIFY(set.insert(createNonce(1, 1), m_now));
+
+    set.remove(createNonce(1), m_now);
+    QVERIFY(set.insert(createNonce(1), m_now));
+    QVERIFY(!set.insert(createNonce(1), m_now));
+
+    // the nonce behind the released one in the same slot is still found
+    set.remove(createNonce(1), m_now);
+    QVERIFY(!set.insert(createNonce(1, 1), m_now));
+
+    // unknown nonces and other buckets are not affected
+    set.remove(createNonce(2), m_now);
+    set.remove(createNonce(1, 1), m_now - FormToken::maxAge.count());
+    QVERIFY(!set.insert(createNonce(1, 1), m_now));
+    QVERIFY(set.insert(createNonce(2), m_now));
+}
+
+void ReplayCacheTest::testExpiredBucket()
+{
+    ReplaySet set{1024};
+
+    // all nonces are in the same shard
+    const qint64 old = m_now - 2 * FormToken::maxAge.count();
+    QVERIFY(set.insert(createNonce(16), old));
+
+    // reuses and clears the bucket of the old token
+    const qint64 hour = FormToken::maxAge.count() / 6;
+    QVERIFY(set.insert(createNonce(32), old + 8 * hour));
+
+    // the bucket now belongs to newer tokens
+    QVERIFY(!set.insert(createNonce(48), old));
+    QVERIFY(!set.insert(createNonce(16), old));
+    QVERIFY(!set.insert(createNonce(32), old + 8 * hour));
+    QVERIFY(set.insert(createNonce(16), old + 8 * hour));
+}
+
+void ReplayCacheTest::testFullBucket()
+{
+    // the smallest bucket has 16 entries and is full at 12
+    ReplaySet set{1};
+
+    for (quint64 i = 0; i < 12; ++i) {
+        QVERIFY(set.insert(createNonce(i * 16), m_now));
+    }
+
+    // not stored, but not rejected either
+    QVERIFY(set.insert(createNonce(12 * 16), m_now));
+    QVERIFY(set.insert(createNonce(12 * 16), m_now));
+
+    QVERIFY(!set.insert(createNonce(0), m_now));
+
+    // other shards are not affected
+    QVERIFY(set.insert(createNonce(1), m_now));
+    QVERIFY(!set.insert(createNonce(1), m_now));
+}
+
+void ReplayCacheTest::testDisabled()
+{
+    ReplaySet set{0};
+
+    QVERIFY(set.insert(createNonce(1), m_now));
+    QVERIFY(set.insert(createNonce(1), m_now));
+}
+
+QTEST_MAIN(ReplayCacheTest)
+
+#include "testreplaycache.moc"
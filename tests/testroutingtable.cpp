@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/routingtable.h"
+
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+
+class RoutingTableTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RoutingTableTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~RoutingTableTest() override = default;
+
+private slots:
+    void initTestCase();
+
+    void testExcluded_data();
+    void testExcluded();
+
+    void testInvalidRules();
+
+private:
+    [[nodiscard]] static QVariantMap rule(quint32 recipient, const QString &field, const QString &op, const QString &value);
+
+    MessageTemplate::Values m_values;
+};
+
+void RoutingTableTest::initTestCase()
+{
+    m_values[MessageTemplate::SenderName]  = u"Jane Doe"_s;
+    m_values[MessageTemplate::SenderEmail] = u"jane@example.net"_s;
+    m_values[MessageTemplate::Subject]     = u"Question about INVOICE 1234"_s;
+    m_values[MessageTemplate::Content]     = u"Lorem ipsum dolor sit amet"_s;
+}
+
+QVariantMap RoutingTableTest::rule(quint32 recipient, const QString &field, const QString &op, const QString &value)
+{
+    return {{u"recipient"_s, recipient}, {u"field"_s, field}, {u"operator"_s, op}, {u"value"_s, value}};
+}
+
+void RoutingTableTest::testExcluded_data()
+{
+    QTest::addColumn<QVariantList>("rules");
+    QTest::addColumn<QList<quint32>>("expected");
+
+    QTest::newRow("no-rules") << QVariantList() << QList<quint32>();
+    QTest::newRow("contains-match") << QVariantList{rule(1, u"subject"_s, u"contains"_s, u"invoice"_s)}
+                                    << QList<quint32>();
+    QTest::newRow("contains-nomatch") << QVariantList{rule(1, u"subject"_s, u"contains"_s, u"support"_s)}
+                                      << QList<quint32>{1};
+    QTest::newRow("equals-case") << QVariantList{rule(1, u"sender-name"_s, u"equals"_s, u"JANE DOE"_s)}
+                                 << QList<quint32>();
+    QTest::newRow("equals-partial") << QVariantList{rule(1, u"sender-name"_s, u"equals"_s, u"Jane"_s)}
+                                    << QList<quint32>{1};
+    QTest::newRow("startswith") << QVariantList{rule(1, u"content"_s, u"startsWith"_s, u"lorem"_s),
+                                                rule(2, u"content"_s, u"startsWith"_s, u"ipsum"_s)}
+                                << QList<quint32>{2};
+    QTest::newRow("endswith") << QVariantList{rule(1, u"sender-email"_s, u"endsWith"_s, u"@example.net"_s),
+                                              rule(2, u"sender-email"_s, u"endsWith"_s, u"@example.com"_s)}
+                              << QList<quint32>{2};
+    QTest::newRow("any-rule-of-recipient") << QVariantList{rule(1, u"subject"_s, u"contains"_s, u"support"_s),
+                                                           rule(1, u"sender-email"_s, u"endsWith"_s, u"example.net"_s)}
+                                           << QList<quint32>();
+    QTest::newRow("several-recipients") << QVariantList{rule(1, u"subject"_s, u"contains"_s, u"invoice"_s),
+                                                        rule(2, u"subject"_s, u"contains"_s, u"support"_s),
+                                                        rule(3, u"sender-phone"_s, u"equals"_s, u"123"_s)}
+                                        << QList<quint32>{2, 3};
+}
+
+void RoutingTableTest::testExcluded()
+{
+    QFETCH(QVariantList, rules);
+    QFETCH(QList<quint32>, expected);
+
+    const RoutingTable table{rules};
+    QCOMPARE(table.size(), rules.size());
+    QCOMPARE(table.excluded(m_values), expected);
+}
+
+void RoutingTableTest::testInvalidRules()
+{
+    const RoutingTable table{QVariantList{rule(0, u"subject"_s, u"contains"_s, u"invoice"_s),
+                                          rule(1, u"form-name"_s, u"contains"_s, u"invoice"_s),
+                                          rule(1, u"foo"_s, u"contains"_s, u"invoice"_s),
+                                          rule(1, u"subject"_s, u"matches"_s, u"invoice"_s),
+                                          rule(1, u"subject"_s, u"contains"_s, QString()),
+                                          QVariant{u"subject"_s}}};
+
+    QVERIFY(table.isEmpty());
+    QCOMPARE(table.size(), qsizetype{0});
+    QVERIFY(table.excluded(m_values).empty());
+}
+
+QTEST_MAIN(RoutingTableTest)
+
+#include "testroutingtable.moc"
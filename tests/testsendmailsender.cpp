@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/sendmailsender.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+
+class SendmailSenderTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SendmailSenderTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~SendmailSenderTest() override = default;
+
+private slots:
+    void initTestCase();
+
+    void testSend();
+    void testFailure();
+    void testNoProgram();
+
+private:
+    // writes an executable shell script with \a body to the temporary directory and returns its path
+    [[nodiscard]] QString createStub(const QString &name, const QByteArray &body) const;
+
+    QTemporaryDir m_tmp;
+};
+
+void SendmailSenderTest::initTestCase()
+{
+    QVERIFY(m_tmp.isValid());
+    if (!QFile::exists(u"/bin/sh"_s)) {
+        QSKIP("/bin/sh is not available");
+    }
+}
+
+QString SendmailSenderTest::createStub(const QString &name, const QByteArray &body) const
+{
+    const QString path = m_tmp.filePath(name);
+    QFile f{path};
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return {};
+    }
+    f.write("#!/bin/sh\n"_ba + body);
+    f.close();
+    f.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    return path;
+}
+
+void SendmailSenderTest::testSend()
+{
+    const QByteArray argsFile = QFile::encodeName(m_tmp.filePath(u"args"_s));
+    const QByteArray dataFile = QFile::encodeName(m_tmp.filePath(u"data"_s));
+    const QString program =
+        createStub(u"sendmail"_s, "printf '%s\\n' \"$@\" > '"_ba + argsFile + "'\ncat > '"_ba + dataFile + "'\n"_ba);
+    QVERIFY(!program.isEmpty());
+
+    SendmailSender sender{program};
+    QList<SmtpClient::Message> messages{
+        {"sender@example.com"_ba, "-oQ@example.net"_ba, "Subject: Test\r\n\r\nHello\r\n.\r\n"_ba, {}}};
+    sender.sendMails(messages);
+
+    QVERIFY2(messages.at(0).sent, qUtf8Printable(messages.at(0).error));
+    QVERIFY(messages.at(0).error.isEmpty());
+
+    // the recipient comes after --, so it can not be taken as an option
+    QFile args{QFile::decodeName(argsFile)};
+    QVERIFY(args.open(QIODevice::ReadOnly));
+    QCOMPARE(args.readAll(), "-i\n-f\nsender@example.com\n--\n-oQ@example.net\n"_ba);
+
+    QFile data{QFile::decodeName(dataFile)};
+    QVERIFY(data.open(QIODevice::ReadOnly));
+    QCOMPARE(data.readAll(), "Subject: Test\n\nHello\n.\n"_ba);
+}
+
+void SendmailSenderTest::testFailure()
+{
+    const QString program = createStub(u"failing"_s, "cat > /dev/null\necho 'unknown user' >&2\nexit 67\n"_ba);
+    QVERIFY(!program.isEmpty());
+
+    SendmailSender sender{program};
+    QList<SmtpClient::Message> messages{
+        {"sender@example.com"_ba, "nobody@example.net"_ba, "Subject: Test\r\n\r\nHello\r\n"_ba, {}}};
+    sender.sendMails(messages);
+
+    QVERIFY(!messages.at(0).sent);
+    QVERIFY(messages.at(0).error.contains("67"_L1));
+    QVERIFY(messages.at(0).error.contains("unknown user"_L1));
+}
+
+void SendmailSenderTest::testNoProgram()
+{
+    QList<SmtpClient::Message> messages{
+        {"sender@example.com"_ba, "nobody@example.net"_ba, "Subject: Test\r\n\r\nHello\r\n"_ba, {}}};
+
+    SendmailSender unset{QString{}};
+    unset.sendMails(messages);
+    QVERIFY(!messages.at(0).sent);
+    QVERIFY(!messages.at(0).error.isEmpty());
+
+    messages[0].error.clear();
+    SendmailSender missing{m_tmp.filePath(u"does-not-exist"_s)};
+    missing.sendMails(messages);
+    QVERIFY(!messages.at(0).sent);
+    QVERIFY(!messages.at(0).error.isEmpty());
+}
+
+QTEST_MAIN(SendmailSenderTest)
+
+#include "testsendmailsender.moc"
@@ -0,0 +1,227 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/smtpclient.h"
+#include "delivery/smtppool.h"
+#include "smtpsink.h"
+
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+using namespace std::chrono_literals;
+
+class SmtpClientTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SmtpClientTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~SmtpClientTest() override = default;
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void testSend_data();
+    void testSend();
+    void testDotStuffing();
+    void testInjectedFailure();
+    void testRejectedRecipient_data();
+    void testRejectedRecipient();
+    void testAuthentication();
+    void testPool();
+
+private:
+    [[nodiscard]] SmtpClient::Config config() const;
+    [[nodiscard]] static QList<SmtpClient::Message> createMessages(int count);
+
+    SmtpSink m_sink;
+};
+
+void SmtpClientTest::initTestCase()
+{
+    QVERIFY(m_sink.start());
+}
+
+void SmtpClientTest::init()
+{
+    m_sink.clear();
+    m_sink.setPipelining(true);
+    m_sink.setLatency(0ms);
+    m_sink.setFailEvery(0);
+    m_sink.setRejectedRecipient({});
+}
+
+SmtpClient::Config SmtpClientTest::config() const
+{
+    SmtpClient::Config c;
+    c.host = u"127.0.0.1"_s;
+    c.port = m_sink.port();
+    return c;
+}
+
+QList<SmtpClient::Message> SmtpClientTest::createMessages(int count)
+{
+    QList<SmtpClient::Message> messages;
+    for (int i = 0; i < count; ++i) {
+        SmtpClient::Message m;
+        m.from = "sender@example.com"_ba;
+        m.to   = "rcpt" + QByteArray::number(i) + "@example.net"_ba;
+        m.data = "Subject: Test " + QByteArray::number(i) + "\r\n\r\nHello\r\n"_ba;
+        messages << m;
+    }
+    return messages;
+}
+
+void SmtpClientTest::testSend_data()
+{
+    QTest::addColumn<bool>("pipelining");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("single") << false << 1;
+    QTest::newRow("multiple") << false << 5;
+    QTest::newRow("single-pipelining") << true << 1;
+    QTest::newRow("multiple-pipelining") << true << 5;
+}
+
+void SmtpClientTest::testSend()
+{
+    QFETCH(bool, pipelining);
+    QFETCH(int, count);
+
+    m_sink.setPipelining(pipelining);
+
+    SmtpClient client{config()};
+    QVERIFY2(client.connectToServer(), qUtf8Printable(client.lastError()));
+
+    auto messages = createMessages(count);
+    client.sendMails(messages);
+
+    for (const auto &m : std::as_const(messages)) {
+        QVERIFY2(m.sent, qUtf8Printable(m.error));
+    }
+
+    client.quit();
+
+    const auto received = m_sink.messages();
+    QCOMPARE(received.size(), qsizetype{count});
+    for (qsizetype i = 0; i < received.size(); ++i) {
+        QCOMPARE(received.at(i).from, messages.at(i).from);
+        QCOMPARE(received.at(i).to, QByteArrayList{messages.at(i).to});
+        QCOMPARE(received.at(i).data, messages.at(i).data);
+    }
+    QCOMPARE(m_sink.connections(), 1);
+}
+
+void SmtpClientTest::testDotStuffing()
+{
+    SmtpClient client{config()};
+    QVERIFY(client.connectToServer());
+
+    QList<SmtpClient::Message> messages = createMessages(1);
+    messages.first().data = ".first\r\n\r\n.\r\n..two\r\nlast"_ba;
+    client.sendMails(messages);
+    QVERIFY(messages.first().sent);
+
+    const auto received = m_sink.messages();
+    QCOMPARE(received.size(), qsizetype{1});
+    QCOMPARE(received.first().data, ".first\r\n\r\n.\r\n..two\r\nlast\r\n"_ba);
+}
+
+void SmtpClientTest::testInjectedFailure()
+{
+    m_sink.setFailEvery(2);
+
+    SmtpClient client{config()};
+    QVERIFY(client.connectToServer());
+
+    auto messages = createMessages(4);
+    client.sendMails(messages);
+
+    QVERIFY(messages.at(0).sent);
+    QVERIFY(!messages.at(1).sent);
+    QVERIFY(messages.at(1).error.contains("451"_L1));
+    // temporary failures are retried later
+    QVERIFY(!messages.at(1).rejected);
+    QVERIFY(messages.at(2).sent);
+    QVERIFY(!messages.at(3).sent);
+
+    // the session stays usable after a failed transaction
+    QVERIFY(client.isConnected());
+    QCOMPARE(m_sink.messageCount(), qsizetype{2});
+}
+
+void SmtpClientTest::testRejectedRecipient_data()
+{
+    QTest::addColumn<bool>("pipelining");
+
+    QTest::newRow("sequential") << false;
+    QTest::newRow("pipelining") << true;
+}
+
+void SmtpClientTest::testRejectedRecipient()
+{
+    QFETCH(bool, pipelining);
+
+    m_sink.setPipelining(pipelining);
+    m_sink.setRejectedRecipient("rcpt1@example.net"_ba);
+
+    SmtpClient client{config()};
+    QVERIFY(client.connectToServer());
+
+    auto messages = createMessages(3);
+    client.sendMails(messages);
+
+    QVERIFY(messages.at(0).sent);
+    QVERIFY(!messages.at(1).sent);
+    QVERIFY(messages.at(1).error.contains("550"_L1));
+    QVERIFY(messages.at(1).rejected);
+    QVERIFY(messages.at(2).sent);
+    QVERIFY(!messages.at(0).rejected);
+    QVERIFY(!messages.at(2).rejected);
+
+    const auto received = m_sink.messages();
+    QCOMPARE(received.size(), qsizetype{2});
+    QCOMPARE(received.at(1).to, QByteArrayList{"rcpt2@example.net"_ba});
+}
+
+void SmtpClientTest::testAuthentication()
+{
+    for (const auto auth : {SmtpClient::Authentication::Plain, SmtpClient::Authentication::Login}) {
+        auto c           = config();
+        c.user           = u"user"_s;
+        c.password       = u"secret"_s;
+        c.authentication = auth;
+
+        SmtpClient client{c};
+        QVERIFY2(client.connectToServer(), qUtf8Printable(client.lastError()));
+    }
+}
+
+void SmtpClientTest::testPool()
+{
+    SmtpPool pool{2, 60s};
+
+    for (int i = 0; i < 3; ++i) {
+        QString error;
+        auto client = pool.acquire(config(), error);
+        QVERIFY2(client, qUtf8Printable(error));
+
+        auto messages = createMessages(1);
+        client->sendMails(messages);
+        QVERIFY(messages.first().sent);
+
+        pool.release(std::move(client));
+    }
+
+    QCOMPARE(m_sink.messageCount(), qsizetype{3});
+    QCOMPARE(m_sink.connections(), 1);
+}
+
+QTEST_MAIN(SmtpClientTest)
+
+#include "testsmtpclient.moc"
@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/suppressionlist.h"
+#include "objects/suppression.h"
+
+#include <QTest>
+
+using namespace Qt::Literals::StringLiterals;
+
+class SuppressionListTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SuppressionListTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~SuppressionListTest() override = default;
+
+private slots:
+    void testNormalize_data();
+    void testNormalize();
+    void testContains();
+    void testRemove();
+};
+
+void SuppressionListTest::testNormalize_data()
+{
+    QTest::addColumn<QString>("email");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("lower") << u"rcpt@example.com"_s << u"rcpt@example.com"_s;
+    QTest::newRow("upper") << u"Rcpt@Example.COM"_s << u"rcpt@example.com"_s;
+    QTest::newRow("whitespace") << u"  rcpt@example.com\t"_s << u"rcpt@example.com"_s;
+}
+
+void SuppressionListTest::testNormalize()
+{
+    QFETCH(QString, email);
+    QFETCH(QString, expected);
+
+    QCOMPARE(Suppression::normalize(email), expected);
+}
+
+void SuppressionListTest::testContains()
+{
+    SuppressionList list;
+    QVERIFY(!list.contains(1, u"rcpt@example.com"_s));
+
+    list.insert(1, u"Rcpt@Example.com"_s);
+    QVERIFY(list.contains(1, u"rcpt@example.com"_s));
+    QVERIFY(list.contains(1, u"RCPT@EXAMPLE.COM"_s));
+
+    // suppressions are per form
+    QVERIFY(!list.contains(2, u"rcpt@example.com"_s));
+
+    list.insert(1, u"rcpt@example.com"_s);
+    QCOMPARE(list.size(), qsizetype{1});
+}
+
+void SuppressionListTest::testRemove()
+{
+    SuppressionList list;
+    list.insert(1, u"rcpt@example.com"_s);
+    list.insert(2, u"rcpt@example.com"_s);
+
+    list.remove(1, u"RCPT@example.com"_s);
+    QVERIFY(!list.contains(1, u"rcpt@example.com"_s));
+    QVERIFY(list.contains(2, u"rcpt@example.com"_s));
+    QCOMPARE(list.size(), qsizetype{1});
+}
+
+QTEST_MAIN(SuppressionListTest)
+
+#include "testsuppressionlist.moc"
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/timerwheel.h"
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <map>
+
+using namespace std::chrono_literals;
+
+class TimerWheelTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TimerWheelTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~TimerWheelTest() override = default;
+
+private slots:
+    void testDueImmediately();
+    void testOrder();
+    void testOutOfRange();
+    void testRandom();
+};
+
+void TimerWheelTest::testDueImmediately()
+{
+    const auto start = TimerWheel::clock::now();
+    TimerWheel w{1s, start};
+
+    w.schedule(1, start - 10s);
+    w.schedule(2, start);
+    QCOMPARE(w.size(), qsizetype{2});
+
+    const auto expired = w.advance(start);
+    QCOMPARE(expired.size(), qsizetype{2});
+    QVERIFY(w.isEmpty());
+}
+
+void TimerWheelTest::testOrder()
+{
+    const auto start = TimerWheel::clock::now();
+    TimerWheel w{1s, start};
+
+    w.schedule(1, start + 5s);
+    w.schedule(2, start + 70s);
+    w.schedule(3, start + 2h);
+
+    QVERIFY(w.advance(start + 4s).empty());
+    QCOMPARE(w.advance(start + 5s), QList<TimerWheel::timer_id>{1});
+    QVERIFY(w.advance(start + 69s).empty());
+    QCOMPARE(w.advance(start + 70s), QList<TimerWheel::timer_id>{2});
+    QVERIFY(w.advance(start + 2h - 1s).empty());
+    QCOMPARE(w.advance(start + 2h), QList<TimerWheel::timer_id>{3});
+    QVERIFY(w.isEmpty());
+}
+
+void TimerWheelTest::testOutOfRange()
+{
+    const auto start = TimerWheel::clock::now();
+    TimerWheel w{1s, start};
+
+    const auto due = start + std::chrono::days{300};
+    w.schedule(1, due);
+
+    QVERIFY(w.advance(due - 1s).empty());
+    QCOMPARE(w.advance(due), QList<TimerWheel::timer_id>{1});
+}
+
+void TimerWheelTest::testRandom()
+{
+    const auto start = TimerWheel::clock::now();
+    TimerWheel w{1s, start};
+
+    std::map<TimerWheel::timer_id, std::chrono::seconds> dues;
+    for (TimerWheel::timer_id id = 1; id <= 20'000; ++id) {
+        const std::chrono::seconds due{QRandomGenerator::global()->bounded(7 * 24 * 60 * 60)};
+        dues.emplace(id, due);
+        w.schedule(id, start + due);
+    }
+
+    std::chrono::seconds now{0};
+    qsizetype expiredCount = 0;
+    while (!w.isEmpty()) {
+        now += std::chrono::seconds{QRandomGenerator::global()->bounded(1, 120)};
+        const auto expired = w.advance(start + now);
+        for (const TimerWheel::timer_id id : expired) {
+            const auto due = dues.at(id);
+            // never early, and not later than the last advance step
+            QVERIFY(due <= now);
+            QVERIFY(now - due < 120s);
+        }
+        expiredCount += expired.size();
+    }
+
+    QCOMPARE(expiredCount, qsizetype{20'000});
+}
+
+QTEST_MAIN(TimerWheelTest)
+
+#include "testtimerwheel.moc"
@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "objects/form.h"
+#include "objects/tokenpool.h"
+
+#include <QSet>
+#include <QTest>
+#include <QUuid>
+
+using namespace Qt::Literals::StringLiterals;
+
+class TokenPoolTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TokenPoolTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~TokenPoolTest() override = default;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testNullForm();
+    void testTake();
+    void testTakeAfterIdle();
+    void testUpdatedForm();
+
+private:
+    [[nodiscard]] static Form createForm(const QString &uuid, const QDateTime &updated);
+};
+
+Form TokenPoolTest::createForm(const QString &uuid, const QDateTime &updated)
+{
+    return Form{1,
+                u"Testform"_s,
+                u"www.example.com"_s,
+                {},
+                uuid,
+                QUuid::createUuid().toString(QUuid::Id128).toUpper(),
+                {},
+                QDateTime::currentDateTimeUtc(),
+                updated,
+                {},
+                {},
+                {},
+                0};
+}
+
+void TokenPoolTest::initTestCase()
+{
+    // not started yet
+    QVERIFY(TokenPool::take(createForm(QUuid::createUuid().toString(QUuid::Id128), {})).isEmpty());
+
+    TokenPool::start(4);
+}
+
+void TokenPoolTest::cleanupTestCase()
+{
+    TokenPool::stop();
+}
+
+void TokenPoolTest::testNullForm()
+{
+    QVERIFY(TokenPool::take(Form{}).isEmpty());
+}
+
+void TokenPoolTest::testTake()
+{
+    const Form f = createForm(QUuid::createUuid().toString(QUuid::Id128), QDateTime::currentDateTimeUtc());
+
+    // the first call only registers the form
+    QVERIFY(TokenPool::take(f).isEmpty());
+    QTest::qWait(250);
+
+    QSet<QByteArray> tokens;
+    for (int i = 0; i < 4; ++i) {
+        const QDateTime before = QDateTime::currentDateTimeUtc();
+        const QByteArray token = TokenPool::take(f);
+        QVERIFY(!token.isEmpty());
+
+        // never earlier than the time the token has been handed out
+        const QDateTime time = f.decrypt(token);
+        QVERIFY(time.isValid());
+        QVERIFY(time > before);
+
+        tokens << token;
+    }
+
+    // every token is handed out only once
+    QCOMPARE(tokens.size(), qsizetype{4});
+}
+
+void TokenPoolTest::testTakeAfterIdle()
+{
+    const Form f = createForm(QUuid::createUuid().toString(QUuid::Id128), QDateTime::currentDateTimeUtc());
+
+    QVERIFY(TokenPool::take(f).isEmpty());
+    QTRY_VERIFY(!TokenPool::take(f).isEmpty());
+
+    // longer than the lifetime of pooled tokens, they have to be replaced in the meantime
+    QTest::qWait(1'500);
+
+    const QDateTime before = QDateTime::currentDateTimeUtc();
+    const QByteArray token = TokenPool::take(f);
+    QVERIFY(!token.isEmpty());
+    QVERIFY(f.decrypt(token) > before);
+}
+
+void TokenPoolTest::testUpdatedForm()
+{
+    const QString uuid      = QUuid::createUuid().toString(QUuid::Id128);
+    const QDateTime created = QDateTime::currentDateTimeUtc().addSecs(-60);
+    const Form f            = createForm(uuid, created);
+
+    QVERIFY(TokenPool::take(f).isEmpty());
+    QTRY_VERIFY(!TokenPool::take(f).isEmpty());
+
+    // tokens of the old form are dropped, they would have been created with the old secret
+    const Form updated = createForm(uuid, created.addSecs(30));
+    QVERIFY(TokenPool::take(updated).isEmpty());
+
+    QByteArray token;
+    QTRY_VERIFY(!(token = TokenPool::take(updated)).isEmpty());
+    QVERIFY(updated.decrypt(token).isValid());
+    QVERIFY(!f.decrypt(token).isValid());
+}
+
+QTEST_MAIN(TokenPoolTest)
+
+#include "testtokenpool.moc"
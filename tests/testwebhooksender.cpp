@@ -0,0 +1,332 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2024 Matthias Fehring <https://www.huessenbergnetz.de>
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "delivery/webhooksender.h"
+#include "objects/form.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QUuid>
+
+using namespace Qt::Literals::StringLiterals;
+
+/*!
+ * \brief Minimal HTTP/1.1 server that records POST requests and keeps connections open.
+ */
+class WebhookStub final : public QObject
+{
+    Q_OBJECT
+public:
+    struct Request {
+        QByteArray requestLine;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+    };
+
+    explicit WebhookStub(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, &WebhookStub::onNewConnection);
+    }
+
+    bool start() { return m_server.listen(QHostAddress::LocalHost); }
+
+    [[nodiscard]] QUrl url() const { return QUrl{u"http://127.0.0.1:%1/hook"_s.arg(m_server.serverPort())}; }
+
+    void clear()
+    {
+        requests.clear();
+        connections = 0;
+        status      = 200;
+    }
+
+    QList<Request> requests;
+    int connections{0};
+    int status{200};
+
+private:
+    void onNewConnection()
+    {
+        while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+            ++connections;
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    }
+
+    void onReadyRead(QTcpSocket *socket)
+    {
+        QByteArray &buffer = m_buffers[socket];
+        buffer += socket->readAll();
+
+        for (;;) {
+            const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                return;
+            }
+
+            Request request;
+            const QByteArrayList lines = buffer.left(headerEnd).split('\n');
+            request.requestLine        = lines.first().trimmed();
+            for (qsizetype i = 1; i < lines.size(); ++i) {
+                const qsizetype colon = lines.at(i).indexOf(':');
+                request.headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+            }
+
+            const qsizetype length = request.headers.value("content-length"_ba).toLongLong();
+            if (buffer.size() < headerEnd + 4 + length) {
+                return;
+            }
+
+            request.body = buffer.mid(headerEnd + 4, length);
+            buffer.remove(0, headerEnd + 4 + length);
+            requests << request;
+
+            socket->write("HTTP/1.1 "_ba + QByteArray::number(status) + " Stub\r\nContent-Length: 0\r\n\r\n"_ba);
+        }
+    }
+
+    QTcpServer m_server;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+};
+
+class WebhookSenderTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WebhookSenderTest(QObject *parent = nullptr)
+        : QObject{parent}
+    {
+    }
+    ~WebhookSenderTest() override = default;
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void testPayload();
+    void testPost();
+    void testKeepAlive();
+    void testErrorStatus();
+    void testInvalidUrl();
+    void testAllowedUrl_data();
+    void testAllowedUrl();
+    void testRestrictedTarget();
+
+private:
+    [[nodiscard]] static QList<Submission> createSubmissions(const Form &form, int count);
+    [[nodiscard]] WebhookSender::Config config() const;
+
+    WebhookStub m_stub;
+    Form m_form;
+};
+
+void WebhookSenderTest::initTestCase()
+{
+    QVERIFY(m_stub.start());
+
+    m_form = Form{1,
+                  u"Testform"_s,
+                  u"www.example.com"_s,
+                  {},
+                  QUuid::createUuid().toString(QUuid::Id128),
+                  {},
+                  {},
+                  QDateTime::currentDateTimeUtc(),
+                  {},
+                  {},
+                  {},
+                  {},
+                  0};
+}
+
+void WebhookSenderTest::init()
+{
+    m_stub.clear();
+}
+
+QList<Submission> WebhookSenderTest::createSubmissions(const Form &form, int count)
+{
+    QList<Submission> submissions;
+    for (int i = 0; i < count; ++i) {
+        submissions.emplace_back(static_cast<Submission::dbid_t>(i + 1),
+                                 form,
+                                 QVariantMap{{u"name"_s, u"Sender %1"_s.arg(i)},
+                                             {u"email"_s, u"sender%1@example.net"_s.arg(i)},
+                                             {u"content"_s, u"Hello"_s}},
+                                 u"127.0.0.1"_s,
+                                 QDateTime::currentDateTimeUtc());
+    }
+    return submissions;
+}
+
+WebhookSender::Config WebhookSenderTest::config() const
+{
+    WebhookSender::Config c;
+    c.url       = m_stub.url();
+    c.token     = u"secret"_s;
+    c.batchSize = 10;
+    return c;
+}
+
+void WebhookSenderTest::testPayload()
+{
+    const QByteArray payload = WebhookSender::payload(m_form, createSubmissions(m_form, 2));
+
+    const QJsonObject root = QJsonDocument::fromJson(payload).object();
+    QCOMPARE(root.value(u"form"_s).toObject().value(u"uuid"_s).toString(), m_form.uuid());
+    QCOMPARE(root.value(u"form"_s).toObject().value(u"name"_s).toString(), u"Testform"_s);
+
+    const QJsonArray submissions = root.value(u"submissions"_s).toArray();
+    QCOMPARE(submissions.size(), qsizetype{2});
+    QCOMPARE(submissions.at(0).toObject().value(u"id"_s).toInt(), 1);
+    QCOMPARE(submissions.at(1).toObject().value(u"email"_s).toString(), u"sender1@example.net"_s);
+    QVERIFY(submissions.at(0).toObject().contains(u"created"_s));
+}
+
+void WebhookSenderTest::testPost()
+{
+    WebhookSender sender;
+    sender.setRestrictTargets(false);
+
+    bool finished = false;
+    QString error;
+    sender.post(m_form, config(), createSubmissions(m_form, 3), [&finished, &error](const QString &e) {
+        finished = true;
+        error    = e;
+    });
+    QCOMPARE(sender.pending(), qsizetype{1});
+
+    QTRY_VERIFY(finished);
+    QVERIFY2(error.isEmpty(), qUtf8Printable(error));
+    QCOMPARE(sender.pending(), qsizetype{0});
+
+    QCOMPARE(m_stub.requests.size(), qsizetype{1});
+    const auto &request = m_stub.requests.constFirst();
+    QVERIFY(request.requestLine.startsWith("POST /hook "_ba));
+    QCOMPARE(request.headers.value("content-type"_ba), "application/json"_ba);
+    QCOMPARE(request.headers.value("authorization"_ba), "Bearer secret"_ba);
+    QCOMPARE(QJsonDocument::fromJson(request.body).object().value(u"submissions"_s).toArray().size(), qsizetype{3});
+}
+
+void WebhookSenderTest::testKeepAlive()
+{
+    WebhookSender sender;
+    sender.setRestrictTargets(false);
+
+    for (int i = 0; i < 3; ++i) {
+        bool finished = false;
+        QString error;
+        sender.post(m_form, config(), createSubmissions(m_form, 1), [&finished, &error](const QString &e) {
+            finished = true;
+            error    = e;
+        });
+        QTRY_VERIFY(finished);
+        QVERIFY2(error.isEmpty(), qUtf8Printable(error));
+    }
+
+    QCOMPARE(m_stub.requests.size(), qsizetype{3});
+    // all requests reuse the first connection
+    QCOMPARE(m_stub.connections, 1);
+}
+
+void WebhookSenderTest::testErrorStatus()
+{
+    m_stub.status = 500;
+
+    WebhookSender sender;
+    sender.setRestrictTargets(false);
+
+    bool finished = false;
+    QString error;
+    sender.post(m_form, config(), createSubmissions(m_form, 1), [&finished, &error](const QString &e) {
+        finished = true;
+        error    = e;
+    });
+
+    QTRY_VERIFY(finished);
+    QVERIFY(error.contains("500"_L1));
+}
+
+void WebhookSenderTest::testInvalidUrl()
+{
+    WebhookSender sender;
+    sender.setRestrictTargets(false);
+
+    auto c = config();
+    c.url  = QUrl{u"/relative"_s};
+
+    bool finished = false;
+    QString error;
+    sender.post(m_form, c, createSubmissions(m_form, 1), [&finished, &error](const QString &e) {
+        finished = true;
+        error    = e;
+    });
+
+    // invalid configurations fail without a request
+    QVERIFY(finished);
+    QVERIFY(!error.isEmpty());
+    QVERIFY(m_stub.requests.empty());
+}
+
+void WebhookSenderTest::testAllowedUrl_data()
+{
+    QTest::addColumn<QString>("url");
+    QTest::addColumn<bool>("allowed");
+
+    QTest::newRow("https") << u"https://hooks.example.net/hook"_s << true;
+    QTest::newRow("public-ipv4") << u"https://93.184.216.34/hook"_s << true;
+    QTest::newRow("public-ipv6") << u"https://[2606:2800:220:1::1]/hook"_s << true;
+    QTest::newRow("http") << u"http://hooks.example.net/hook"_s << false;
+    QTest::newRow("ftp") << u"ftp://hooks.example.net/hook"_s << false;
+    QTest::newRow("localhost") << u"https://localhost/hook"_s << false;
+    QTest::newRow("sub-localhost") << u"https://api.localhost/hook"_s << false;
+    QTest::newRow("mdns") << u"https://printer.local/hook"_s << false;
+    QTest::newRow("single-label") << u"https://intranet/hook"_s << false;
+    QTest::newRow("loopback") << u"https://127.0.0.1/hook"_s << false;
+    QTest::newRow("loopback-ipv6") << u"https://[::1]/hook"_s << false;
+    QTest::newRow("unspecified") << u"https://0.0.0.0/hook"_s << false;
+    QTest::newRow("private-10") << u"https://10.1.2.3/hook"_s << false;
+    QTest::newRow("private-172") << u"https://172.20.0.1/hook"_s << false;
+    QTest::newRow("private-192") << u"https://192.168.1.1/hook"_s << false;
+    QTest::newRow("cgnat") << u"https://100.64.0.1/hook"_s << false;
+    QTest::newRow("link-local") << u"https://169.254.169.254/latest"_s << false;
+    QTest::newRow("link-local-ipv6") << u"https://[fe80::1]/hook"_s << false;
+    QTest::newRow("unique-local") << u"https://[fd00::1]/hook"_s << false;
+    QTest::newRow("mapped-loopback") << u"https://[::ffff:127.0.0.1]/hook"_s << false;
+}
+
+void WebhookSenderTest::testAllowedUrl()
+{
+    QFETCH(QString, url);
+    QFETCH(bool, allowed);
+
+    QCOMPARE(WebhookSender::isAllowedUrl(QUrl{url}), allowed);
+}
+
+void WebhookSenderTest::testRestrictedTarget()
+{
+    // the stub listens on a loopback address without https
+    WebhookSender sender;
+
+    bool finished = false;
+    QString error;
+    sender.post(m_form, config(), createSubmissions(m_form, 1), [&finished, &error](const QString &e) {
+        finished = true;
+        error    = e;
+    });
+
+    QVERIFY(finished);
+    QVERIFY(!error.isEmpty());
+    QVERIFY(m_stub.requests.empty());
+}
+
+QTEST_MAIN(WebhookSenderTest)
+
+#include "testwebhooksender.moc"